@@ -0,0 +1,458 @@
+///
+/// Headless benchmark which replays a demo file through every volume implementation
+/// Usage: Benchmark.exe <demo file> [-scene sphere|torus|noise|platform|<file.pvm>] [-size n]
+///                      [-volumes default,default_hashed,chunked,octree,octreerep,layered] [-format csv|json]
+///                      (Append _morton to default, default_hashed, octreerep or layered to use the Morton voxel layout)
+///                      (default_clustered builds the -recreation LODs by vertex clustering rather than simplification)
+///                      (default_vcache and chunked_vcache reorder their meshes for the vertex cache, reporting the ACMR before and after)
+///                      (default_packed and chunked_packed upload their meshes as packed vertices)
+///                      (layered_transition closes the gaps between its LODs with transition cells, rather than overriding edges, reporting any open or non-manifold edges in its layers)
+///                      (layered_view also selects its view mesh from a few cameras after the replay, reporting its triangles and open edges)
+///                      [-out file] [-repeat n] [-kernel scalar|sse|avx2] [-recreation]
+///
+#include "Common.h"
+#include "Logger.h"
+#include "DemoFile.h"
+#include "VoxelScenes.h"
+#include "MarchingCubesKernel.h"
+
+#include "DefaultVolume.h"
+#include "ChunkedVolume.h"
+#include "OctreeVolume.h"
+#include "OctreeRepVolume.h"
+#include "LayeredVolume.h"
+
+#include <algorithm>
+#include <fstream>
+#include <sstream>
+#include <chrono>
+#include <functional>
+
+using namespace std::chrono;
+
+
+/**
+* Settings which are passed through the command line
+*/
+struct BenchmarkSettings
+{
+	string demoFile = "DemoFile.bin";
+	string scene = "sphere";
+	uint32 size = 0;
+	std::vector<string> volumes{ "default", "chunked", "octree", "octreerep", "layered" };
+	string format = "csv";
+	string outFile = "";
+	uint32 repeat = 1;
+	bool recreation = false;
+	string kernel = "";
+};
+
+/**
+* Percentile summary for a set of timings (In microseconds)
+*/
+struct LatencyStats
+{
+	int64 p50 = 0;
+	int64 p95 = 0;
+	int64 p99 = 0;
+	int64 max = 0;
+};
+
+/**
+* The results of replaying a demo through a single volume
+*/
+struct BenchmarkResults
+{
+	string volume;
+	uint32 frames = 0;
+	uint64 deltas = 0;
+	int64 loadTime = 0;
+	int64 initialBuildTime = 0;
+	LatencyStats insert;
+	LatencyStats build;
+	LatencyStats total;
+	int64 replayTime = 0;
+	uint32 triangles = 0;
+	VertexCacheStats vertexCache;
+	uint32 viewTriangles = 0;
+	uint32 viewOpenEdges = 0;
+	uint32 layerOpenEdges = 0;
+	uint32 layerNonManifoldEdges = 0;
+};
+
+
+/**
+* Summarise these samples using nearest-rank percentiles
+* @param samples			All of the timings to summarise
+*/
+static LatencyStats CalculateStats(std::vector<int64> samples)
+{
+	LatencyStats stats;
+	if (samples.size() == 0)
+		return stats;
+
+	std::sort(samples.begin(), samples.end());
+	auto percentile = [&samples](const float& p) -> int64
+	{
+		const uint32 rank = (uint32)ceil(p * samples.size());
+		return samples[glm::clamp(rank, 1U, (uint32)samples.size()) - 1];
+	};
+
+	stats.p50 = percentile(0.50f);
+	stats.p95 = percentile(0.95f);
+	stats.p99 = percentile(0.99f);
+	stats.max = samples[samples.size() - 1];
+	return stats;
+}
+
+/**
+* Fill the volume with the requested starting scene
+* @param volume				The volume to fill
+* @param settings			The settings describing the scene
+* @returns If the scene was successfully built
+*/
+static bool BuildScene(IVoxelVolume* volume, const BenchmarkSettings& settings)
+{
+	if (settings.scene == "sphere")
+		VoxelScenes::BuildSphere(volume, settings.size != 0 ? settings.size : 16);
+	else if (settings.scene == "torus")
+		VoxelScenes::BuildTorus(volume, 20, 10);
+	else if (settings.scene == "noise")
+		VoxelScenes::BuildNoise(volume, settings.size != 0 ? settings.size : 129, 41513);
+	else if (settings.scene == "platform")
+		VoxelScenes::BuildPlatform(volume, settings.size != 0 ? settings.size : 64);
+	else
+		return volume->LoadFromPvmFile(settings.scene.c_str());
+
+	return true;
+}
+
+/**
+* Replay every frame through a single volume implementation
+* @param name				The name to report this volume as
+* @param frames				The frames to replay
+* @param settings			The settings for this benchmark
+* @param outResults			Where to store the results
+* @param setup				Optional callback to configure each volume before the scene is built
+* @param inspect			Optional callback to check each volume once the frames have been replayed
+* @returns If the replay was successful
+*/
+template<class VolumeType>
+static bool RunBenchmark(const string& name, std::vector<VoxelFrame> frames, const BenchmarkSettings& settings, BenchmarkResults& outResults, std::function<void(VolumeType*)> setup = nullptr, std::function<void(VolumeType*, BenchmarkResults&)> inspect = nullptr)
+{
+	outResults = BenchmarkResults();
+	outResults.volume = name;
+
+	std::vector<int64> insertTimes;
+	std::vector<int64> buildTimes;
+	std::vector<int64> totalTimes;
+
+	for (uint32 r = 0; r < settings.repeat; ++r)
+	{
+		VolumeType* volume = new VolumeType;
+		if (setup)
+			setup(volume);
+
+		int64 loadStart = duration_cast<microseconds>(high_resolution_clock::now().time_since_epoch()).count();
+		if (!BuildScene(volume, settings))
+		{
+			delete volume;
+			return false;
+		}
+		outResults.loadTime = duration_cast<microseconds>(high_resolution_clock::now().time_since_epoch()).count() - loadStart;
+
+		// Build initial mesh for the scene
+		outResults.initialBuildTime = volume->Rebuild(std::vector<VoxelDelta>(), nullptr).totalTime;
+
+		const uvec3 resolution = volume->GetResolution();
+		int64 replayStart = duration_cast<microseconds>(high_resolution_clock::now().time_since_epoch()).count();
+
+		for (VoxelFrame& frame : frames)
+		{
+			// Ignore any changes which don't fit into this scene
+			frame.deltas.erase(std::remove_if(frame.deltas.begin(), frame.deltas.end(), [&resolution](const VoxelDelta& delta)
+			{
+				return delta.coord.x >= resolution.x || delta.coord.y >= resolution.y || delta.coord.z >= resolution.z;
+			}), frame.deltas.end());
+
+			VoxelBuildResults results = volume->Rebuild(frame.deltas, settings.recreation ? &frame.results : nullptr);
+
+			insertTimes.push_back(results.insertTime);
+			buildTimes.push_back(results.totalTime - results.insertTime);
+			totalTimes.push_back(results.totalTime);
+
+			outResults.frames++;
+			outResults.deltas += frame.deltas.size();
+
+			// Take the most detailed LOD as the triangle count
+			uint32 triangles = 0;
+			for (const uint32& count : results.tricount)
+				triangles = glm::max(triangles, count / 3);
+			outResults.triangles = triangles;
+
+			if (results.vertexCache.triangleCount != 0)
+				outResults.vertexCache = results.vertexCache;
+		}
+
+		outResults.replayTime += duration_cast<microseconds>(high_resolution_clock::now().time_since_epoch()).count() - replayStart;
+
+		if (inspect)
+			inspect(volume, outResults);
+		delete volume;
+	}
+
+	outResults.insert = CalculateStats(insertTimes);
+	outResults.build = CalculateStats(buildTimes);
+	outResults.total = CalculateStats(totalTimes);
+	return true;
+}
+
+/**
+* Select the view mesh from a few cameras, checking the mixed resolutions are stitched together
+* @param volume				The volume which has just been replayed
+* @param results			Where to store the view mesh's stats
+*/
+static void InspectViewMesh(LayeredVolume* volume, BenchmarkResults& results)
+{
+	// Only allow half of the finest layer's triangles, so the selection has to mix resolutions
+	volume->SetViewTriangleBudget(glm::max(1U, results.triangles / 2));
+
+	const vec3 centre = vec3(volume->GetResolution()) * 0.5f;
+	const float size = glm::max(centre.x, glm::max(centre.y, centre.z)) * 2.0f;
+	const vec3 directions[] = { vec3(1.0f, 0.5f, 1.0f), vec3(-1.0f, 1.0f, 0.25f), vec3(0.0f, -1.0f, -1.0f) };
+	const float distances[] = { 0.75f, 2.0f, 8.0f };
+
+	results.viewTriangles = 0;
+	results.viewOpenEdges = 0;
+	for (const vec3& direction : directions)
+		for (const float& distance : distances)
+		{
+			volume->UpdateViewMesh(centre + glm::normalize(direction) * distance * size, 70.0f, 1080.0f);
+			results.viewTriangles = glm::max(results.viewTriangles, volume->GetViewTriangleCount());
+			results.viewOpenEdges = glm::max(results.viewOpenEdges, volume->CountViewOpenEdges());
+		}
+
+	if (results.viewOpenEdges != 0)
+		LOG_ERROR("'%s' view mesh has %i open edges", results.volume.c_str(), results.viewOpenEdges);
+}
+
+/**
+* Check the transition cells have stitched each layer's mesh together
+* @param volume				The volume which has just been replayed
+* @param results			Where to store the layers' edge counts
+*/
+static void InspectLayerSeams(LayeredVolume* volume, BenchmarkResults& results)
+{
+	volume->CountLayerSeams(results.layerOpenEdges, results.layerNonManifoldEdges);
+
+	if (results.layerOpenEdges != 0 || results.layerNonManifoldEdges != 0)
+		LOG_ERROR("'%s' layer meshes have %i open and %i non-manifold edges", results.volume.c_str(), results.layerOpenEdges, results.layerNonManifoldEdges);
+}
+
+/**
+* Format all of the results as CSV
+* @param results			The results to format
+*/
+static string FormatCSV(const std::vector<BenchmarkResults>& results)
+{
+	std::stringstream stream;
+	stream << "volume,frames,deltas,load_us,initial_build_us,"
+		<< "insert_p50_us,insert_p95_us,insert_p99_us,insert_max_us,"
+		<< "build_p50_us,build_p95_us,build_p99_us,build_max_us,"
+		<< "total_p50_us,total_p95_us,total_p99_us,total_max_us,"
+		<< "replay_us,triangles,frames_per_sec,deltas_per_sec,acmr_before,acmr_after,view_triangles,view_open_edges,layer_open_edges,layer_nonmanifold_edges\n";
+
+	for (const BenchmarkResults& r : results)
+	{
+		const double seconds = r.replayTime / 1000000.0;
+		stream << r.volume << ',' << r.frames << ',' << r.deltas << ',' << r.loadTime << ',' << r.initialBuildTime << ','
+			<< r.insert.p50 << ',' << r.insert.p95 << ',' << r.insert.p99 << ',' << r.insert.max << ','
+			<< r.build.p50 << ',' << r.build.p95 << ',' << r.build.p99 << ',' << r.build.max << ','
+			<< r.total.p50 << ',' << r.total.p95 << ',' << r.total.p99 << ',' << r.total.max << ','
+			<< r.replayTime << ',' << r.triangles << ','
+			<< (seconds > 0.0 ? r.frames / seconds : 0.0) << ',' << (seconds > 0.0 ? r.deltas / seconds : 0.0) << ','
+			<< r.vertexCache.acmrBefore << ',' << r.vertexCache.acmrAfter << ','
+			<< r.viewTriangles << ',' << r.viewOpenEdges << ','
+			<< r.layerOpenEdges << ',' << r.layerNonManifoldEdges << '\n';
+	}
+
+	return stream.str();
+}
+
+/**
+* Format all of the results as JSON
+* @param results			The results to format
+*/
+static string FormatJSON(const std::vector<BenchmarkResults>& results)
+{
+	auto formatStats = [](const LatencyStats& stats) -> string
+	{
+		std::stringstream stream;
+		stream << "{ \"p50\": " << stats.p50 << ", \"p95\": " << stats.p95 << ", \"p99\": " << stats.p99 << ", \"max\": " << stats.max << " }";
+		return stream.str();
+	};
+
+	std::stringstream stream;
+	stream << "[\n";
+
+	for (uint32 i = 0; i < results.size(); ++i)
+	{
+		const BenchmarkResults& r = results[i];
+		const double seconds = r.replayTime / 1000000.0;
+
+		stream << "\t{\n"
+			<< "\t\t\"volume\": \"" << r.volume << "\",\n"
+			<< "\t\t\"frames\": " << r.frames << ",\n"
+			<< "\t\t\"deltas\": " << r.deltas << ",\n"
+			<< "\t\t\"load_us\": " << r.loadTime << ",\n"
+			<< "\t\t\"initial_build_us\": " << r.initialBuildTime << ",\n"
+			<< "\t\t\"insert_us\": " << formatStats(r.insert) << ",\n"
+			<< "\t\t\"build_us\": " << formatStats(r.build) << ",\n"
+			<< "\t\t\"total_us\": " << formatStats(r.total) << ",\n"
+			<< "\t\t\"replay_us\": " << r.replayTime << ",\n"
+			<< "\t\t\"triangles\": " << r.triangles << ",\n"
+			<< "\t\t\"frames_per_sec\": " << (seconds > 0.0 ? r.frames / seconds : 0.0) << ",\n"
+			<< "\t\t\"deltas_per_sec\": " << (seconds > 0.0 ? r.deltas / seconds : 0.0) << ",\n"
+			<< "\t\t\"acmr_before\": " << r.vertexCache.acmrBefore << ",\n"
+			<< "\t\t\"acmr_after\": " << r.vertexCache.acmrAfter << ",\n"
+			<< "\t\t\"view_triangles\": " << r.viewTriangles << ",\n"
+			<< "\t\t\"view_open_edges\": " << r.viewOpenEdges << ",\n"
+			<< "\t\t\"layer_open_edges\": " << r.layerOpenEdges << ",\n"
+			<< "\t\t\"layer_nonmanifold_edges\": " << r.layerNonManifoldEdges << "\n"
+			<< "\t}" << (i + 1 < results.size() ? "," : "") << "\n";
+	}
+
+	stream << "]\n";
+	return stream.str();
+}
+
+
+int main(int argc, char** argv)
+{
+	BenchmarkSettings settings;
+
+	// Parse command line
+	for (int i = 1; i < argc; ++i)
+	{
+		const string arg = argv[i];
+		const bool hasValue = (i + 1 < argc);
+
+		if (arg == "-scene" && hasValue)
+			settings.scene = argv[++i];
+		else if (arg == "-size" && hasValue)
+			settings.size = atoi(argv[++i]);
+		else if (arg == "-format" && hasValue)
+			settings.format = argv[++i];
+		else if (arg == "-out" && hasValue)
+			settings.outFile = argv[++i];
+		else if (arg == "-repeat" && hasValue)
+			settings.repeat = glm::max(1, atoi(argv[++i]));
+		else if (arg == "-kernel" && hasValue)
+			settings.kernel = argv[++i];
+		else if (arg == "-recreation")
+			settings.recreation = true;
+		else if (arg == "-volumes" && hasValue)
+		{
+			settings.volumes.clear();
+			std::stringstream list(argv[++i]);
+			string name;
+			while (std::getline(list, name, ','))
+				settings.volumes.push_back(name);
+		}
+		else if (arg[0] != '-')
+			settings.demoFile = arg;
+		else
+		{
+			LOG_ERROR("Unknown argument '%s'", arg.c_str());
+			return 1;
+		}
+	}
+
+	if (settings.outFile.empty())
+		settings.outFile = "BenchmarkResults." + settings.format;
+
+	if (settings.kernel == "scalar")
+		MC::SetKernelInstructionSet(MC::KernelInstructionSet::Scalar);
+	else if (settings.kernel == "sse")
+		MC::SetKernelInstructionSet(MC::KernelInstructionSet::SSE);
+	else if (settings.kernel == "avx2")
+		MC::SetKernelInstructionSet(MC::KernelInstructionSet::AVX2);
+	LOG("Using %s MC kernel", MC::GetKernelInstructionSetName(MC::GetKernelInstructionSet()));
+
+
+	// Load demo
+	std::vector<VoxelFrame> frames;
+	if (!DemoFile::ReadFrames(settings.demoFile, frames))
+		return 1;
+	LOG("Read %i frames from '%s'", (uint32)frames.size(), settings.demoFile.c_str());
+
+
+	// Replay through each volume
+	std::vector<BenchmarkResults> results;
+	for (const string& name : settings.volumes)
+	{
+		LOG("Benchmarking '%s'", name.c_str());
+		BenchmarkResults result;
+		bool success = false;
+
+		if (name == "default")
+			success = RunBenchmark<DefaultVolume>(name, frames, settings, result);
+		else if (name == "default_hashed")
+			success = RunBenchmark<DefaultVolume>(name, frames, settings, result, [](DefaultVolume* volume) { volume->SetUseSliceCache(false); });
+		else if (name == "default_morton")
+			success = RunBenchmark<DefaultVolume>(name, frames, settings, result, [](DefaultVolume* volume) { volume->SetLayout(VoxelLayout::Morton); });
+		else if (name == "default_hashed_morton")
+			success = RunBenchmark<DefaultVolume>(name, frames, settings, result, [](DefaultVolume* volume) { volume->SetUseSliceCache(false); volume->SetLayout(VoxelLayout::Morton); });
+		else if (name == "default_clustered")
+			success = RunBenchmark<DefaultVolume>(name, frames, settings, result, [](DefaultVolume* volume) { volume->SetUseClusteredLods(true); });
+		else if (name == "default_vcache")
+			success = RunBenchmark<DefaultVolume>(name, frames, settings, result, [](DefaultVolume* volume) { volume->SetOptimiseVertexCache(true); });
+		else if (name == "default_packed")
+			success = RunBenchmark<DefaultVolume>(name, frames, settings, result, [](DefaultVolume* volume) { volume->SetUsePackedVertices(true); });
+		else if (name == "chunked")
+			success = RunBenchmark<ChunkedVolume>(name, frames, settings, result);
+		else if (name == "chunked_vcache")
+			success = RunBenchmark<ChunkedVolume>(name, frames, settings, result, [](ChunkedVolume* volume) { volume->SetOptimiseVertexCache(true); });
+		else if (name == "chunked_packed")
+			success = RunBenchmark<ChunkedVolume>(name, frames, settings, result, [](ChunkedVolume* volume) { volume->SetUsePackedVertices(true); });
+		else if (name == "octree")
+			success = RunBenchmark<OctreeVolume>(name, frames, settings, result);
+		else if (name == "octreerep")
+			success = RunBenchmark<OctreeRepVolume>(name, frames, settings, result);
+		else if (name == "octreerep_morton")
+			success = RunBenchmark<OctreeRepVolume>(name, frames, settings, result, [](OctreeRepVolume* volume) { volume->SetLayout(VoxelLayout::Morton); });
+		else if (name == "layered")
+			success = RunBenchmark<LayeredVolume>(name, frames, settings, result);
+		else if (name == "layered_morton")
+			success = RunBenchmark<LayeredVolume>(name, frames, settings, result, [](LayeredVolume* volume) { volume->SetLayout(VoxelLayout::Morton); });
+		else if (name == "layered_transition")
+			success = RunBenchmark<LayeredVolume>(name, frames, settings, result, [](LayeredVolume* volume) { volume->SetSeamMode(LayeredSeamMode::TransitionCells); }, InspectLayerSeams);
+		else if (name == "layered_view")
+			success = RunBenchmark<LayeredVolume>(name, frames, settings, result, nullptr, InspectViewMesh);
+		else
+			LOG_WARNING("Unknown volume '%s'", name.c_str());
+
+		if (success)
+			results.push_back(result);
+	}
+
+
+	// Output results
+	std::ofstream file(settings.outFile);
+	if (!file.good())
+	{
+		LOG_ERROR("Failed to open '%s' for writing", settings.outFile.c_str());
+		return 1;
+	}
+
+	file << (settings.format == "json" ? FormatJSON(results) : FormatCSV(results));
+	file.close();
+
+	LOG("Results written to '%s'", settings.outFile.c_str());
+
+	// Open edges in a view mesh or transition layer show up as cracks, so fail the run
+	for (const BenchmarkResults& result : results)
+		if (result.viewOpenEdges != 0 || result.layerOpenEdges != 0 || result.layerNonManifoldEdges != 0)
+			return 1;
+	return 0;
+}
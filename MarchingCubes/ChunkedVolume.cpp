@@ -3,7 +3,10 @@
 #include "Logger.h"
 
 #include <unordered_map>
+#include <algorithm>
 #include "MarchingCubes.h"
+#include "MarchingCubesKernel.h"
+#include "ThreadPool.h"
 
 
 VoxelChunk::VoxelChunk(const uvec3& offset, uint32 resolution, class ChunkedVolume* parent)
@@ -11,113 +14,254 @@ VoxelChunk::VoxelChunk(const uvec3& offset, uint32 resolution, class ChunkedVolu
 	m_offset = offset;
 	m_resolution = resolution;
 	m_parent = parent;
+	bRequiresRebuild = false;
 
-	mesh = new Mesh;
-	mesh->MarkDynamic();
+	RecalculateSummary();
 }
 VoxelChunk::~VoxelChunk() 
 {
 	if (mesh != nullptr)
 		delete mesh;
+	if (m_voxels != nullptr)
+		delete[] m_voxels;
 }
 
+void VoxelChunk::ReleaseMesh()
+{
+	if (mesh != nullptr)
+	{
+		delete mesh;
+		mesh = nullptr;
+	}
+}
 
-#define GLM_ENABLE_EXPERIMENTAL
-#include <gtx\vector_angle.hpp>
+void VoxelChunk::RecalculateSummary()
+{
+	uvec3 dims;
+	const VoxelSample* values = GatherValues(dims);
+	const uint32 count = dims.x * dims.y * dims.z;
 
+	m_minValue = DecodeVoxel(values[0]);
+	m_maxValue = m_minValue;
 
+	for (uint32 i = 1; i < count; ++i)
+	{
+		const float value = DecodeVoxel(values[i]);
+		m_minValue = glm::min(m_minValue, value);
+		m_maxValue = glm::max(m_maxValue, value);
+	}
+}
 
-/**
-* Interpolate between voxels to get more precise intersection
-* @param isoValue				The value being used currently by MC
-* @param a						The position of the first voxel
-* @param b						The position of the second voxel
-* @param aVal					The value at the first voxel
-* @param bVal					The value at the second voxel
-*/
-static vec3 VertexLerp(float isoLevel, const vec3& a, const vec3& b, float aVal, float bVal)
+const VoxelSample* VoxelChunk::GatherValues(uvec3& outDims) const
 {
-	const float closeValue = 0.00001f;
+	// Each worker gets its own buffer, so chunks don't have to hold onto one
+	static thread_local std::vector<VoxelSample> buffer;
 
-	if (glm::abs(isoLevel - aVal) < closeValue)
-		return a;
-	if (glm::abs(isoLevel - bVal) < closeValue)
-		return b;
-	if (glm::abs(aVal - bVal) < closeValue)
-		return a;
+	const uvec3 volumeRes = m_parent->GetResolution();
+	const uvec3 end = glm::min(m_offset + uvec3(m_resolution, m_resolution, m_resolution), volumeRes - uvec3(1, 1, 1));
+	outDims = end - m_offset + uvec3(1, 1, 1);
 
-	float mu = (isoLevel - aVal) / (bVal - aVal);
-	return a + mu * (b - a);
+	buffer.resize(outDims.x * outDims.y * outDims.z);
+	m_parent->GatherBlock(m_offset, outDims, buffer.data());
+	return buffer.data();
 }
 
-void VoxelChunk::BuildMesh()
+bool VoxelChunk::SetVoxel(const uint32& x, const uint32& y, const uint32& z, const VoxelSample& sample)
+{
+	if (m_voxels == nullptr)
+	{
+		if (sample == m_uniformValue)
+			return false;
+
+		// No longer uniform, so every voxel needs storing
+		const uint32 count = m_resolution * m_resolution * m_resolution;
+		m_voxels = new VoxelSample[count];
+		std::fill(m_voxels, m_voxels + count, m_uniformValue);
+	}
+
+	VoxelSample& voxel = m_voxels[x + m_resolution * (y + m_resolution * z)];
+	if (voxel == sample)
+		return false;
+
+	voxel = sample;
+	return true;
+}
+
+void VoxelChunk::CopyRow(const uint32& y, const uint32& z, const uint32& count, VoxelSample* out) const
+{
+	if (m_voxels == nullptr)
+		std::fill(out, out + count, m_uniformValue);
+	else
+		std::copy(m_voxels + m_resolution * (y + m_resolution * z), m_voxels + m_resolution * (y + m_resolution * z) + count, out);
+}
+
+bool VoxelChunk::AttemptCompact()
+{
+	if (m_voxels == nullptr)
+		return true;
+
+	// Only check voxels inside of the volume, as the rest are never read
+	const uvec3 end = glm::min(m_offset + uvec3(m_resolution, m_resolution, m_resolution), m_parent->GetResolution()) - m_offset;
+	const VoxelSample value = m_voxels[0];
+
+	for (uint32 z = 0; z < end.z; ++z)
+		for (uint32 y = 0; y < end.y; ++y)
+		{
+			const VoxelSample* row = m_voxels + m_resolution * (y + m_resolution * z);
+			for (uint32 x = 0; x < end.x; ++x)
+				if (row[x] != value)
+					return false;
+		}
+
+	delete[] m_voxels;
+	m_voxels = nullptr;
+	m_uniformValue = value;
+	return true;
+}
+
+
+#define GLM_ENABLE_EXPERIMENTAL
+#include <gtx\vector_angle.hpp>
+
+
+
+void VoxelChunk::BuildMeshData()
 {
 	std::unordered_map<vec3, uint32, vec3_KeyFuncs> vertexIndexLookup;
 	vec3 edges[12];
 	const float isoLevel = m_parent->GetIsoLevel();
 
-	std::vector<vec3> vertices;
-	std::vector<vec3> normals;
-	std::vector<uint32> triangles;
+	std::vector<vec3>& vertices = m_vertices;
+	std::vector<vec3>& normals = m_normals;
+	std::vector<uint32>& triangles = m_triangles;
+	vertices.clear();
+	normals.clear();
+	triangles.clear();
+	m_vertexCacheStats = VertexCacheStats();
+	bRequiresRebuild = false;
+
+	// Edits may have left the summary loose, so tighten it before deciding whether there's anything to build
+	uvec3 dims;
+	const VoxelSample* values = GatherValues(dims);
+	const uint32 valueCount = dims.x * dims.y * dims.z;
+
+	m_minValue = DecodeVoxel(values[0]);
+	m_maxValue = m_minValue;
+	for (uint32 i = 1; i < valueCount; ++i)
+	{
+		const float value = DecodeVoxel(values[i]);
+		m_minValue = glm::min(m_minValue, value);
+		m_maxValue = glm::max(m_maxValue, value);
+	}
+
+	if (!CanContainSurface(isoLevel))
+		return;
+
+	// Only build cells which have all of their corners inside of the volume
+	const uvec3 cellEnd = m_offset + dims - uvec3(1, 1, 1);
+	const uint32 rowLength = dims.x - 1;
+	const uint32 rowsPerSlice = cellEnd.y - m_offset.y;
+	const uint32 rowCount = rowsPerSlice * (cellEnd.z - m_offset.z);
+	std::vector<uint8> cellCases(rowLength * rowCount);
+	std::vector<uint8> activeRows(rowCount, 0);
+	MC::EdgeBatch batch;
+
+	// Samples are compared and interpolated without decoding them
+	typedef VoxelSampleTraits<VoxelSample> Traits;
+	const float kernelIso = Traits::KernelIso(isoLevel);
+
+	// Rows of values surrounding the cells [y][z]
+	const VoxelSample* rows[2][2];
+	auto fetchRows = [&rows, values, &dims, this](const uint32& y, const uint32& z)
+	{
+		for (uint32 dy = 0; dy < 2; ++dy)
+			for (uint32 dz = 0; dz < 2; ++dz)
+				rows[dy][dz] = values + dims.x * ((y - m_offset.y + dy) + dims.y * (z - m_offset.z + dz));
+	};
+
+
+	// Classify every cell first, so the output can be reserved from the case tables before anything is built
+	uint32 triangleCount = 0;
+	uint32 maxRowEdges = 0;
+	for (uint32 z = m_offset.z; z < cellEnd.z; ++z)
+		for (uint32 y = m_offset.y; y < cellEnd.y; ++y)
+		{
+			const uint32 row = (y - m_offset.y) + rowsPerSlice * (z - m_offset.z);
+			uint8* rowCases = cellCases.data() + rowLength * row;
+
+			fetchRows(y, z);
+			if (Traits::ClassifyRow(rows[0][0], rows[0][1], rows[1][0], rows[1][1], rowLength, isoLevel, rowCases) == 0)
+				continue;
 
-	for (uint32 xi = 0; xi < m_resolution; ++xi)
-		for (uint32 yi = 0; yi < m_resolution; ++yi)
-			for (uint32 zi = 0; zi < m_resolution; ++zi)
+			activeRows[row] = 1;
+			uint32 rowEdges = 0;
+			for (uint32 xi = 0; xi < rowLength; ++xi)
 			{
-				uint32 x = m_offset.x + xi;
-				uint32 y = m_offset.y + yi;
-				uint32 z = m_offset.z + zi;
+				triangleCount += MC::CaseTriangleCount(rowCases[xi]);
+				rowEdges += MC::CaseVertexCount(rowCases[xi]);
+			}
+			maxRowEdges = glm::max(maxRowEdges, rowEdges);
+		}
+
+	if (triangleCount == 0)
+		return;
+
+	// Closed MC surfaces end up with roughly half as many vertices as triangles
+	triangles.reserve(triangleCount * 3);
+	vertices.reserve(triangleCount / 2 + 1);
+	vertexIndexLookup.reserve(triangleCount / 2 + 1);
+	batch.Reserve(maxRowEdges);
+
+
+	for (uint32 z = m_offset.z; z < cellEnd.z; ++z)
+		for (uint32 y = m_offset.y; y < cellEnd.y; ++y)
+		{
+			const uint32 row = (y - m_offset.y) + rowsPerSlice * (z - m_offset.z);
+			if (!activeRows[row])
+				continue;
+
+			const uint8* rowCases = cellCases.data() + rowLength * row;
+			fetchRows(y, z);
 
-				if (x >= m_parent->GetResolution().x - 1 || y >= m_parent->GetResolution().y - 1 || z >= m_parent->GetResolution().z - 1)
+
+			// Gather the edges for every cell which isn't fully inside/outside
+			batch.Clear();
+			for (uint32 xi = 0; xi < rowLength; ++xi)
+			{
+				const uint8 caseIndex = rowCases[xi];
+				if (caseIndex == 0 || caseIndex == 255)
 					continue;
 
-				// Encode case based on bit presence
-				uint8 caseIndex = 0;
-				if (m_parent->Get(x + 0, y + 0, z + 0) >= isoLevel) caseIndex |= 1;
-				if (m_parent->Get(x + 1, y + 0, z + 0) >= isoLevel) caseIndex |= 2;
-				if (m_parent->Get(x + 1, y + 0, z + 1) >= isoLevel) caseIndex |= 4;
-				if (m_parent->Get(x + 0, y + 0, z + 1) >= isoLevel) caseIndex |= 8;
-				if (m_parent->Get(x + 0, y + 1, z + 0) >= isoLevel) caseIndex |= 16;
-				if (m_parent->Get(x + 1, y + 1, z + 0) >= isoLevel) caseIndex |= 32;
-				if (m_parent->Get(x + 1, y + 1, z + 1) >= isoLevel) caseIndex |= 64;
-				if (m_parent->Get(x + 0, y + 1, z + 1) >= isoLevel) caseIndex |= 128;
+				for (uint32 e = 0; e < 12; ++e)
+					if (MC::CaseRequiredEdges[caseIndex] & (1 << e))
+					{
+						const uint8* start = MC::EdgeStart[e];
+						const uint8 axis = MC::EdgeAxis[e];
 
+						const float aVal = Traits::ToKernel(rows[start[1]][start[2]][xi + start[0]]);
+						const float bVal = Traits::ToKernel(rows[start[1] + (axis == 1 ? 1 : 0)][start[2] + (axis == 2 ? 1 : 0)][xi + start[0] + (axis == 0 ? 1 : 0)]);
+						batch.Push(vec3(m_offset.x + xi + start[0], y + start[1], z + start[2]), axis, aVal, bVal);
+					}
+			}
 
-				// Fully inside iso-surface
+			// Smooth edges based on density
+			MC::InterpolateEdges(batch, kernelIso);
+
+
+			// Add triangles for each cell
+			uint32 batchIndex = 0;
+			for (uint32 xi = 0; xi < rowLength; ++xi)
+			{
+				const uint8 caseIndex = rowCases[xi];
 				if (caseIndex == 0 || caseIndex == 255)
 					continue;
 
-				// Smooth edges based on density
-#define VERT_LERP(x0, y0, z0, x1, y1, z1) VertexLerp(isoLevel, vec3(x + x0,y + y0,z + z0), vec3(x + x1, y + y1, z + z1), m_parent->Get(x + x0, y + y0, z + z0), m_parent->Get(x + x1, y + y1, z + z1))
-
-				if (MC::CaseRequiredEdges[caseIndex] & 1)
-					edges[0] = VERT_LERP(0, 0, 0, 1, 0, 0);
-				if (MC::CaseRequiredEdges[caseIndex] & 2)
-					edges[1] = VERT_LERP(1, 0, 0, 1, 0, 1);
-				if (MC::CaseRequiredEdges[caseIndex] & 4)
-					edges[2] = VERT_LERP(0, 0, 1, 1, 0, 1);
-				if (MC::CaseRequiredEdges[caseIndex] & 8)
-					edges[3] = VERT_LERP(0, 0, 0, 0, 0, 1);
-				if (MC::CaseRequiredEdges[caseIndex] & 16)
-					edges[4] = VERT_LERP(0, 1, 0, 1, 1, 0);
-				if (MC::CaseRequiredEdges[caseIndex] & 32)
-					edges[5] = VERT_LERP(1, 1, 0, 1, 1, 1);
-				if (MC::CaseRequiredEdges[caseIndex] & 64)
-					edges[6] = VERT_LERP(0, 1, 1, 1, 1, 1);
-				if (MC::CaseRequiredEdges[caseIndex] & 128)
-					edges[7] = VERT_LERP(0, 1, 0, 0, 1, 1);
-				if (MC::CaseRequiredEdges[caseIndex] & 256)
-					edges[8] = VERT_LERP(0, 0, 0, 0, 1, 0);
-				if (MC::CaseRequiredEdges[caseIndex] & 512)
-					edges[9] = VERT_LERP(1, 0, 0, 1, 1, 0);
-				if (MC::CaseRequiredEdges[caseIndex] & 1024)
-					edges[10] = VERT_LERP(1, 0, 1, 1, 1, 1);
-				if (MC::CaseRequiredEdges[caseIndex] & 2048)
-					edges[11] = VERT_LERP(0, 0, 1, 0, 1, 1);
-
-
-				// Add triangles for this case
-				int8* caseEdges = MC::Cases[caseIndex];
+				for (uint32 e = 0; e < 12; ++e)
+					if (MC::CaseRequiredEdges[caseIndex] & (1 << e))
+						edges[e] = batch.GetVertex(batchIndex++);
+
+
+				const int8* caseEdges = MC::Cases[caseIndex];
 				while (*caseEdges != -1)
 				{
 					int8 edge = *(caseEdges++);
@@ -141,6 +285,7 @@ void VoxelChunk::BuildMesh()
 
 				}
 			}
+		}
 
 
 	// Make normals out of weighted triangles
@@ -173,11 +318,43 @@ void VoxelChunk::BuildMesh()
 	for (uint32 i = 0; i < vertices.size(); ++i)
 		normals.emplace_back(normalLookup[i]);
 
+	if (m_parent->IsOptimisingVertexCache())
+		m_vertexCacheStats = VertexCache::Optimise(vertices, normals, triangles);
 
-	mesh->SetVertices(vertices);
-	mesh->SetNormals(normals);
-	mesh->SetTriangles(triangles);
-	bRequiresRebuild = false;
+	// Pack here, rather than during the upload, so it's spread across the workers
+	if (m_parent->IsUsingPackedVertices())
+		VertexPacking::Pack(vertices, normals, triangles, vec3(m_offset), vec3(m_resolution, m_resolution, m_resolution), m_packed);
+}
+
+void VoxelChunk::UploadMesh()
+{
+	// Don't upload empty meshes
+	if (m_triangles.size() == 0)
+		ReleaseMesh();
+
+	else
+	{
+		if (mesh == nullptr)
+		{
+			mesh = new Mesh;
+			mesh->MarkDynamic();
+		}
+
+		if (m_parent->IsUsingPackedVertices())
+			mesh->SetPackedMesh(m_packed);
+		else
+		{
+			mesh->SetVertices(m_vertices);
+			mesh->SetNormals(m_normals);
+			mesh->SetTriangles(m_triangles);
+		}
+	}
+
+	// Data now lives on the GPU
+	std::vector<vec3>().swap(m_vertices);
+	std::vector<vec3>().swap(m_normals);
+	std::vector<uint32>().swap(m_triangles);
+	m_packed = PackedMeshData();
 }
 
 
@@ -192,8 +369,6 @@ ChunkedVolume::~ChunkedVolume()
 			delete chunk;
 	if (m_material != nullptr)
 		delete m_material;
-	if (m_data != nullptr)
-		delete[] m_data;
 }
 
 
@@ -202,85 +377,203 @@ ChunkedVolume::~ChunkedVolume()
 ///
 void ChunkedVolume::Init(const uvec3& resolution, const vec3& scale)
 {
-	m_data = new float[resolution.x * resolution.y * resolution.z]{ DEFAULT_VALUE };
+	// Voxels are stored by the chunks, so nothing needs allocating until they're set
 	m_resolution = resolution;
 	m_scale = scale;
 
 	// Ensure vector can hold all possilbe chunks
-	m_chunks.resize(
-		ceilf(resolution.x / (float)chunkSize) *
-		ceilf(resolution.y / (float)chunkSize) *
+	m_chunkCount = uvec3(
+		ceilf(resolution.x / (float)chunkSize),
+		ceilf(resolution.y / (float)chunkSize),
 		ceilf(resolution.z / (float)chunkSize)
 	);
+	m_chunks.resize(m_chunkCount.x * m_chunkCount.y * m_chunkCount.z);
 		
 	LOG("Initialized volume with %i potential chunks of size", m_chunks.size(), chunkSize);
 }
 
 void ChunkedVolume::Set(uint32 x, uint32 y, uint32 z, float value)
 {
-	m_data[GetVoxelIndex(x, y, z)] = value;
-	
-	// Make chunk if not made and flag for rebuild
-	const uint32 index = GetChunkIndex(x, y, z);
-	uvec3 coord = GetChunkCoords(x, y, z);
-	VoxelChunk* chunk = m_chunks[index];
+	const uvec3 coord = GetChunkCoords(x, y, z);
 
-	// Create chunk if not already there
+	// Missing chunks are already entirely the default value
+	const VoxelSample sample = EncodeVoxel(value);
+
+	VoxelChunk* chunk = GetChunk(coord);
 	if (chunk == nullptr)
 	{
-		chunk = new VoxelChunk(uvec3(coord.x * chunkSize, coord.y * chunkSize, coord.z * chunkSize), chunkSize, this);
-		m_chunks[index] = chunk;
+		if (sample == EncodeVoxel(DEFAULT_VALUE))
+			return;
+		chunk = FetchChunk(coord);
 	}
+
+	if (!chunk->SetVoxel(x % chunkSize, y % chunkSize, z % chunkSize, sample))
+		return;
+
+	// Summarise the value which was actually stored
+	value = DecodeVoxel(sample);
+	chunk->ExpandSummary(value);
 	chunk->bRequiresRebuild = true;
+	NotifyBorderChunks(x, y, z, coord, value);
+}
 
+void ChunkedVolume::NotifyBorderChunks(uint32 x, uint32 y, uint32 z, const uvec3& coord, float value)
+{
+	// Voxels on the lower edges of a chunk are also the border of the chunks before them
+	const uvec3 lower(
+		x % chunkSize == 0 && coord.x != 0 ? coord.x - 1 : coord.x,
+		y % chunkSize == 0 && coord.y != 0 ? coord.y - 1 : coord.y,
+		z % chunkSize == 0 && coord.z != 0 ? coord.z - 1 : coord.z
+	);
 
-	// Make adjacent chunks rebuild, if on border
-	uint32 xc = x % chunkSize;
-	if (xc == 0)
-	{
-		int i = GetChunkIndex(x - 1, y, z);
-		if (i >= 0 && i < m_chunks.size() && m_chunks[i] != nullptr)
-			m_chunks[i]->bRequiresRebuild = true;
-	}
-	else if (xc == chunkSize - 1)
-	{
-		int i = GetChunkIndex(x + 1, y, z);
-		if (i >= 0 && i < m_chunks.size() && m_chunks[i] != nullptr)
-			m_chunks[i]->bRequiresRebuild = true;
-	}
+	if (lower == coord)
+		return;
 
-	uint32 yc = y % chunkSize;
-	if (yc == 0)
-	{
-		int i = GetChunkIndex(x, y - 1, z);
-		if (i >= 0 && i < m_chunks.size() && m_chunks[i] != nullptr)
-			m_chunks[i]->bRequiresRebuild = true;
-	}
-	else if (yc == chunkSize - 1)
+	// Update summary and flag for rebuild in every chunk which uses this voxel
+	for (uint32 cz = lower.z; cz <= coord.z; ++cz)
+		for (uint32 cy = lower.y; cy <= coord.y; ++cy)
+			for (uint32 cx = lower.x; cx <= coord.x; ++cx)
+			{
+				const uvec3 neighbour(cx, cy, cz);
+				if (neighbour == coord)
+					continue;
+
+				VoxelChunk* chunk = FetchChunk(neighbour);
+				chunk->ExpandSummary(value);
+				chunk->bRequiresRebuild = true;
+			}
+}
+
+void ChunkedVolume::GatherBlock(const uvec3& offset, const uvec3& dims, VoxelSample* out) const
+{
+	const uvec3 coord = GetChunkCoords(offset.x, offset.y, offset.z);
+	const VoxelSample defaultSample = EncodeVoxel(DEFAULT_VALUE);
+	const uint32 rowCount = glm::min(dims.x, chunkSize);
+
+	for (uint32 z = 0; z < dims.z; ++z)
+		for (uint32 y = 0; y < dims.y; ++y)
+		{
+			// The last row/slice may have to be fetched from the next chunk
+			const uvec3 rowCoord(coord.x, coord.y + (y == chunkSize ? 1 : 0), coord.z + (z == chunkSize ? 1 : 0));
+			const uint32 ly = y % chunkSize;
+			const uint32 lz = z % chunkSize;
+			VoxelSample* row = out + dims.x * (y + dims.y * z);
+
+			VoxelChunk* chunk = GetChunk(rowCoord);
+			if (chunk == nullptr)
+				std::fill(row, row + rowCount, defaultSample);
+			else
+				chunk->CopyRow(ly, lz, rowCount, row);
+
+			if (dims.x > chunkSize)
+			{
+				VoxelChunk* next = GetChunk(uvec3(rowCoord.x + 1, rowCoord.y, rowCoord.z));
+				row[chunkSize] = next == nullptr ? defaultSample : next->GetVoxel(0, ly, lz);
+			}
+		}
+}
+
+uint64 ChunkedVolume::GetVoxelStorageSize() const
+{
+	uint64 size = 0;
+	for (VoxelChunk* chunk : m_chunks)
+		if (chunk != nullptr && !chunk->IsUniform())
+			size += chunkSize * chunkSize * chunkSize * sizeof(VoxelSample);
+	return size;
+}
+
+VoxelChunk* ChunkedVolume::FetchChunk(const uvec3& coord)
+{
+	const uint32 index = coord.x + m_chunkCount.x * (coord.y + m_chunkCount.y * coord.z);
+	VoxelChunk* chunk = m_chunks[index];
+
+	// Create chunk if not already there
+	if (chunk == nullptr)
 	{
-		int i = GetChunkIndex(x, y + 1, z);
-		if (i >= 0 && i < m_chunks.size() && m_chunks[i] != nullptr)
-			m_chunks[i]->bRequiresRebuild = true;
+		chunk = new VoxelChunk(coord * chunkSize, chunkSize, this);
+		m_chunks[index] = chunk;
 	}
 
-	uint32 zc = z % chunkSize;
-	if (zc == 0)
+	return chunk;
+}
+
+void ChunkedVolume::ApplyDeltas(const std::vector<VoxelDelta>& deltas)
+{
+	// Applying in order already lets the last change win and brush edits arrive in runs within the same chunk,
+	// so (Unlike the tree volumes) sorting the batch costs more than it saves here
+	// Each run only needs to fetch and flag its chunk once
+	VoxelChunk* current = nullptr;
+	uint32 currentIndex = 0;
+	bool bRunChanged = false;
+	float runMin = 0.0f;
+	float runMax = 0.0f;
+
+	const VoxelSample defaultSample = EncodeVoxel(DEFAULT_VALUE);
+
+	for (const VoxelDelta& delta : deltas)
 	{
-		int i = GetChunkIndex(x, y, z - 1);
-		if (i >= 0 && i < m_chunks.size() && m_chunks[i] != nullptr)
-			m_chunks[i]->bRequiresRebuild = true;
+		const uint32 x = delta.coord.x;
+		const uint32 y = delta.coord.y;
+		const uint32 z = delta.coord.z;
+		const VoxelSample sample = EncodeVoxel(delta.value);
+		const float value = DecodeVoxel(sample);
+
+		const uvec3 coord = GetChunkCoords(x, y, z);
+		const uint32 index = GetChunkIndex(x, y, z);
+
+		// Moved onto a different chunk, so flush the run
+		if (current == nullptr || index != currentIndex)
+		{
+			if (bRunChanged)
+			{
+				current->ExpandSummary(runMin);
+				current->ExpandSummary(runMax);
+				current->bRequiresRebuild = true;
+			}
+
+			current = GetChunk(coord);
+			currentIndex = index;
+			bRunChanged = false;
+
+			// Missing chunks are already entirely the default value
+			if (current == nullptr)
+			{
+				if (sample == defaultSample)
+					continue;
+				current = FetchChunk(coord);
+			}
+		}
+
+		if (!current->SetVoxel(x % chunkSize, y % chunkSize, z % chunkSize, sample))
+			continue;
+
+		if (!bRunChanged)
+		{
+			runMin = value;
+			runMax = value;
+			bRunChanged = true;
+		}
+		else
+		{
+			runMin = glm::min(runMin, value);
+			runMax = glm::max(runMax, value);
+		}
+
+		NotifyBorderChunks(x, y, z, coord, value);
 	}
-	else if (zc == chunkSize - 1)
+
+	if (bRunChanged)
 	{
-		int i = GetChunkIndex(x, y, z + 1);
-		if (i >= 0 && i < m_chunks.size() && m_chunks[i] != nullptr)
-			m_chunks[i]->bRequiresRebuild = true;
+		current->ExpandSummary(runMin);
+		current->ExpandSummary(runMax);
+		current->bRequiresRebuild = true;
 	}
 }
 
 float ChunkedVolume::Get(uint32 x, uint32 y, uint32 z)
 {
-	return m_data[GetVoxelIndex(x, y, z)];
+	VoxelChunk* chunk = GetChunk(GetChunkCoords(x, y, z));
+	return chunk == nullptr ? DEFAULT_VALUE : DecodeVoxel(chunk->GetVoxel(x % chunkSize, y % chunkSize, z % chunkSize));
 }
 
 
@@ -295,10 +588,45 @@ void ChunkedVolume::Begin()
 
 void ChunkedVolume::Update(const float& deltaTime)
 {
-	// Rebuild mesh if it needs it
+	// Find every chunk which needs rebuilding
+	m_dirtyChunks.clear();
 	for (VoxelChunk* chunk : m_chunks)
 		if (chunk != nullptr && chunk->bRequiresRebuild)
-			chunk->BuildMesh();
+		{
+			// Free the storage of any chunks which have gone back to a single value
+			chunk->AttemptCompact();
+
+			// Completely empty or solid, so there's nothing to build
+			if (!chunk->CanContainSurface(m_isoLevel))
+			{
+				chunk->ReleaseMesh();
+				chunk->bRequiresRebuild = false;
+				ReleaseChunkIfEmpty(chunk);
+			}
+			else
+				m_dirtyChunks.emplace_back(chunk);
+		}
+
+	// Mesh chunks on the workers, but upload from here, as this is the only thread with the GL context
+	ThreadPool::GetShared().ParallelFor(m_dirtyChunks.size(), [this](uint32 i) { m_dirtyChunks[i]->BuildMeshData(); });
+
+	for (VoxelChunk* chunk : m_dirtyChunks)
+	{
+		chunk->UploadMesh();
+		ReleaseChunkIfEmpty(chunk);
+	}
+	m_dirtyChunks.clear();
+}
+
+void ChunkedVolume::ReleaseChunkIfEmpty(VoxelChunk* chunk)
+{
+	// Missing chunks are treated as the default value, so there's no need to keep this one around
+	if (chunk->mesh != nullptr || !chunk->IsUniform() || chunk->GetUniformValue() != EncodeVoxel(DEFAULT_VALUE))
+		return;
+
+	const uvec3 offset = chunk->GetOffset();
+	m_chunks[GetChunkIndex(offset.x, offset.y, offset.z)] = nullptr;
+	delete chunk;
 }
 
 
@@ -309,7 +637,7 @@ void ChunkedVolume::Draw(const class Window* window, const float& deltaTime)
 
 	for (VoxelChunk* chunk : m_chunks) 
 	{
-		if (chunk != nullptr && chunk->mesh != nullptr)
+		if (chunk != nullptr && chunk->mesh != nullptr && chunk->CanContainSurface(m_isoLevel))
 		{
 			m_material->PrepareMesh(chunk->mesh);
 			m_material->RenderInstance(&t);
@@ -318,3 +646,57 @@ void ChunkedVolume::Draw(const class Window* window, const float& deltaTime)
 
 	m_material->Unbind(window, GetLevel());
 }
+
+#include <chrono>
+using namespace std::chrono;
+VoxelBuildResults ChunkedVolume::Rebuild(const std::vector<VoxelDelta>& deltas, VoxelBuildResults* recreation)
+{
+	// recreation ignored for ChunkedVolume
+	VoxelBuildResults results;
+
+	results.buildTime.resize(1);
+	results.tricount.resize(1);
+
+
+	int64 startTime = duration_cast<microseconds>(high_resolution_clock::now().time_since_epoch()).count();
+	int64 endTime;
+
+	// Insert values
+	ApplyDeltas(deltas);
+
+	endTime = duration_cast<microseconds>(high_resolution_clock::now().time_since_epoch()).count();
+	results.insertTime = endTime - startTime;
+
+
+	// Rebuild any chunks which have changed
+	int64 buildStartTime = duration_cast<microseconds>(high_resolution_clock::now().time_since_epoch()).count();
+	Update(0.0f);
+
+	endTime = duration_cast<microseconds>(high_resolution_clock::now().time_since_epoch()).count();
+	results.buildTime[0] = endTime - buildStartTime;
+
+	results.tricount[0] = 0;
+	for (VoxelChunk* chunk : m_chunks)
+		if (chunk != nullptr && chunk->mesh != nullptr)
+		{
+			results.tricount[0] += chunk->mesh->GetDrawCount();
+
+			// Weight each chunk's miss ratio by its triangles, so the total is for the whole surface
+			const VertexCacheStats& stats = chunk->GetVertexCacheStats();
+			results.vertexCache.acmrBefore += stats.acmrBefore * stats.triangleCount;
+			results.vertexCache.acmrAfter += stats.acmrAfter * stats.triangleCount;
+			results.vertexCache.triangleCount += stats.triangleCount;
+		}
+
+	if (results.vertexCache.triangleCount != 0)
+	{
+		results.vertexCache.acmrBefore /= results.vertexCache.triangleCount;
+		results.vertexCache.acmrAfter /= results.vertexCache.triangleCount;
+	}
+
+
+	// Total time
+	endTime = duration_cast<microseconds>(high_resolution_clock::now().time_since_epoch()).count();
+	results.totalTime = endTime - startTime;
+	return results;
+}
@@ -4,6 +4,7 @@
 #include "Mesh.h"
 #include "Material.h"
 #include "VoxelVolume.h"
+#include "VoxelSample.h"
 
 #include <vector>
 
@@ -29,13 +30,120 @@ private:
 	uint32 m_resolution;
 	class ChunkedVolume* m_parent;
 
+	///
+	/// Voxel storage for this chunk (Stored x + resolution * (y + resolution * z), relative to the offset)
+	/// Only allocated whilst the voxels hold different values, otherwise every voxel is the uniform value
+	///
+	VoxelSample* m_voxels = nullptr;
+	VoxelSample m_uniformValue = EncodeVoxel(DEFAULT_VALUE);
+
+	///
+	/// Summary of all values in this chunk (Including the border used by the cells on the upper edges)
+	/// May be looser than the actual range after edits, until next rebuild
+	///
+	float m_minValue;
+	float m_maxValue;
+
+	///
+	/// Mesh data waiting to be uploaded
+	///
+	std::vector<vec3> m_vertices;
+	std::vector<vec3> m_normals;
+	std::vector<uint32> m_triangles;
+	PackedMeshData m_packed;
+	VertexCacheStats m_vertexCacheStats;
+
 public:
 	VoxelChunk(const uvec3& offset, uint32 resolution, ChunkedVolume* parent);
 	~VoxelChunk();
 
 
-	// TODO - MAKE PROPER
-	void BuildMesh();
+	/**
+	* Build the mesh for this chunk into the CPU-side buffers
+	* (Only reads from the volume, so is safe to call on multiple chunks from worker threads)
+	*/
+	void BuildMeshData();
+
+	/**
+	* Upload the data built in BuildMeshData into the mesh
+	* (Must be called from the main thread)
+	*/
+	void UploadMesh();
+
+	/**
+	* Delete the mesh for this chunk (As it no longer contains any triangles)
+	*/
+	void ReleaseMesh();
+
+	/**
+	* Recalculate the exact min/max summary from the volume's data
+	*/
+	void RecalculateSummary();
+
+	/**
+	* Set the value of a voxel in this chunk
+	* @param x,y,z				The coordinate of the voxel, relative to the chunk's offset
+	* @param sample			The (encoded) value to set the voxel to
+	* @returns If the value of the voxel has actually changed
+	*/
+	bool SetVoxel(const uint32& x, const uint32& y, const uint32& z, const VoxelSample& sample);
+
+	/**
+	* Get the (encoded) value of a voxel in this chunk
+	* @param x,y,z				The coordinate of the voxel, relative to the chunk's offset
+	*/
+	inline VoxelSample GetVoxel(const uint32& x, const uint32& y, const uint32& z) const
+	{
+		return m_voxels == nullptr ? m_uniformValue : m_voxels[x + m_resolution * (y + m_resolution * z)];
+	}
+
+	/**
+	* Copy a row of voxels (Running along x, starting at the chunk's offset)
+	* @param y,z				The coordinate of the row, relative to the chunk's offset
+	* @param count				How many voxels to copy
+	* @param out				Where to copy the voxels to
+	*/
+	void CopyRow(const uint32& y, const uint32& z, const uint32& count, VoxelSample* out) const;
+
+	/**
+	* Free the voxel storage, if every voxel (Within the volume) has returned to the same value
+	* @returns If the chunk is now stored as a single value
+	*/
+	bool AttemptCompact();
+
+private:
+	/**
+	* Fetch all of the values this chunk uses (Including the border from the chunks after it)
+	* @param outDims			Where to store the dimensions of the values fetched
+	* @returns The values, stored x + dims.x * (y + dims.y * z)
+	*/
+	const VoxelSample* GatherValues(uvec3& outDims) const;
+
+public:
+
+	/**
+	* Expand the min/max summary to contain this value
+	* @param value				The value which has been set within this chunk
+	*/
+	inline void ExpandSummary(const float& value)
+	{
+		m_minValue = glm::min(m_minValue, value);
+		m_maxValue = glm::max(m_maxValue, value);
+	}
+
+	/**
+	* Could the surface pass through this chunk (i.e. isn't completely empty or solid)
+	* @param isoLevel			The isoLevel being used in MC
+	*/
+	inline bool CanContainSurface(const float& isoLevel) const { return m_minValue < isoLevel && m_maxValue >= isoLevel; }
+
+	/** Is every voxel in this chunk stored as a single value */
+	inline bool IsUniform() const { return m_voxels == nullptr; }
+	inline VoxelSample GetUniformValue() const { return m_uniformValue; }
+	inline const uvec3& GetOffset() const { return m_offset; }
+
+	/** How the last build's triangles used the vertex cache (Only filled when the volume optimises) */
+	inline const VertexCacheStats& GetVertexCacheStats() const { return m_vertexCacheStats; }
 };
 
 
@@ -55,11 +163,14 @@ private:
 	/// Volume vars
 	///
 	std::vector<VoxelChunk*> m_chunks;
+	std::vector<VoxelChunk*> m_dirtyChunks;
 	const uint32 chunkSize;
-	float* m_data = nullptr;
+	uvec3 m_chunkCount;
 	float m_isoLevel;
 	vec3 m_scale = vec3(1, 1, 1);
 	uvec3 m_resolution;
+	bool bOptimiseVertexCache = false;
+	bool bUsePackedVertices = false;
 
 public:
 	ChunkedVolume();
@@ -80,8 +191,10 @@ public:
 	///
 public:
 	virtual void Init(const uvec3& resolution, const vec3& scale) override;
+	virtual VoxelBuildResults Rebuild(const std::vector<VoxelDelta>& deltas, VoxelBuildResults* recreation) override;
 
 	virtual void Set(uint32 x, uint32 y, uint32 z, float value) override;
+	virtual void ApplyDeltas(const std::vector<VoxelDelta>& deltas) override;
 	virtual float Get(uint32 x, uint32 y, uint32 z) override;
 
 	virtual uvec3 GetResolution() const override { return m_resolution; }
@@ -89,13 +202,31 @@ public:
 
 	virtual float GetIsoLevel() const override { return m_isoLevel; }
 
+	/**
+	* Copy a block of voxels into a dense array
+	* Voxels belonging to chunks which don't exist are read as DEFAULT_VALUE
+	* @param offset				The first voxel in the block (Must be the offset of a chunk)
+	* @param dims				The size of the block (At most chunkSize + 1 along each axis)
+	* @param out				Where to store the voxels (stored x + dims.x * (y + dims.y * z))
+	*/
+	void GatherBlock(const uvec3& offset, const uvec3& dims, VoxelSample* out) const;
+
+	/** How many bytes are currently being used to store voxels */
+	uint64 GetVoxelStorageSize() const;
+
 	///
 	/// Getters & Setters
 	///
-private:
-	/** Get the index for a voxel in data */
-	inline uint32 GetVoxelIndex(uint32 x, uint32 y, uint32 z) const { return x + m_resolution.x * (y + m_resolution.y * z); }
+public:
+	/** Should chunk meshes be reordered for the GPU's vertex cache before being uploaded (Slower to build, but quicker to draw) */
+	inline void SetOptimiseVertexCache(const bool& value) { bOptimiseVertexCache = value; }
+	inline bool IsOptimisingVertexCache() const { return bOptimiseVertexCache; }
 
+	/** Should chunk meshes be uploaded as packed vertices, relative to each chunk's offset (See PackedVertex) */
+	inline void SetUsePackedVertices(const bool& value) { bUsePackedVertices = value; }
+	inline bool IsUsingPackedVertices() const { return bUsePackedVertices; }
+
+private:
 	/**
 	* Get the internal chunk coordniate for this
 	* @param x,y,z The object-space x,y,z coordinates for a voxel
@@ -115,7 +246,33 @@ private:
 	inline uint32 GetChunkIndex(uint32 x, uint32 y, uint32 z) const 
 	{ 
 		uvec3 coord = GetChunkCoords(x, y, z);
-		return coord.x + (m_resolution.x/chunkSize) * (coord.y + (m_resolution.y / chunkSize) * coord.z);
+		return coord.x + m_chunkCount.x * (coord.y + m_chunkCount.y * coord.z);
 	}
+
+	/**
+	* Get the chunk at these chunk coordinates, creating it if it doesn't exist yet
+	* @param coord The chunk coordinates
+	*/
+	VoxelChunk* FetchChunk(const uvec3& coord);
+
+	/**
+	* Get the chunk at these chunk coordinates, if it exists
+	* @param coord The chunk coordinates
+	*/
+	inline VoxelChunk* GetChunk(const uvec3& coord) const { return m_chunks[coord.x + m_chunkCount.x * (coord.y + m_chunkCount.y * coord.z)]; }
+
+	/**
+	* Flag this voxel as changed in every chunk before this one, which uses it as a border
+	* @param x,y,z				The coordinate of the voxel
+	* @param coord				The coordinate of the chunk which owns the voxel
+	* @param value				The new value of the voxel
+	*/
+	void NotifyBorderChunks(uint32 x, uint32 y, uint32 z, const uvec3& coord, float value);
+
+	/**
+	* Delete this chunk, if it has no mesh and only contains the default value
+	* @param chunk				The chunk to check
+	*/
+	void ReleaseChunkIfEmpty(VoxelChunk* chunk);
 };
 
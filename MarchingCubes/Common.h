@@ -43,7 +43,10 @@ struct vec3_KeyFuncs
 {
 	inline size_t operator()(const vec3& v)const
 	{
-		return std::hash<float>()(v.x) ^ std::hash<float>()(v.y) ^ std::hash<float>()(v.z);
+		// Combine in order, so permutations of the same components don't all collide
+		size_t hash = std::hash<float>()(v.x);
+		hash = hash * 31 + std::hash<float>()(v.y);
+		return hash * 31 + std::hash<float>()(v.z);
 	}
 
 	inline bool operator()(const vec3& a, const vec3& b)const
@@ -56,7 +59,10 @@ struct uvec3_KeyFuncs
 {
 	inline size_t operator()(const uvec3& v)const
 	{
-		return std::hash<uint32>()(v.x) ^ std::hash<uint32>()(v.y) ^ std::hash<uint32>()(v.z);
+		// Combine in order, so permutations of the same components don't all collide
+		size_t hash = std::hash<uint32>()(v.x);
+		hash = hash * 31 + std::hash<uint32>()(v.y);
+		return hash * 31 + std::hash<uint32>()(v.z);
 	}
 
 	inline bool operator()(const uvec3& a, const uvec3& b)const
@@ -69,11 +75,40 @@ struct ivec3_KeyFuncs
 {
 	inline size_t operator()(const ivec3& v)const
 	{
-		return std::hash<int32>()(v.x) ^ std::hash<int32>()(v.y) ^ std::hash<int32>()(v.z);
+		// Combine in order, so permutations of the same components don't all collide
+		size_t hash = std::hash<int32>()(v.x);
+		hash = hash * 31 + std::hash<int32>()(v.y);
+		return hash * 31 + std::hash<int32>()(v.z);
 	}
 
 	inline bool operator()(const ivec3& a, const ivec3& b)const
 	{
 		return a.x == b.x && a.y == b.y && a.z == b.z;
 	}
-};
\ No newline at end of file
+};
+
+
+/**
+* Spread the lower 21 bits of this value out, so there are 2 empty bits between each
+* (Used to interleave coordinates into a Morton code)
+*/
+inline uint64 MortonSpread(uint64 value)
+{
+	value &= 0x1FFFFF;
+	value = (value | value << 32) & 0x1F00000000FFFF;
+	value = (value | value << 16) & 0x1F0000FF0000FF;
+	value = (value | value << 8) & 0x100F00F00F00F00F;
+	value = (value | value << 4) & 0x10C30C30C30C30C3;
+	value = (value | value << 2) & 0x1249249249249249;
+	return value;
+}
+
+/**
+* Get the Morton (Z-order) code for this coordinate
+* Coordinates which are close in space will generally be close in the code
+* @param coord			The coordinate to encode (Each axis must fit in 21 bits)
+*/
+inline uint64 MortonEncode(const uvec3& coord)
+{
+	return MortonSpread(coord.x) | (MortonSpread(coord.y) << 1) | (MortonSpread(coord.z) << 2);
+}
@@ -2,6 +2,7 @@
 #include "MarchingCubes.h"
 
 #include <unordered_map>
+#include <algorithm>
 #include "DefaultMaterial.h"
 #include "MeshBuilder.h"
 #include "Window.h"
@@ -23,8 +24,6 @@ DefaultVolume::~DefaultVolume()
 	for (Mesh* mesh : m_meshes)
 		delete mesh;
 
-	if (m_data != nullptr)
-		delete[] m_data;
 	if (m_material != nullptr)
 		delete m_material;
 }
@@ -35,7 +34,7 @@ DefaultVolume::~DefaultVolume()
 ///
 void DefaultVolume::Init(const uvec3& resolution, const vec3& scale)
 {
-	m_data = new float[resolution.x * resolution.y * resolution.z]{ DEFAULT_VALUE };
+	m_data.Init(resolution, m_layout, EncodeVoxel(DEFAULT_VALUE));
 	m_resolution = resolution;
 	m_scale = scale;
 
@@ -44,13 +43,24 @@ void DefaultVolume::Init(const uvec3& resolution, const vec3& scale)
 
 void DefaultVolume::Set(uint32 x, uint32 y, uint32 z, float value) 
 {
-	m_data[GetIndex(x, y, z)] = value;
+	m_data.Set(x, y, z, EncodeVoxel(value));
 	bRequiresRebuild = true;
 }
 
+void DefaultVolume::ApplyDeltas(const std::vector<VoxelDelta>& deltas)
+{
+	// Writing in order already lets the last change win and the whole volume is rebuilt anyway,
+	// so there's nothing to gain from sorting the batch
+	for (const VoxelDelta& delta : deltas)
+		m_data.Set(delta.coord.x, delta.coord.y, delta.coord.z, EncodeVoxel(delta.value));
+
+	if (deltas.size() != 0)
+		bRequiresRebuild = true;
+}
+
 float DefaultVolume::Get(uint32 x, uint32 y, uint32 z) 
 {
-	return m_data[GetIndex(x, y, z)];
+	return DecodeVoxel(m_data.Get(x, y, z));
 }
 
 
@@ -72,7 +82,9 @@ void DefaultVolume::Update(const float& deltaTime)
 		MeshBuilderMinimal builder;
 		builder.MarkDynamic();
 		BuildMesh(builder);
-		builder.BuildMesh(m_meshes[currentLod]);
+		if (bOptimiseVertexCache)
+			builder.OptimiseVertexCache();
+		UploadMesh(builder, m_meshes[currentLod]);
 		bRequiresRebuild = false;
 	}
 }
@@ -121,6 +133,23 @@ void DefaultVolume::Draw(const class Window* window, const float& deltaTime)
 }
 
 void DefaultVolume::BuildMesh(MeshBuilderMinimal& builder)
+{
+	if (bUseSliceCache)
+		BuildMeshSliced(builder);
+	else
+		BuildMeshHashed(builder);
+}
+
+void DefaultVolume::UploadMesh(const MeshBuilderMinimal& builder, Mesh* target) const
+{
+	// Every vertex lies between the first and last voxel
+	if (bUsePackedVertices)
+		builder.BuildPackedMesh(target, vec3(0, 0, 0), vec3(m_resolution - uvec3(1, 1, 1)));
+	else
+		builder.BuildMesh(target);
+}
+
+void DefaultVolume::BuildMeshHashed(MeshBuilderMinimal& builder)
 {
 	vec3 edges[12];
 	
@@ -128,16 +157,34 @@ void DefaultVolume::BuildMesh(MeshBuilderMinimal& builder)
 		for (uint32 y = 0; y < GetResolution().y - 1; ++y)
 			for (uint32 z = 0; z < GetResolution().z - 1; ++z)
 			{
+				// Fetch the corners by stepping from the first, rather than working out each index from scratch
+				float corner[2][2][2];
+				{
+					const uint32 i000 = m_data.GetIndex(x, y, z);
+					const uint32 i100 = m_data.Step(i000, 0);
+					const uint32 i001 = m_data.Step(i000, 2);
+					const uint32 i101 = m_data.Step(i100, 2);
+
+					corner[0][0][0] = DecodeVoxel(m_data[i000]);
+					corner[1][0][0] = DecodeVoxel(m_data[i100]);
+					corner[0][0][1] = DecodeVoxel(m_data[i001]);
+					corner[1][0][1] = DecodeVoxel(m_data[i101]);
+					corner[0][1][0] = DecodeVoxel(m_data[m_data.Step(i000, 1)]);
+					corner[1][1][0] = DecodeVoxel(m_data[m_data.Step(i100, 1)]);
+					corner[0][1][1] = DecodeVoxel(m_data[m_data.Step(i001, 1)]);
+					corner[1][1][1] = DecodeVoxel(m_data[m_data.Step(i101, 1)]);
+				}
+
 				// Encode case based on bit presence
 				uint8 caseIndex = 0;
-				if (Get(x + 0, y + 0, z + 0) >= m_isoLevel) caseIndex |= 1;
-				if (Get(x + 1, y + 0, z + 0) >= m_isoLevel) caseIndex |= 2;
-				if (Get(x + 1, y + 0, z + 1) >= m_isoLevel) caseIndex |= 4;
-				if (Get(x + 0, y + 0, z + 1) >= m_isoLevel) caseIndex |= 8;
-				if (Get(x + 0, y + 1, z + 0) >= m_isoLevel) caseIndex |= 16;
-				if (Get(x + 1, y + 1, z + 0) >= m_isoLevel) caseIndex |= 32;
-				if (Get(x + 1, y + 1, z + 1) >= m_isoLevel) caseIndex |= 64;
-				if (Get(x + 0, y + 1, z + 1) >= m_isoLevel) caseIndex |= 128;
+				if (corner[0][0][0] >= m_isoLevel) caseIndex |= 1;
+				if (corner[1][0][0] >= m_isoLevel) caseIndex |= 2;
+				if (corner[1][0][1] >= m_isoLevel) caseIndex |= 4;
+				if (corner[0][0][1] >= m_isoLevel) caseIndex |= 8;
+				if (corner[0][1][0] >= m_isoLevel) caseIndex |= 16;
+				if (corner[1][1][0] >= m_isoLevel) caseIndex |= 32;
+				if (corner[1][1][1] >= m_isoLevel) caseIndex |= 64;
+				if (corner[0][1][1] >= m_isoLevel) caseIndex |= 128;
 			
 
 				// Fully inside iso-surface
@@ -145,36 +192,18 @@ void DefaultVolume::BuildMesh(MeshBuilderMinimal& builder)
 					continue;
 
 				// Smooth edges based on density
-#define VERT_LERP(x0, y0, z0, x1, y1, z1) MC::VertexLerp(m_isoLevel, vec3(x + x0,y + y0,z + z0), vec3(x + x1, y + y1, z + z1), Get(x + x0, y + y0, z + z0), Get(x + x1, y + y1, z + z1))
-				
-				if (MC::CaseRequiredEdges[caseIndex] & 1)
-					edges[0] = VERT_LERP(0,0,0, 1,0,0);
-				if (MC::CaseRequiredEdges[caseIndex] & 2)
-					edges[1] = VERT_LERP(1,0,0, 1,0,1);
-				if (MC::CaseRequiredEdges[caseIndex] & 4)
-					edges[2] = VERT_LERP(0,0,1, 1,0,1);
-				if (MC::CaseRequiredEdges[caseIndex] & 8)
-					edges[3] = VERT_LERP(0,0,0, 0,0,1);
-				if (MC::CaseRequiredEdges[caseIndex] & 16)
-					edges[4] = VERT_LERP(0,1,0, 1,1,0);
-				if (MC::CaseRequiredEdges[caseIndex] & 32)
-					edges[5] = VERT_LERP(1,1,0, 1,1,1);
-				if (MC::CaseRequiredEdges[caseIndex] & 64)
-					edges[6] = VERT_LERP(0,1,1, 1,1,1);
-				if (MC::CaseRequiredEdges[caseIndex] & 128)
-					edges[7] = VERT_LERP(0,1,0, 0,1,1);
-				if (MC::CaseRequiredEdges[caseIndex] & 256)
-					edges[8] = VERT_LERP(0,0,0, 0,1,0);
-				if (MC::CaseRequiredEdges[caseIndex] & 512)
-					edges[9] = VERT_LERP(1,0,0, 1,1,0);
-				if (MC::CaseRequiredEdges[caseIndex] & 1024)
-					edges[10] = VERT_LERP(1,0,1, 1,1,1);
-				if (MC::CaseRequiredEdges[caseIndex] & 2048)
-					edges[11] = VERT_LERP(0,0,1, 0,1,1);
+				const uint32 requiredEdges = MC::CaseRequiredEdges[caseIndex];
+				for (uint32 e = 0; e < 12; ++e)
+					if (requiredEdges & (1 << e))
+					{
+						const uint8* a = MC::CornerOffsets[MC::EdgeCorners[e][0]];
+						const uint8* b = MC::CornerOffsets[MC::EdgeCorners[e][1]];
+						edges[e] = MC::VertexLerp(m_isoLevel, vec3(x + a[0], y + a[1], z + a[2]), vec3(x + b[0], y + b[1], z + b[2]), corner[a[0]][a[1]][a[2]], corner[b[0]][b[1]][b[2]]);
+					}
 
 
 				// Add triangles for this case
-				int8* caseEdges = MC::Cases[caseIndex];
+				const int8* caseEdges = MC::Cases[caseIndex];
 				while (*caseEdges != -1)
 				{
 					int8 edge0 = *(caseEdges++);
@@ -196,14 +225,162 @@ void DefaultVolume::BuildMesh(MeshBuilderMinimal& builder)
 					// If normal is 0 it means the edge has been moved so the face is now a line
 					if (normalLengthSqrd != 0.0f && !std::isnan(normalLengthSqrd))
 					{
-						const uint32 a = builder.AddVertex(A, normal);
-						const uint32 b = builder.AddVertex(B, normal);
-						const uint32 c = builder.AddVertex(C, normal);
+						const uint32 a = builder.AddEdgeVertex(GetCellEdgeID(x, y, z, edge0), A, normal);
+						const uint32 b = builder.AddEdgeVertex(GetCellEdgeID(x, y, z, edge1), B, normal);
+						const uint32 c = builder.AddEdgeVertex(GetCellEdgeID(x, y, z, edge2), C, normal);
+						builder.AddTriangle(a, b, c);
+					}
+				}
+			}
+
+}
+
+void DefaultVolume::BuildMeshSliced(MeshBuilderMinimal& builder)
+{
+	const uint32 resX = m_resolution.x;
+	const uint32 resY = m_resolution.y;
+	const uint32 sliceSize = resX * resY;
+	const uint32 unsetIndex = ~0U;
+
+	// Each slice holds an x edge and a y edge for every point on it
+	m_sliceEdges[0].assign(sliceSize * 2, unsetIndex);
+	m_sliceEdges[1].assign(sliceSize * 2, unsetIndex);
+	m_slabEdges.resize(sliceSize);
+	m_rowCases.resize(resX);
+	for (std::vector<VoxelSample>& scratch : m_rowScratch)
+		scratch.resize(m_data.GetLayout() == VoxelLayout::Linear ? 0 : resX);
+
+	uint32 bottom = 0;
+	uint32 top = 1;
+	uint32 edgeIndices[12];
+
+	// Samples are compared and interpolated without decoding them
+	typedef VoxelSampleTraits<VoxelSample> Traits;
+	const float kernelIso = Traits::KernelIso(m_isoLevel);
+
+
+	for (uint32 z = 0; z < m_resolution.z - 1; ++z)
+	{
+		std::fill(m_slabEdges.begin(), m_slabEdges.end(), unsetIndex);
+
+		uint32* bottomX = m_sliceEdges[bottom].data();
+		uint32* bottomY = bottomX + sliceSize;
+		uint32* topX = m_sliceEdges[top].data();
+		uint32* topY = topX + sliceSize;
+		uint32* slabZ = m_slabEdges.data();
+
+		for (uint32 y = 0; y < resY - 1; ++y)
+		{
+			const uint32 rowStart = resX * y;
+
+			// Rows of samples surrounding the cells [y][z] (Only copied if the layout isn't linear)
+			const VoxelSample* row00 = m_data.GetRow(y, z, m_rowScratch[0].data());
+			const VoxelSample* row01 = m_data.GetRow(y, z + 1, m_rowScratch[1].data());
+			const VoxelSample* row10 = m_data.GetRow(y + 1, z, m_rowScratch[2].data());
+			const VoxelSample* row11 = m_data.GetRow(y + 1, z + 1, m_rowScratch[3].data());
+
+			// Classify every cell in this row at once
+			if (Traits::ClassifyRow(row00, row01, row10, row11, resX - 1, m_isoLevel, m_rowCases.data()) == 0)
+				continue;
+
+
+			// Gather every edge which hasn't been interpolated by a previous cell
+			const uint32 firstVertex = builder.GetVertexCount();
+			m_edgeBatch.Clear();
+
+			for (uint32 x = 0; x < resX - 1; ++x)
+			{
+				const uint8 caseIndex = m_rowCases[x];
+				if (caseIndex == 0 || caseIndex == 255)
+					continue;
+
+				const uint32 i = rowStart + x;
+				const int16 requiredEdges = MC::CaseRequiredEdges[caseIndex];
+
+#define GATHER_EDGE(edge, cache, aVal, bVal, x0, y0, z0, axis) \
+				if ((requiredEdges & (1 << edge)) && cache == unsetIndex) \
+				{ \
+					cache = firstVertex + m_edgeBatch.Size(); \
+					m_edgeBatch.Push(vec3(x + x0, y + y0, z + z0), axis, Traits::ToKernel(aVal), Traits::ToKernel(bVal)); \
+				}
+
+				GATHER_EDGE(0, bottomX[i], row00[x], row00[x + 1], 0,0,0, 0);
+				GATHER_EDGE(1, slabZ[i + 1], row00[x + 1], row01[x + 1], 1,0,0, 2);
+				GATHER_EDGE(2, topX[i], row01[x], row01[x + 1], 0,0,1, 0);
+				GATHER_EDGE(3, slabZ[i], row00[x], row01[x], 0,0,0, 2);
+				GATHER_EDGE(4, bottomX[i + resX], row10[x], row10[x + 1], 0,1,0, 0);
+				GATHER_EDGE(5, slabZ[i + resX + 1], row10[x + 1], row11[x + 1], 1,1,0, 2);
+				GATHER_EDGE(6, topX[i + resX], row11[x], row11[x + 1], 0,1,1, 0);
+				GATHER_EDGE(7, slabZ[i + resX], row10[x], row11[x], 0,1,0, 2);
+				GATHER_EDGE(8, bottomY[i], row00[x], row10[x], 0,0,0, 1);
+				GATHER_EDGE(9, bottomY[i + 1], row00[x + 1], row10[x + 1], 1,0,0, 1);
+				GATHER_EDGE(10, topY[i + 1], row01[x + 1], row11[x + 1], 1,0,1, 1);
+				GATHER_EDGE(11, topY[i], row01[x], row11[x], 0,0,1, 1);
+#undef GATHER_EDGE
+			}
+
+			// Interpolate all of the new edges together
+			MC::InterpolateEdges(m_edgeBatch, kernelIso);
+			for (uint32 e = 0; e < m_edgeBatch.Size(); ++e)
+				builder.AddUniqueVertex(m_edgeBatch.GetVertex(e));
+
+
+			// Add triangles for each cell
+			for (uint32 x = 0; x < resX - 1; ++x)
+			{
+				const uint8 caseIndex = m_rowCases[x];
+				if (caseIndex == 0 || caseIndex == 255)
+					continue;
+
+				const uint32 i = rowStart + x;
+				edgeIndices[0] = bottomX[i];
+				edgeIndices[1] = slabZ[i + 1];
+				edgeIndices[2] = topX[i];
+				edgeIndices[3] = slabZ[i];
+				edgeIndices[4] = bottomX[i + resX];
+				edgeIndices[5] = slabZ[i + resX + 1];
+				edgeIndices[6] = topX[i + resX];
+				edgeIndices[7] = slabZ[i + resX];
+				edgeIndices[8] = bottomY[i];
+				edgeIndices[9] = bottomY[i + 1];
+				edgeIndices[10] = topY[i + 1];
+				edgeIndices[11] = topY[i];
+
+				for (const int8* caseEdges = MC::Cases[caseIndex]; *caseEdges != -1; caseEdges += 3)
+				{
+					const uint32 a = edgeIndices[caseEdges[0]];
+					const uint32 b = edgeIndices[caseEdges[1]];
+					const uint32 c = edgeIndices[caseEdges[2]];
+
+					const vec3& A = builder.GetVertex(a);
+					const vec3& B = builder.GetVertex(b);
+					const vec3& C = builder.GetVertex(c);
+
+					// Ignore triangle which is malformed
+					if (A == B || A == C || B == C)
+						continue;
+
+
+					const vec3 normal = glm::cross(B - A, C - A);
+					const float normalLengthSqrd = dot(normal, normal);
+
+					// If normal is 0 it means the edge has been moved so the face is now a line
+					if (normalLengthSqrd != 0.0f && !std::isnan(normalLengthSqrd))
+					{
+						builder.AddNormal(a, normal);
+						builder.AddNormal(b, normal);
+						builder.AddNormal(c, normal);
 						builder.AddTriangle(a, b, c);
 					}
 				}
 			}
+		}
 
+
+		// Top slice becomes the bottom of the next slab
+		std::fill(m_sliceEdges[bottom].begin(), m_sliceEdges[bottom].end(), unsetIndex);
+		std::swap(bottom, top);
+	}
 }
 
 #include <chrono>
@@ -225,37 +402,58 @@ VoxelBuildResults DefaultVolume::Rebuild(const std::vector<VoxelDelta>& deltas,
 	results.tricount.resize(m_meshes.size());
 
 
-	int64 startTime = duration_cast<milliseconds>(system_clock::now().time_since_epoch()).count();
+	int64 startTime = duration_cast<microseconds>(high_resolution_clock::now().time_since_epoch()).count();
 	int64 endTime;
 
 	// Insert values
-	for (const VoxelDelta& delta : deltas)
-		m_data[GetIndex(delta.coord.x, delta.coord.y, delta.coord.z)] = delta.value;
+	ApplyDeltas(deltas);
 
-	endTime = duration_cast<milliseconds>(system_clock::now().time_since_epoch()).count();
+	endTime = duration_cast<microseconds>(high_resolution_clock::now().time_since_epoch()).count();
 	results.insertTime = endTime - startTime;
 
 
 	// Rebuild meshes
-	int64 buildStartTime = duration_cast<milliseconds>(system_clock::now().time_since_epoch()).count();
+	int64 buildStartTime = duration_cast<microseconds>(high_resolution_clock::now().time_since_epoch()).count();
 	MeshBuilderMinimal builder;
 	builder.MarkDynamic();
+	builder.Reserve(m_meshes[0]->GetDrawCount() / 3); // Edits rarely change the size of the mesh by much
 	BuildMesh(builder);
 
+	// Every clustered LOD comes out of a single pass over the full mesh
+	std::vector<MeshBuilderMinimal> clusteredLods;
+	if (recreation && bUseClusteredLods)
+	{
+		clusteredLods.resize(m_meshes.size() - 1);
+		builder.BuildClusteredLods(clusteredLods);
+	}
+
 	for (uint32 i = 0; i < m_meshes.size(); ++i)
 	{
-		if(recreation)
-			builder.PerformEdgeCollapseReduction(recreation->tricount[recreation->tricount.size() - 1 - i]);
-		builder.BuildMesh(m_meshes[i]);
+		MeshBuilderMinimal& lodBuilder = (i != 0 && !clusteredLods.empty()) ? clusteredLods[i - 1] : builder;
+
+		if (recreation && !bUseClusteredLods)
+		{
+			SimplifySettings simplify;
+			simplify.targetTriangles = recreation->tricount[recreation->tricount.size() - 1 - i] / 3;
+			lodBuilder.Simplify(simplify);
+		}
+
+		if (bOptimiseVertexCache)
+		{
+			const VertexCacheStats stats = lodBuilder.OptimiseVertexCache();
+			if (i == 0)
+				results.vertexCache = stats;
+		}
+		UploadMesh(lodBuilder, m_meshes[i]);
 
-		endTime = duration_cast<milliseconds>(system_clock::now().time_since_epoch()).count();
+		endTime = duration_cast<microseconds>(high_resolution_clock::now().time_since_epoch()).count();
 		results.buildTime[i] = endTime - buildStartTime;
 		results.tricount[i] = m_meshes[i]->GetDrawCount();
 	}
 
 
 	// Total time
-	endTime = duration_cast<milliseconds>(system_clock::now().time_since_epoch()).count();
+	endTime = duration_cast<microseconds>(high_resolution_clock::now().time_since_epoch()).count();
 	results.totalTime = endTime - startTime;
 	return results;
 }
\ No newline at end of file
@@ -5,6 +5,9 @@
 #include "Material.h"
 #include "VoxelVolume.h"
 #include "MeshBuilder.h"
+#include "MarchingCubesKernel.h"
+#include "VoxelSample.h"
+#include "VoxelGrid.h"
 
 
 
@@ -23,14 +26,30 @@ private:
 
 	std::vector<Mesh*> m_meshes;
 	uint32 currentLod;
+	bool bUseClusteredLods = false;
+	bool bOptimiseVertexCache = false;
+	bool bUsePackedVertices = false;
 
 	///
 	/// Volume Vars
 	///
 	float m_isoLevel;
-	float* m_data = nullptr;
+	VoxelGrid m_data;
+	VoxelLayout m_layout = VoxelLayout::Linear;
 	vec3 m_scale = vec3(1, 1, 1);
 	uvec3 m_resolution;
+	bool bUseSliceCache = true;
+
+	///
+	/// Slice cache vars
+	/// Vertex indices for the edges on the bottom and top slice of the current slab (x edges, then y edges)
+	/// and the edges which run between the 2 slices
+	///
+	std::vector<uint32> m_sliceEdges[2];
+	std::vector<uint32> m_slabEdges;
+	std::vector<uint8> m_rowCases;
+	std::vector<VoxelSample> m_rowScratch[4];
+	MC::EdgeBatch m_edgeBatch;
 
 public:
 	DefaultVolume();
@@ -48,6 +67,38 @@ public:
 	// TODO - MAKE PROPER
 	void BuildMesh(MeshBuilderMinimal& builder);
 
+private:
+	/**
+	* Upload the builder's data to this mesh, in whichever vertex format is in use
+	* @param builder			The builder holding the mesh data
+	* @param target				The mesh to upload the data to
+	*/
+	void UploadMesh(const MeshBuilderMinimal& builder, Mesh* target) const;
+
+	/**
+	* Build the mesh cell by cell, sharing vertices by looking up their edge in the builder
+	* @param builder			Where to store the mesh data
+	*/
+	void BuildMeshHashed(MeshBuilderMinimal& builder);
+
+	/**
+	* Get the builder's id for one of the 12 edges of a cell
+	* @param x,y,z				The coordinate of the cell
+	* @param edge				The MC edge index
+	*/
+	static inline uint64 GetCellEdgeID(const uint32& x, const uint32& y, const uint32& z, const int8& edge)
+	{
+		return MeshBuilderMinimal::GetEdgeID(uvec3(x + MC::EdgeStart[edge][0], y + MC::EdgeStart[edge][1], z + MC::EdgeStart[edge][2]), MC::EdgeAxis[edge]);
+	}
+
+	/**
+	* Build the mesh slab by slab in memory order, caching the vertex for each edge intersection,
+	* so each intersection is only interpolated once and shared by every cell which uses it
+	* (Each row of cells is classified and interpolated together using the MC kernel)
+	* @param builder			Where to store the mesh data
+	*/
+	void BuildMeshSliced(MeshBuilderMinimal& builder);
+
 
 	///
 	/// Voxel Data functions
@@ -57,6 +108,7 @@ public:
 	virtual VoxelBuildResults Rebuild(const std::vector<VoxelDelta>& deltas, VoxelBuildResults* recreation) override;
 
 	virtual void Set(uint32 x, uint32 y, uint32 z, float value) override;
+	virtual void ApplyDeltas(const std::vector<VoxelDelta>& deltas) override;
 	virtual float Get(uint32 x, uint32 y, uint32 z) override;
 
 	virtual uvec3 GetResolution() const override { return m_resolution; }
@@ -68,9 +120,27 @@ public:
 	///
 	/// Getters & Setters
 	///
-private:
-	inline uint32 GetIndex(uint32 x, uint32 y, uint32 z) const { return x + m_resolution.x * (y + m_resolution.y * z); }
 public:
 	inline vec3 GetScale() const { return m_scale; }
+
+	/** How the voxels should be laid out in memory (Only takes effect on the next Init) */
+	inline void SetLayout(const VoxelLayout& layout) { m_layout = layout; }
+	inline VoxelLayout GetLayout() const { return m_layout; }
+
+	/** Should meshes be built using the slice cache (Or the original vertex lookup) */
+	inline void SetUseSliceCache(const bool& value) { bUseSliceCache = value; }
+	inline bool IsUsingSliceCache() const { return bUseSliceCache; }
+
+	/** Should recreated LODs be built by vertex clustering (Or by quadric simplification, which is slower but keeps more detail) */
+	inline void SetUseClusteredLods(const bool& value) { bUseClusteredLods = value; }
+	inline bool IsUsingClusteredLods() const { return bUseClusteredLods; }
+
+	/** Should meshes be reordered for the GPU's vertex cache before being uploaded (Slower to build, but quicker to draw) */
+	inline void SetOptimiseVertexCache(const bool& value) { bOptimiseVertexCache = value; }
+	inline bool IsOptimisingVertexCache() const { return bOptimiseVertexCache; }
+
+	/** Should meshes be uploaded as packed vertices (Quantized positions and normals, 16-bit indices where possible) */
+	inline void SetUsePackedVertices(const bool& value) { bUsePackedVertices = value; }
+	inline bool IsUsingPackedVertices() const { return bUsePackedVertices; }
 };
 
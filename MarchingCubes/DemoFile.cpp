@@ -0,0 +1,97 @@
+#include "DemoFile.h"
+#include "Logger.h"
+
+#include <fstream>
+
+
+void DemoFile::AppendFrame(const string& file, const VoxelFrame& frame)
+{
+	std::ofstream stream(file, std::ofstream::app | std::ofstream::binary);
+
+	// Record deltas
+	{
+		uint32 count = frame.deltas.size();
+		stream.write(reinterpret_cast<const char*>(&count), sizeof(uint32));
+		stream.write(reinterpret_cast<const char*>(frame.deltas.data()), frame.deltas.size() * sizeof(VoxelDelta));
+	}
+
+	// Record results
+	{
+		const void* data;
+
+		data = &frame.results.insertTime;
+		stream.write(reinterpret_cast<const char*>(data), sizeof(int64));
+		data = &frame.results.totalTime;
+		stream.write(reinterpret_cast<const char*>(data), sizeof(int64));
+
+		uint32 count = frame.results.buildTime.size();
+		stream.write(reinterpret_cast<const char*>(&count), sizeof(uint32));
+
+		data = frame.results.buildTime.data();
+		stream.write(reinterpret_cast<const char*>(data), count * sizeof(int64));
+
+		data = frame.results.tricount.data();
+		stream.write(reinterpret_cast<const char*>(data), count * sizeof(uint32));
+	}
+
+	stream.close();
+}
+
+bool DemoFile::ReadFrames(const string& file, std::vector<VoxelFrame>& outFrames)
+{
+	std::ifstream stream(file, std::ifstream::binary);
+	if (!stream.good())
+	{
+		LOG_ERROR("Failed to open demo file '%s'", file.c_str());
+		return false;
+	}
+
+	// Read all frames in the file
+	while (true)
+	{
+		VoxelFrame frame;
+
+		// Read deltas
+		{
+			uint32 count;
+			if (!stream.read(reinterpret_cast<char*>(&count), sizeof(uint32)))
+				break; // Reached the end of the file
+
+			frame.deltas.resize(count);
+			stream.read(reinterpret_cast<char*>(frame.deltas.data()), frame.deltas.size() * sizeof(VoxelDelta));
+		}
+
+		// Read results
+		{
+			void* data;
+
+			data = &frame.results.insertTime;
+			stream.read(reinterpret_cast<char*>(data), sizeof(int64));
+			data = &frame.results.totalTime;
+			stream.read(reinterpret_cast<char*>(data), sizeof(int64));
+
+			uint32 count;
+			stream.read(reinterpret_cast<char*>(&count), sizeof(uint32));
+			frame.results.buildTime.resize(count);
+			frame.results.tricount.resize(count);
+
+			data = frame.results.buildTime.data();
+			stream.read(reinterpret_cast<char*>(data), count * sizeof(int64));
+
+			data = frame.results.tricount.data();
+			stream.read(reinterpret_cast<char*>(data), count * sizeof(uint32));
+		}
+
+		// Frame was cut short, so ignore it
+		if (!stream)
+		{
+			LOG_WARNING("Demo file '%s' ended part way through a frame", file.c_str());
+			break;
+		}
+
+		outFrames.push_back(frame);
+	}
+
+	stream.close();
+	return true;
+}
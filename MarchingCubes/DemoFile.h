@@ -0,0 +1,44 @@
+#pragma once
+#include "Common.h"
+#include "VoxelVolume.h"
+
+#include <vector>
+
+
+/**
+* All of the changes which were made during a single recorded frame
+*/
+struct VoxelFrame 
+{
+	std::vector<VoxelDelta> deltas;
+	VoxelBuildResults results;
+
+	inline void clear() 
+	{
+		deltas.clear();
+		results.clear();
+	}
+};
+
+
+/**
+* Reads and writes recordings of voxel changes, so they can be played back later
+*/
+class DemoFile
+{
+public:
+	/**
+	* Append a single frame onto the end of a demo file
+	* @param file				The URL of the file to write to
+	* @param frame				The frame to record
+	*/
+	static void AppendFrame(const string& file, const VoxelFrame& frame);
+
+	/**
+	* Read every frame which is stored in a demo file
+	* @param file				The URL of the file to read
+	* @param outFrames			Where to store all of the frames
+	* @returns If the file was successfully opened
+	*/
+	static bool ReadFrames(const string& file, std::vector<VoxelFrame>& outFrames);
+};
@@ -0,0 +1,114 @@
+#pragma once
+#include "Common.h"
+
+#include <vector>
+
+
+/**
+* Remembers how each edge was resolved against the layers' seams, so nodes which share an edge only resolve it once
+* Entries are stamped with the generation they were added in, so clearing the cache never has to touch the table
+*/
+class EdgeOverrideCache
+{
+public:
+	/**
+	* How a single edge was resolved
+	*/
+	struct Entry
+	{
+		uint64 edgeId;
+		uint64 overrideId; // The id of the edge the vertex was moved onto (Only valid if overridden)
+		vec3 position; // Where the vertex was moved to (Only valid if overridden)
+		uint32 generation;
+		bool bIsOverridden;
+	};
+
+private:
+	std::vector<Entry> m_table; // Open-addressed (Linear probing), with a power of 2 size
+	uint32 m_shift = 64;
+	uint32 m_count = 0;
+	uint32 m_generation = 1;
+
+public:
+	/**
+	* Forget every entry (Only resets the table once every 2^32 clears)
+	*/
+	void Clear()
+	{
+		m_count = 0;
+		if (++m_generation == 0)
+		{
+			for (Entry& entry : m_table)
+				entry.generation = 0;
+			m_generation = 1;
+		}
+	}
+
+	/**
+	* Find the entry for this edge, adding a blank one if it hasn't been seen since the last clear
+	* @param edgeId				The id of the edge (See MeshBuilderMinimal::GetEdgeID)
+	* @param isNew				Set to true if the entry has just been added, so still needs filling in
+	* @returns The entry (Only valid until the next call)
+	*/
+	Entry& FindOrAdd(const uint64& edgeId, bool& isNew)
+	{
+		// Keep the table at most half full, so probes stay short
+		if ((m_count + 1) * 2 > m_table.size())
+			Resize(m_table.empty() ? 1024 : (uint32)m_table.size() * 2);
+
+		const uint32 mask = m_table.size() - 1;
+		uint32 slot = GetSlot(edgeId);
+
+		while (true)
+		{
+			Entry& entry = m_table[slot];
+
+			if (entry.generation != m_generation)
+			{
+				entry.edgeId = edgeId;
+				entry.generation = m_generation;
+				entry.bIsOverridden = false;
+				++m_count;
+				isNew = true;
+				return entry;
+			}
+
+			if (entry.edgeId == edgeId)
+			{
+				isNew = false;
+				return entry;
+			}
+
+			slot = (slot + 1) & mask;
+		}
+	}
+
+private:
+	/**
+	* Move every current entry into a table of this size
+	* @param capacity			The new size of the table (Must be a power of 2)
+	*/
+	void Resize(const uint32& capacity)
+	{
+		std::vector<Entry> oldTable;
+		oldTable.swap(m_table);
+
+		m_table.resize(capacity); // Zeroed, so every slot starts off in generation 0 (Never in use)
+
+		m_shift = 64;
+		for (uint32 size = capacity; size > 1; size >>= 1)
+			--m_shift;
+
+		const uint32 mask = capacity - 1;
+		for (const Entry& entry : oldTable)
+			if (entry.generation == m_generation)
+			{
+				uint32 slot = GetSlot(entry.edgeId);
+				while (m_table[slot].generation == m_generation)
+					slot = (slot + 1) & mask;
+				m_table[slot] = entry;
+			}
+	}
+
+	inline uint32 GetSlot(const uint64& edgeId) const { return (uint32)((edgeId * 0x9E3779B97F4A7C15ULL) >> m_shift); }
+};
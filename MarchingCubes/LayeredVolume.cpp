@@ -1,13 +1,190 @@
 #include "LayeredVolume.h"
 #include "Window.h"
+#include "Level.h"
 
 #include "DefaultMaterial.h"
 #include "InteractionMaterial.h"
 
 #include "Logger.h"
 #include "MarchingCubes.h"
+#include "ThreadPool.h"
 
-#include <unordered_set>
+#include <algorithm>
+
+
+/**
+* Count the edges in this mesh which don't have exactly 2 triangles
+* (Vertices are matched by position, as a corner sitting exactly on the iso level is reached through several edge ids,
+* and edges on the sides of the volume are skipped, as the surface is cut off there)
+* @param builder			The mesh to check
+* @param octreeRes			The resolution of the volume's octree
+* @param outOpenEdges		How many edges only have a triangle on one side
+* @param outNonManifoldEdges	How many edges have more than 2 triangles
+*/
+static void CountSeamEdges(const MeshBuilderMinimal& builder, const uint32& octreeRes, uint32& outOpenEdges, uint32& outNonManifoldEdges)
+{
+	const std::vector<vec3>& vertices = builder.GetVertices();
+	const std::vector<uint32>& indices = builder.GetIndices();
+
+	std::unordered_map<vec3, uint32, vec3_KeyFuncs, vec3_KeyFuncs> positionLookup;
+	std::vector<uint32> positionIds(vertices.size());
+	positionLookup.reserve(vertices.size());
+	for (uint32 i = 0; i < vertices.size(); ++i)
+		positionIds[i] = positionLookup.emplace(vertices[i], i).first->second;
+
+	// How many triangles use each edge (Lowest vertex first)
+	std::unordered_map<uint64, uint32> edgeUses;
+	edgeUses.reserve(indices.size());
+	for (uint32 i = 0; i < indices.size(); i += 3)
+		for (uint32 k = 0; k < 3; ++k)
+		{
+			const uint32 a = positionIds[indices[i + k]];
+			const uint32 b = positionIds[indices[i + (k + 1) % 3]];
+			if (a != b)
+				++edgeUses[a < b ? ((uint64)a << 32) | b : ((uint64)b << 32) | a];
+		}
+
+	const float upper = (float)(octreeRes - 1);
+	auto isOnSide = [upper](const vec3& a, const vec3& b)
+	{
+		for (uint32 axis = 0; axis < 3; ++axis)
+			if ((a[axis] == 0.0f && b[axis] == 0.0f) || (a[axis] == upper && b[axis] == upper))
+				return true;
+		return false;
+	};
+
+	outOpenEdges = 0;
+	outNonManifoldEdges = 0;
+	for (const auto& pair : edgeUses)
+	{
+		if (pair.second > 2)
+			++outNonManifoldEdges;
+		else if (pair.second == 1 && !isOnSide(vertices[pair.first >> 32], vertices[pair.first & 0xFFFFFFFF]))
+			++outOpenEdges;
+	}
+}
+
+/**
+* Weld cached triangles together into a builder
+* @param triangles			The first triangle
+* @param count				How many triangles there are
+* @param builder			Where to add the triangles
+*/
+static void WeldTriangles(const OctreeLayerTriangle* triangles, const uint32& count, MeshBuilderMinimal& builder)
+{
+	for (uint32 t = 0; t < count; ++t)
+	{
+		const OctreeLayerTriangle& triangle = triangles[t];
+
+		uint32 indices[3];
+		for (uint32 i = 0; i < 3; ++i)
+			indices[i] = (triangle.edgeIds[i] == OctreeLayerTriangle::NoEdgeID ?
+				builder.AddVertex(triangle.vertices[i], triangle.normal) :
+				builder.AddEdgeVertex(triangle.edgeIds[i], triangle.vertices[i], triangle.normal)
+			);
+
+		builder.AddTriangle(indices[0], indices[1], indices[2]);
+	}
+}
+
+/**
+* Add a block as a user of a shared vertex
+* @param table				The shared vertices
+* @param key				The edge id or position of the vertex
+* @param user				The block and the index of the vertex in its builder
+* @param changed			Where to queue the vertex to be re-welded
+*/
+template<typename Key, typename Table>
+static void AddSharedUser(Table& table, const Key& key, const uvec2& user, std::vector<Key>& changed)
+{
+	OctreeLayer::SharedVertex& shared = table[key];
+	if (shared.userCount == OctreeLayer::SharedVertex::MaxUsers)
+	{
+		LOG_WARNING("Vertex is shared by more than %i blocks", OctreeLayer::SharedVertex::MaxUsers);
+		return;
+	}
+
+	shared.users[shared.userCount++] = user;
+	if (!shared.bIsChanged)
+	{
+		shared.bIsChanged = true;
+		changed.push_back(key);
+	}
+}
+
+/**
+* Remove a block from the users of a shared vertex
+* @param table				The shared vertices
+* @param key				The edge id or position of the vertex
+* @param block				The index of the block
+* @param changed			Where to queue the vertex to be re-welded
+*/
+template<typename Key, typename Table>
+static void RemoveSharedUser(Table& table, const Key& key, const uint32& block, std::vector<Key>& changed)
+{
+	auto it = table.find(key);
+	if (it == table.end())
+		return;
+
+	// Swap the block's entry out with the last user's
+	OctreeLayer::SharedVertex& shared = it->second;
+	for (uint32 i = 0; i < shared.userCount; ++i)
+		if (shared.users[i].x == block)
+		{
+			shared.users[i] = shared.users[--shared.userCount];
+			break;
+		}
+
+	if (shared.userCount == 0)
+		table.erase(it);
+	else if (!shared.bIsChanged)
+	{
+		shared.bIsChanged = true;
+		changed.push_back(key);
+	}
+}
+
+/**
+* Give every copy of each changed shared vertex the same position and normal, as if the blocks had been appended together
+* (The first block's position is used, and the normals are summed)
+* @param table				The shared vertices
+* @param changed			The vertices which need re-welding (Cleared afterwards)
+* @param blocks				Every block in the layer
+* @param arena				Where the blocks' meshes live
+*/
+template<typename Key, typename Table>
+static void WeldSharedVertices(Table& table, std::vector<Key>& changed, const std::vector<OctreeLayer::BuildBlock>& blocks, MeshArena& arena)
+{
+	for (const Key& key : changed)
+	{
+		auto it = table.find(key);
+		if (it == table.end())
+			continue;
+
+		OctreeLayer::SharedVertex& shared = it->second;
+		shared.bIsChanged = false;
+
+		// A vertex only used by a block which has just been written already holds the right data
+		if (shared.userCount == 1 && blocks[shared.users[0].x].bIsArenaStale)
+			continue;
+
+		uvec2 first = shared.users[0];
+		vec3 normal(0, 0, 0);
+		for (uint32 i = 0; i < shared.userCount; ++i)
+		{
+			const uvec2& user = shared.users[i];
+			if (user.x < first.x)
+				first = user;
+			normal += blocks[user.x].builder.GetNormals()[user.y];
+		}
+
+		const vec3 vertex = blocks[first.x].builder.GetVertex(first.y);
+		for (uint32 i = 0; i < shared.userCount; ++i)
+			arena.SetVertex(blocks[shared.users[i].x].range, shared.users[i].y, vertex, normal);
+	}
+
+	changed.clear();
+}
 
 
 ///
@@ -33,23 +210,37 @@ OctreeLayerNode::OctreeLayerNode(const uint32& id, OctreeLayer* layer, const boo
 		m_values[CHILD_OFFSET_FR_TOP_L] = volume->Get((nodeCoords.x + 0) * stride, (nodeCoords.y + 1) * stride, (nodeCoords.z + 1) * stride);
 		m_values[CHILD_OFFSET_FR_TOP_R] = volume->Get((nodeCoords.x + 1) * stride, (nodeCoords.y + 1) * stride, (nodeCoords.z + 1) * stride);
 
-		m_caseIndex = 0;
-		if (m_values[CHILD_OFFSET_BK_BOT_L] > isoLevel) m_caseIndex |= 1;
-		if (m_values[CHILD_OFFSET_BK_BOT_R] > isoLevel) m_caseIndex |= 2;
-		if (m_values[CHILD_OFFSET_FR_BOT_R] > isoLevel) m_caseIndex |= 4;
-		if (m_values[CHILD_OFFSET_FR_BOT_L] > isoLevel) m_caseIndex |= 8;
-		if (m_values[CHILD_OFFSET_BK_TOP_L] > isoLevel) m_caseIndex |= 16;
-		if (m_values[CHILD_OFFSET_BK_TOP_R] > isoLevel) m_caseIndex |= 32;
-		if (m_values[CHILD_OFFSET_FR_TOP_R] > isoLevel) m_caseIndex |= 64;
-		if (m_values[CHILD_OFFSET_FR_TOP_L] > isoLevel) m_caseIndex |= 128;
-
-		RecalculateStats();
+		RecalculateCaseIndex();
 	}
 
 	// Update state with parent node
 	OctreeLayerNode* parent;
 	if (id != 0 && layer->AttemptNodeFetch(GetParentID(), parent, true))
 		parent->SetChildFlag(GetOffsetAsChild(), true);
+
+	// Parent now has a new child to consider
+	MarkStatsStale();
+}
+
+OctreeLayerNode::OctreeLayerNode(const uint32& id, OctreeLayer* layer, const std::array<float, 8>& values, const uint8& childFlags) :
+	m_id(id), m_values(values), m_layer(layer), m_childFlags(childFlags), m_safeQualityDepth(0)
+{
+	RecalculateCaseIndex();
+}
+
+void OctreeLayerNode::RecalculateCaseIndex()
+{
+	const float isoLevel = m_layer->GetVolume()->GetIsoLevel();
+
+	m_caseIndex = 0;
+	if (m_values[CHILD_OFFSET_BK_BOT_L] > isoLevel) m_caseIndex |= 1;
+	if (m_values[CHILD_OFFSET_BK_BOT_R] > isoLevel) m_caseIndex |= 2;
+	if (m_values[CHILD_OFFSET_FR_BOT_R] > isoLevel) m_caseIndex |= 4;
+	if (m_values[CHILD_OFFSET_FR_BOT_L] > isoLevel) m_caseIndex |= 8;
+	if (m_values[CHILD_OFFSET_BK_TOP_L] > isoLevel) m_caseIndex |= 16;
+	if (m_values[CHILD_OFFSET_BK_TOP_R] > isoLevel) m_caseIndex |= 32;
+	if (m_values[CHILD_OFFSET_FR_TOP_R] > isoLevel) m_caseIndex |= 64;
+	if (m_values[CHILD_OFFSET_FR_TOP_L] > isoLevel) m_caseIndex |= 128;
 }
 
 void OctreeLayerNode::OnSafeDestroy()
@@ -57,12 +248,14 @@ void OctreeLayerNode::OnSafeDestroy()
 	// Update state with parent node
 	OctreeLayerNode* parent;
 	if (m_id != 0 && m_layer->AttemptNodeFetch(GetParentID(), parent, false))
+	{
 		parent->SetChildFlag(GetOffsetAsChild(), false);
+		parent->MarkStatsStale();
+	}
 }
 
 void OctreeLayerNode::Push(const uint32& corner, const LayeredVolume* volume, const float& value)
 {
-	const float oldValue = m_values[corner];
 	m_values[corner] = value;
 
 	// Update case index
@@ -96,13 +289,9 @@ void OctreeLayerNode::Push(const uint32& corner, const LayeredVolume* volume, co
 		else { LOG_ERROR("Invalid corner used in push"); }
 	}
 
-	// Only notify for rebuild if note worty change happens
-	if (oldCase != m_caseIndex || (value != oldValue && (m_caseIndex != 0 || m_caseIndex != 255)))
-	{
-		m_layer->rebuildFlag = true;
-		RecalculateStats();
-	}
-
+	// Merge depths only depend on the cases, so only a case change needs them recalculating (The volume marks which nodes need rebuilding)
+	if (oldCase != m_caseIndex)
+		MarkStatsStale();
 }
 
 uint32 OctreeLayerNode::GetOffsetAsChild() const
@@ -163,21 +352,27 @@ uint32 OctreeLayerNode::GetChildID(const uint32& offset) const
 }
 
 static bool buildDebugMesh = false;
-void OctreeLayerNode::BuildMesh(const float& isoLevel, MeshBuilderMinimal& builder, const uint32& maxDepthOffset, OctreeLayer* highestLayer, const uint32& highestLayerOffset)
+void OctreeLayerNode::BuildMesh(const float& isoLevel, std::vector<OctreeLayerTriangle>& out, const uint32& maxDepthOffset, OctreeLayer* highestLayer, const uint32& highestLayerOffset, EdgeOverrideCache& overrideCache)
 {
+	const uvec3 layerCoords = m_layer->GetLocalCoords(m_id);
+
 	// Merge
-	if (maxDepthOffset != 0 && RequiresHigherDetail(maxDepthOffset))
+	if (maxDepthOffset != 0 && m_layer->IsNodeSplit(this, layerCoords, maxDepthOffset, highestLayer))
 	{
 		if (m_childFlags == 0)
 			return; // Has no children, so just stop meshing here
 
+		// Close any gaps against neighbours which are being meshed at this node's resolution
+		if (m_layer->GetVolume()->GetSeamMode() == LayeredSeamMode::TransitionCells)
+			BuildTransitionCells(isoLevel, out, maxDepthOffset, highestLayer);
+
 		std::array<OctreeLayerNode*, 8> children;
 		FetchChildren(children);
 		
 		for (OctreeLayerNode* child : children)
 		{
 			if (child)
-				child->BuildMesh(isoLevel, builder, maxDepthOffset - 1, highestLayer, highestLayerOffset);
+				child->BuildMesh(isoLevel, out, maxDepthOffset - 1, highestLayer, highestLayerOffset, overrideCache);
 		}
 		
 		return;
@@ -188,7 +383,6 @@ void OctreeLayerNode::BuildMesh(const float& isoLevel, MeshBuilderMinimal& build
 		return;
 
 	const uint32 stride = m_layer->GetStride();
-	const uvec3 layerCoords = m_layer->GetLocalCoords(m_id);
 	const float stridef = stride;
 
 	if (buildDebugMesh)
@@ -206,70 +400,74 @@ void OctreeLayerNode::BuildMesh(const float& isoLevel, MeshBuilderMinimal& build
 		const vec3 normal = (m_id == 1454 ? vec3(0, -1, 0) : vec3(0, 1, 0));
 		//TODO - Remove
 
-		const uint32 i0 = builder.AddVertex((vec3(layerCoords) + vec3(0.0f, 0.0f, 0.0f)) * stridef, normal);
-		const uint32 i1 = builder.AddVertex((vec3(layerCoords) + vec3(1.0f, 0.0f, 0.0f)) * stridef, normal);
-		const uint32 i2 = builder.AddVertex((vec3(layerCoords) + vec3(0.0f, 0.0f, 1.0f)) * stridef, normal);
-		const uint32 i3 = builder.AddVertex((vec3(layerCoords) + vec3(1.0f, 0.0f, 1.0f)) * stridef, normal);
-
-		const uint32 i4 = builder.AddVertex((vec3(layerCoords) + vec3(0.0f, 1.0f, 0.0f)) * stridef, normal);
-		const uint32 i5 = builder.AddVertex((vec3(layerCoords) + vec3(1.0f, 1.0f, 0.0f)) * stridef, normal);
-		const uint32 i6 = builder.AddVertex((vec3(layerCoords) + vec3(0.0f, 1.0f, 1.0f)) * stridef, normal);
-		const uint32 i7 = builder.AddVertex((vec3(layerCoords) + vec3(1.0f, 1.0f, 1.0f)) * stridef, normal);
-
-		builder.AddTriangle(i0, i1, i2); builder.AddTriangle(i2, i1, i3);
-		builder.AddTriangle(i4, i6, i5); builder.AddTriangle(i5, i6, i7);
-		builder.AddTriangle(i0, i2, i1); builder.AddTriangle(i2, i3, i1);
-		builder.AddTriangle(i4, i5, i6); builder.AddTriangle(i5, i7, i6);
-
-		builder.AddTriangle(i2, i3, i6); builder.AddTriangle(i6, i3, i7);
-		builder.AddTriangle(i3, i1, i7); builder.AddTriangle(i1, i5, i7);
-		builder.AddTriangle(i2, i6, i3); builder.AddTriangle(i6, i7, i3);
-		builder.AddTriangle(i3, i7, i1); builder.AddTriangle(i1, i7, i5);
-
-		builder.AddTriangle(i1, i0, i4); builder.AddTriangle(i1, i4, i5);
-		builder.AddTriangle(i0, i2, i4); builder.AddTriangle(i2, i6, i4);
-		builder.AddTriangle(i1, i4, i0); builder.AddTriangle(i1, i5, i4);
-		builder.AddTriangle(i0, i4, i2); builder.AddTriangle(i2, i4, i6);
+		const vec3 c[8] = 
+		{
+			(vec3(layerCoords) + vec3(0.0f, 0.0f, 0.0f)) * stridef,
+			(vec3(layerCoords) + vec3(1.0f, 0.0f, 0.0f)) * stridef,
+			(vec3(layerCoords) + vec3(0.0f, 0.0f, 1.0f)) * stridef,
+			(vec3(layerCoords) + vec3(1.0f, 0.0f, 1.0f)) * stridef,
+
+			(vec3(layerCoords) + vec3(0.0f, 1.0f, 0.0f)) * stridef,
+			(vec3(layerCoords) + vec3(1.0f, 1.0f, 0.0f)) * stridef,
+			(vec3(layerCoords) + vec3(0.0f, 1.0f, 1.0f)) * stridef,
+			(vec3(layerCoords) + vec3(1.0f, 1.0f, 1.0f)) * stridef
+		};
+		const uint64 none = OctreeLayerTriangle::NoEdgeID;
+		auto addTriangle = [&out, &c, &normal, none](const uint32& a, const uint32& b, const uint32& d) 
+		{ 
+			out.push_back(OctreeLayerTriangle{ { none, none, none }, { c[a], c[b], c[d] }, normal });
+		};
+
+		addTriangle(0, 1, 2); addTriangle(2, 1, 3);
+		addTriangle(4, 6, 5); addTriangle(5, 6, 7);
+		addTriangle(0, 2, 1); addTriangle(2, 3, 1);
+		addTriangle(4, 5, 6); addTriangle(5, 7, 6);
+
+		addTriangle(2, 3, 6); addTriangle(6, 3, 7);
+		addTriangle(3, 1, 7); addTriangle(1, 5, 7);
+		addTriangle(2, 6, 3); addTriangle(6, 7, 3);
+		addTriangle(3, 7, 1); addTriangle(1, 7, 5);
+
+		addTriangle(1, 0, 4); addTriangle(1, 4, 5);
+		addTriangle(0, 2, 4); addTriangle(2, 6, 4);
+		addTriangle(1, 4, 0); addTriangle(1, 5, 4);
+		addTriangle(0, 4, 2); addTriangle(2, 4, 6);
 		return;
 	}
 	
 
-	// Smooth edges based on density
-#define VERT_LERP(x0, y0, z0, x1, y1, z1) highestLayer->OverrideEdge(vec3(layerCoords + uvec3(x0,y0,z0)) * stridef, vec3(layerCoords + uvec3(x1,y1,z1)) * stridef, highestLayerOffset, temp) ? temp : MC::VertexLerp(isoLevel, vec3(layerCoords + uvec3(x0,y0,z0)) * stridef, vec3(layerCoords + uvec3(x1,y1,z1)) * stridef, m_values[GetIndex(x0, y0, z0)], m_values[GetIndex(x1, y1, z1)])
-//#define VERT_LERP(x0, y0, z0, x1, y1, z1) highestLayer->OverrideEdge(vec3(layerCoords + uvec3(x0,y0,z0)) * stridef, vec3(layerCoords + uvec3(x1,y1,z1)) * stridef, highestLayerOffset, temp) ? temp : MC::VertexLerp(isoLevel, vec3(layerCoords + uvec3(x0,y0,z0)) * stridef, vec3(layerCoords + uvec3(x1,y1,z1)) * stridef, m_layer->GetVolume()->Get((layerCoords.x + x0) * stride, (layerCoords.y + y0) * stride, (layerCoords.z + z0) * stride), m_layer->GetVolume()->Get((layerCoords.x + x1) * stride, (layerCoords.y + y1) * stride, (layerCoords.z + z1) * stride))
 	vec3 temp;
 	vec3 edges[12];
+	uint64 edgeIds[12];
+	const uint32 strideLevel = m_layer->GetStrideLevel();
+	const bool canOverride = (m_layer != highestLayer && m_layer->GetVolume()->GetSeamMode() == LayeredSeamMode::EdgeOverride); // Edges as long as the highest layer's stride are never overridden
+	const bool canShareFine = (maxDepthOffset != 0 && m_layer->GetVolume()->GetSeamMode() == LayeredSeamMode::TransitionCells); // Neighbours can only be split if this node could have been
 	
 
-	if (MC::CaseRequiredEdges[m_caseIndex] & 1)
-		edges[0] = VERT_LERP(0, 0, 0, 1, 0, 0);
-	if (MC::CaseRequiredEdges[m_caseIndex] & 2)
-		edges[1] = VERT_LERP(1, 0, 0, 1, 0, 1);
-	if (MC::CaseRequiredEdges[m_caseIndex] & 4)
-		edges[2] = VERT_LERP(0, 0, 1, 1, 0, 1);
-	if (MC::CaseRequiredEdges[m_caseIndex] & 8)
-		edges[3] = VERT_LERP(0, 0, 0, 0, 0, 1);
-	if (MC::CaseRequiredEdges[m_caseIndex] & 16)
-		edges[4] = VERT_LERP(0, 1, 0, 1, 1, 0);
-	if (MC::CaseRequiredEdges[m_caseIndex] & 32)
-		edges[5] = VERT_LERP(1, 1, 0, 1, 1, 1);
-	if (MC::CaseRequiredEdges[m_caseIndex] & 64)
-		edges[6] = VERT_LERP(0, 1, 1, 1, 1, 1);
-	if (MC::CaseRequiredEdges[m_caseIndex] & 128)
-		edges[7] = VERT_LERP(0, 1, 0, 0, 1, 1);
-	if (MC::CaseRequiredEdges[m_caseIndex] & 256)
-		edges[8] = VERT_LERP(0, 0, 0, 0, 1, 0);
-	if (MC::CaseRequiredEdges[m_caseIndex] & 512)
-		edges[9] = VERT_LERP(1, 0, 0, 1, 1, 0);
-	if (MC::CaseRequiredEdges[m_caseIndex] & 1024)
-		edges[10] = VERT_LERP(1, 0, 1, 1, 1, 1);
-	if (MC::CaseRequiredEdges[m_caseIndex] & 2048)
-		edges[11] = VERT_LERP(0, 0, 1, 0, 1, 1);
+	// Smooth edges based on density
+	// (Also works out which edge the vertex ends up on, so it can be shared with any other node using that edge)
+	const uint32 requiredEdges = MC::CaseRequiredEdges[m_caseIndex];
+	for (uint32 e = 0; e < 12; ++e)
+		if (requiredEdges & (1 << e))
+		{
+			const uvec3 a = MC::CornerOffset(MC::EdgeCorners[e][0]);
+			const uvec3 b = MC::CornerOffset(MC::EdgeCorners[e][1]);
+			const vec3 start = vec3(layerCoords + a) * stridef;
+			const vec3 end = vec3(layerCoords + b) * stridef;
+
+			edgeIds[e] = MeshBuilderMinimal::GetEdgeID((layerCoords + a) * stride, MC::EdgeAxis[e], strideLevel);
+			if (canOverride && highestLayer->OverrideEdgeCached(start, end, highestLayerOffset, overrideCache, temp, edgeIds[e]))
+				edges[e] = temp;
+			else if (canShareFine && m_layer->IsEdgeSplitDiagonallyCached(layerCoords + a, MC::EdgeAxis[e], layerCoords, maxDepthOffset, highestLayer, overrideCache, temp, edgeIds[e]))
+				edges[e] = temp;
+			else
+				edges[e] = MC::VertexLerp(isoLevel, start, end, m_values[GetIndex(a.x, a.y, a.z)], m_values[GetIndex(b.x, b.y, b.z)]);
+		}
 
 
 
 	// Add triangles for this case
-	int8* caseEdges = MC::Cases[m_caseIndex];
+	const int8* caseEdges = MC::Cases[m_caseIndex];
 	while (*caseEdges != -1)
 	{
 		int8 edge0 = *(caseEdges++);
@@ -290,12 +488,145 @@ void OctreeLayerNode::BuildMesh(const float& isoLevel, MeshBuilderMinimal& build
 
 		// If normal is 0 it means the edge has been moved so the face is now a line
 		if (normalLengthSqrd != 0.0f && !std::isnan(normalLengthSqrd))
-		{
-			const uint32 a = builder.AddVertex(A, normal);
-			const uint32 b = builder.AddVertex(B, normal);
-			const uint32 c = builder.AddVertex(C, normal);
-			builder.AddTriangle(a, b, c);
-		}
+			out.push_back(OctreeLayerTriangle{ { edgeIds[edge0], edgeIds[edge1], edgeIds[edge2] }, { A, B, C }, normal });
+	}
+}
+
+/// Each face of a node, as the direction of the neighbour and the axes which the transition cell's u and v run along
+/// (Picked so u x v points towards the coarse neighbour, which makes the transition cell's triangles face out of the surface)
+static const struct
+{
+	ivec3 direction;
+	uint32 uAxis;
+	uint32 vAxis;
+} TransitionFaces[6] =
+{
+	{ ivec3(-1, 0, 0), 2, 1 },
+	{ ivec3(1, 0, 0), 1, 2 },
+	{ ivec3(0, -1, 0), 0, 2 },
+	{ ivec3(0, 1, 0), 2, 0 },
+	{ ivec3(0, 0, -1), 1, 0 },
+	{ ivec3(0, 0, 1), 0, 1 }
+};
+
+void OctreeLayerNode::BuildTransitionCells(const float& isoLevel, std::vector<OctreeLayerTriangle>& out, const uint32& maxDepthOffset, const OctreeLayer* highestLayer) const
+{
+	const int32 width = m_layer->GetLayerResolution() - 1;
+	const uvec3 layerCoords = m_layer->GetLocalCoords(m_id);
+
+	for (uint32 f = 0; f < 6; ++f)
+	{
+		const ivec3 neighbourCoords = ivec3(layerCoords) + TransitionFaces[f].direction;
+		if (neighbourCoords.x < 0 || neighbourCoords.y < 0 || neighbourCoords.z < 0 || neighbourCoords.x >= width || neighbourCoords.y >= width || neighbourCoords.z >= width)
+			continue;
+
+		// Only faces against a neighbour which is being meshed at this node's resolution need a transition cell
+		// (Most of a split node's neighbours are split too, so this rules out most faces before any voxels are read)
+		if (!m_layer->IsNodeDrawn(uvec3(neighbourCoords), layerCoords, maxDepthOffset, highestLayer))
+			continue;
+
+		// Find which of the face's borders (Bottom, Top, Left, Right) the neighbours meshed here move onto the fine vertex
+		const auto& face = TransitionFaces[f];
+		uvec3 faceStart = layerCoords;
+		uvec3 uStep(0, 0, 0);
+		uvec3 vStep(0, 0, 0);
+		for (uint32 axis = 0; axis < 3; ++axis)
+			if (face.direction[axis] > 0)
+				faceStart[axis] += 1;
+		uStep[face.uAxis] = 1;
+		vStep[face.vAxis] = 1;
+
+		const uvec3 borderStarts[4] = { faceStart, faceStart + vStep, faceStart, faceStart + uStep };
+		const uint32 borderAxes[4] = { face.uAxis, face.uAxis, face.vAxis, face.vAxis };
+		uint8 fineBorders = 0;
+		for (uint32 b = 0; b < 4; ++b)
+			if (m_layer->IsEdgeSplitDiagonally(borderStarts[b], borderAxes[b], layerCoords, maxDepthOffset, highestLayer))
+				fineBorders |= (1 << b);
+
+		BuildTransitionCell(isoLevel, out, f, fineBorders);
+	}
+}
+
+void OctreeLayerNode::BuildTransitionCell(const float& isoLevel, std::vector<OctreeLayerTriangle>& out, const uint32& faceIndex, const uint8& fineBorders) const
+{
+	const LayeredVolume* volume = m_layer->GetVolume();
+	const uint32 stride = m_layer->GetStride();
+	const uint32 strideLevel = m_layer->GetStrideLevel();
+	const uvec3 layerCoords = m_layer->GetLocalCoords(m_id);
+	const auto& face = TransitionFaces[faceIndex];
+
+	// Sample the face at this node's children's resolution
+	uvec3 origin = layerCoords * stride;
+	uvec3 uStep(0, 0, 0);
+	uvec3 vStep(0, 0, 0);
+	for (uint32 axis = 0; axis < 3; ++axis)
+		if (face.direction[axis] > 0)
+			origin[axis] += stride;
+	uStep[face.uAxis] = stride / 2;
+	vStep[face.vAxis] = stride / 2;
+
+	uvec3 positions[9];
+	float values[9];
+	uint32 caseIndex = 0;
+	for (uint32 i = 0; i < 9; ++i)
+	{
+		positions[i] = origin + uStep * (i % 3) + vStep * (i / 3);
+		values[i] = volume->Get(positions[i].x, positions[i].y, positions[i].z);
+		if (values[i] > isoLevel)
+			caseIndex |= (1 << i);
+	}
+
+	const MC::TransitionCase& transition = MC::GetTransitionCase(caseIndex);
+	if (transition.triangleCount == 0)
+		return;
+
+
+	// Build the vertices on the same edges as the nodes either side, so they are welded to them
+	vec3 vertices[MC::TransitionVertexCount];
+	uint64 edgeIds[MC::TransitionVertexCount];
+	for (uint32 v = 0; v < MC::TransitionVertexCount; ++v)
+	{
+		const uint32 a = MC::TransitionVertexSamples[v][0];
+		const uint32 b = MC::TransitionVertexSamples[v][1];
+		if (((caseIndex >> a) & 1) == ((caseIndex >> b) & 1))
+			continue;
+
+		const uint32 axis = (b - a < 3 ? face.uAxis : face.vAxis);
+		const uint32 level = (v < 12 ? strideLevel - 1 : strideLevel); // The first 12 are on the fine edges
+		edgeIds[v] = MeshBuilderMinimal::GetEdgeID(positions[a], axis, level);
+		vertices[v] = MC::VertexLerp(isoLevel, vec3(positions[a]), vec3(positions[b]), values[a], values[b]);
+	}
+
+	// Move the coarse vertex onto the fine one wherever the neighbour does, so the join along that border closes up
+	for (uint32 b = 0; b < 4; ++b)
+	{
+		const bool startInside = ((caseIndex >> MC::TransitionBorders[b][0]) & 1) != 0;
+		const bool middleInside = ((caseIndex >> MC::TransitionBorders[b][1]) & 1) != 0;
+		const bool endInside = ((caseIndex >> MC::TransitionBorders[b][2]) & 1) != 0;
+		if ((fineBorders & (1 << b)) == 0 || startInside == endInside)
+			continue;
+
+		const uint32 coarse = MC::TransitionBorders[b][5];
+		const uint32 fine = (startInside != middleInside ? MC::TransitionBorders[b][3] : MC::TransitionBorders[b][4]);
+		vertices[coarse] = vertices[fine];
+		edgeIds[coarse] = edgeIds[fine];
+	}
+
+	for (uint32 t = 0; t < transition.triangleCount; ++t)
+	{
+		const uint8* indices = transition.triangles[t];
+		const vec3& A = vertices[indices[0]];
+		const vec3& B = vertices[indices[1]];
+		const vec3& C = vertices[indices[2]];
+
+		if (A == B || A == C || B == C)
+			continue;
+
+		// Flat triangles are kept, as they join the middle fine vertex onto the others when they line up along the face
+		// (Dropping them leaves the fine edges either side of it open, even though there's no gap)
+		const vec3 normal = glm::cross(B - A, C - A);
+		if (!std::isnan(dot(normal, normal)))
+			out.push_back(OctreeLayerTriangle{ { edgeIds[indices[0]], edgeIds[indices[1]], edgeIds[indices[2]] }, { A, B, C }, normal });
 	}
 }
 
@@ -309,39 +640,38 @@ void OctreeLayerNode::FetchChildren(std::array<OctreeLayerNode*, 8>& outList) co
 	}
 }
 
-void OctreeLayerNode::RecalculateStats()
+void OctreeLayerNode::MarkStatsStale()
 {
-	RecalculateMergeDepth();
-
-	// Notify parent
-	OctreeLayerNode* parent;
-	if (m_id != 0 && m_layer->AttemptNodeFetch(GetParentID(), parent, false))
-		parent->RecalculateStats();
-
-	/*
-	// Calculate average
-	m_average = 0.0f;
-	for (int i = 0; i < 8; ++i)
-		m_average += m_values[i];
-	m_average /= 8.0f;
+	// Walk up until reaching a node which is already waiting to be recalculated
+	OctreeLayerNode* node = this;
+	while (!node->bStatsStale)
+	{
+		node->bStatsStale = true;
+		node->m_layer->QueueStaleNode(node->m_id);
 
-	// Calulcate std deviation
-	float sum = 0.0f;
-	for (int i = 0; i < 8; ++i)
-		sum += std::pow(m_values[i] - m_average, 2);
-	m_stdDeviation = std::sqrt(sum / 8.0f);
-	*/
+		if (node->m_id == 0 || !node->m_layer->AttemptNodeFetch(node->GetParentID(), node, false))
+			break;
+	}
 }
 
 void OctreeLayerNode::RecalculateMergeDepth()
 {
 	// Recalculate how deep this node can go before loosing too much detail (Assumes children are correct)
 	m_safeQualityDepth = 0;
+	m_pinchedEdges = 0;
+	bHasMultipleIntersections = false;
+	bStatsStale = false;
 
 	// Not point doing further checks if there is not children
 	if (m_childFlags == 0)
 		return;
 
+	// The middle of each edge is one of the children's corners, so any edits to it will have made this stale
+	const uvec3 coords = m_layer->GetLocalCoords(m_id);
+	for (uint32 e = 0; e < 12; ++e)
+		if ((MC::CaseRequiredEdges[m_caseIndex] & (1 << e)) == 0 && m_layer->IsEdgePinched(coords + MC::CornerOffset(MC::EdgeCorners[e][0]), MC::EdgeAxis[e]))
+			m_pinchedEdges |= (1 << e);
+
 	// Lowest allowed size, so cannot merge
 	if (m_layer->GetNodeResolution() == 2)
 		return;
@@ -351,6 +681,15 @@ void OctreeLayerNode::RecalculateMergeDepth()
 	std::array<OctreeLayerNode*, 8> children;
 	FetchChildren(children);
 
+	// Children have already cached their own subtrees, so only their edges need checking here
+	bHasMultipleIntersections = CheckChildIntersections(children);
+	for (OctreeLayerNode* child : children)
+		if (child && child->bHasMultipleIntersections)
+		{
+			bHasMultipleIntersections = true;
+			break;
+		}
+
 	// Check children are all simple case
 	bool childrenSimple = true;
 	for (OctreeLayerNode* child : children)
@@ -380,18 +719,9 @@ void OctreeLayerNode::RecalculateMergeDepth()
 	//return m_average < m_layer->GetVolume()->GetIsoLevel() && m_stdDeviation > 0.1;
 }
 
-bool OctreeLayerNode::IsSimpleCase() const 
-{	
-	static std::unordered_set<uint8> simpleCases({ 1, 2, 3, 4, 6, 7, 8, 9, 11, 12, 13, 14, 15, 16, 17, 19, 20, 23, 25, 27, 29, 31, 32, 34, 35, 38, 39, 40, 43, 46, 47, 48, 49, 50, 51, 54, 55, 57, 59, 63, 64, 65, 68, 70, 71, 76, 77, 78, 79, 96, 98, 99, 100, 102, 103, 108, 110, 111, 112, 113, 114, 115, 116, 118, 119, 125, 127, 128, 130, 136, 137, 139, 140, 141, 142, 143, 144, 145, 147, 152, 153, 155, 156, 157, 159, 176, 177, 178, 179, 184, 185, 187, 190, 191, 192, 196, 198, 200, 201, 204, 205, 206, 207, 208, 209, 212, 215, 216, 217, 220, 221, 223, 224, 226, 228, 230, 232, 235, 236, 238, 239, 240, 241, 242, 243, 244, 246, 247, 248, 249, 251, 252, 253, 254, });
-	return simpleCases.find(m_caseIndex) != simpleCases.end();
-}
-
-bool OctreeLayerNode::HasMultipleIntersections() const 
+bool OctreeLayerNode::CheckChildIntersections(const std::array<OctreeLayerNode*, 8>& children) const
 {
-	//*
 	// Check all possible edges inside and outside this node (For it's children)
-	std::array<OctreeLayerNode*, 8> children;
-	FetchChildren(children);
 
 #define CHECK_EDGE(child0, child1, edge) if(children[child0] && children[child1] && (MC::CaseRequiredEdges[children[child0]->m_caseIndex] & (1 << edge)) != 0 && (MC::CaseRequiredEdges[children[child1]->m_caseIndex] & (1 << edge)) != 0) return true;
 
@@ -463,11 +793,8 @@ bool OctreeLayerNode::HasMultipleIntersections() const
 		CHECK_EDGE(4, 7, 5);
 		CHECK_EDGE(4, 7, 7);
 	}
-	
-	for (OctreeLayerNode* child : children)
-		if (child && child->HasMultipleIntersections())
-			return true;
 
+#undef CHECK_EDGE
 	return false;
 }
 
@@ -489,13 +816,14 @@ OctreeLayer::OctreeLayer(LayeredVolume* volume, const uint32& depth, const uint3
 	m_startIndex(depth == 0 ? 0 : (pow(8, depth) - 1) / 7), // Total nodes for a given height is (8^h - 1)/7
 	m_endIndex(m_startIndex + (uint32)pow(8U, depth) - 1)
 {
-}
-
-OctreeLayer::~OctreeLayer() 
-{
-	// Delete nodes
-	for (const auto& pair : m_nodes)
-		delete pair.second;
+	for (uint32 stride = GetStride(); stride > 1; stride >>= 1)
+		m_strideLevel++;
+
+	// The coarse layers are small enough to hold a handle for every possible node
+	const uint32 width = m_layerResolution - 1;
+	bIsDense = ((uint64)width * width * width <= MaxDenseNodes);
+	if (bIsDense)
+		m_denseHandles.resize(width * width * width, NodePool<OctreeLayerNode>::InvalidHandle);
 }
 
 bool OctreeLayer::HandlePush(const uint32& x, const uint32& y, const uint32& z, const float& value) 
@@ -536,57 +864,419 @@ bool OctreeLayer::PushValueOntoNode(const uvec3& localCoords, const ivec3& offse
 
 
 	// Find node
-	OctreeLayerNode* node;
-	const bool shouldCreateNode = (value > m_volume->GetIsoLevel());
-	if (AttemptNodeFetch(id, node, shouldCreateNode)) 
+	uint32 handle = FindHandle(id);
+	if (handle == NodePool<OctreeLayerNode>::InvalidHandle)
 	{
-		const uint32 corner = -offset.x + 2 * (-offset.y + 2 * -offset.z); // The id of the corner of this value
-		node->Push(corner, m_volume, value);
-
-		// Node is now fully out the surface and has no children, so remove it
-		if (node->FlaggedForDeletion())
-		{
-			m_nodes.erase(id);
-			node->OnSafeDestroy();
-			delete node;
+		// Only create the node, if this value is inside the surface
+		if (!(value > m_volume->GetIsoLevel()))
 			return false;
-		}
 
-		return true;
+		handle = CreateNode(id, this);
+
+		// Neighbours may need to match their seams up with this node
+		MarkCellsDirty(nodeCoords, nodeCoords);
 	}
 
-	return false;
+	OctreeLayerNode* node = m_nodes.Get(handle);
+	const uint32 corner = -offset.x + 2 * (-offset.y + 2 * -offset.z); // The id of the corner of this value
+	node->Push(corner, m_volume, value);
+
+	// Node is now fully out the surface and has no children, so remove it
+	if (node->FlaggedForDeletion())
+	{
+		node->OnSafeDestroy();
+		DestroyNode(id, handle);
+		return false;
+	}
+
+	return true;
+}
+
+void OctreeLayer::DestroyNode(const uint32& id, const uint32& handle)
+{
+	MarkBlockDirty(handle);
+
+	// Neighbours may have been overriding their edges to match this node
+	const uvec3 coords = GetLocalCoords(id);
+	MarkCellsDirty(coords, coords);
+
+	if (bIsDense)
+		m_denseHandles[id - m_startIndex] = NodePool<OctreeLayerNode>::InvalidHandle;
+	else
+		m_sparseHandles.erase(id);
+
+	m_nodes.Destroy(handle);
+}
+
+void OctreeLayer::ClearNodes()
+{
+	m_nodes.Clear();
+
+	if (bIsDense)
+		std::fill(m_denseHandles.begin(), m_denseHandles.end(), NodePool<OctreeLayerNode>::InvalidHandle);
+	else
+		m_sparseHandles.clear();
+
+	for (BuildBlock& block : m_buildBlocks)
+		m_arena.Release(block.range);
+	m_buildBlocks.clear();
+	m_sharedEdges.clear();
+	m_sharedPositions.clear();
+	m_changedEdges.clear();
+	m_changedPositions.clear();
+
+	m_staleNodes.clear();
+	rebuildFlag = true;
+}
+
+uint64 OctreeLayer::GetMemoryUsage() const
+{
+	uint64 lookupSize;
+	if (bIsDense)
+		lookupSize = m_denseHandles.capacity() * sizeof(uint32);
+	else
+		// Each entry is a separate allocation holding the pair, the next pointer and the cached hash
+		lookupSize = m_sparseHandles.bucket_count() * sizeof(void*) + m_sparseHandles.size() * (sizeof(std::pair<const uint32, uint32>) + sizeof(void*) + sizeof(size_t));
+
+	uint64 cacheSize = 0;
+	for (const BuildBlock& block : m_buildBlocks)
+		cacheSize += block.triangles.capacity() * sizeof(OctreeLayerTriangle);
+
+	return m_nodes.GetMemoryUsage() + lookupSize + cacheSize;
 }
 
-bool OctreeLayer::BuildMesh(MeshBuilderMinimal& builder, const uint32& maxDepthOffset)
+void OctreeLayer::BuildNodes()
 {
-	// Check lower layers to see if need to rebuild
-	if (!rebuildFlag)
+	const uint32 width = m_layerResolution - 1;
+	const uint32 stride = GetStride();
+	const float isoLevel = m_volume->GetIsoLevel();
+	const LayeredVolume* volume = m_volume;
+
+	// Cells which start outside of the volume (And all of their children) only see UNKNOWN_BUILD_VALUE,
+	// so they can be skipped entirely, as long as that isn't inside the surface
+	uvec3 cellCount(width, width, width);
+	if (!(UNKNOWN_BUILD_VALUE > isoLevel))
+		cellCount = glm::min(cellCount, (volume->GetResolution() + uvec3(stride - 1, stride - 1, stride - 1)) / stride);
+
+	// Everything a node needs to be created
+	struct PendingNode
 	{
-		OctreeLayer* layer = nextLayer;
+		uint32 id;
+		std::array<float, 8> values;
+		uint8 childFlags;
+	};
+
+	// Find the nodes a z-slice at a time across the workers
+	// (Nothing is inserted into the layer until every slice is done, so the workers only ever read from the next layer)
+	std::vector<std::vector<PendingNode>> slices(cellCount.z);
+	ThreadPool::GetShared().ParallelFor(cellCount.z, [this, &slices, &cellCount, stride, isoLevel, volume](uint32 z)
+	{
+		std::vector<PendingNode>& slice = slices[z];
+		std::array<float, 8> values;
+		OctreeLayerNode* child;
 
-		for (uint32 i = 0; i < maxDepthOffset; ++i) 
+		for (uint32 y = 0; y < cellCount.y; ++y)
 		{
-			if (layer == nullptr)
-				break;
-			if (layer->rebuildFlag)
+			// Slide along the row, so each corner is only fetched once
+			float left00 = volume->Get(0, y * stride, z * stride);
+			float left10 = volume->Get(0, (y + 1) * stride, z * stride);
+			float left01 = volume->Get(0, y * stride, (z + 1) * stride);
+			float left11 = volume->Get(0, (y + 1) * stride, (z + 1) * stride);
+
+			for (uint32 x = 0; x < cellCount.x; ++x)
 			{
-				rebuildFlag = true;
-				break;
+				values[CHILD_OFFSET_BK_BOT_L] = left00;
+				values[CHILD_OFFSET_BK_TOP_L] = left10;
+				values[CHILD_OFFSET_FR_BOT_L] = left01;
+				values[CHILD_OFFSET_FR_TOP_L] = left11;
+				values[CHILD_OFFSET_BK_BOT_R] = left00 = volume->Get((x + 1) * stride, y * stride, z * stride);
+				values[CHILD_OFFSET_BK_TOP_R] = left10 = volume->Get((x + 1) * stride, (y + 1) * stride, z * stride);
+				values[CHILD_OFFSET_FR_BOT_R] = left01 = volume->Get((x + 1) * stride, y * stride, (z + 1) * stride);
+				values[CHILD_OFFSET_FR_TOP_R] = left11 = volume->Get((x + 1) * stride, (y + 1) * stride, (z + 1) * stride);
+
+				uint8 childFlags = 0;
+				if (nextLayer != nullptr)
+				{
+					const uvec3 childCoords(x * 2, y * 2, z * 2);
+					for (uint32 i = 0; i < 8; ++i)
+						if (nextLayer->AttemptNodeOffsetFetch(childCoords, ivec3(i & 1, (i >> 1) & 1, (i >> 2) & 1), child))
+							childFlags |= (1 << i);
+				}
+
+				// Only nodes which are on/inside the surface or have children are kept
+				bool isInside = false;
+				for (const float& value : values)
+					isInside |= (value > isoLevel);
+
+				if (isInside || childFlags != 0)
+					slice.push_back(PendingNode{ GetID(x, y, z), values, childFlags });
 			}
-			layer = layer->nextLayer;
 		}
+	});
+
+
+	uint32 nodeCount = 0;
+	for (const auto& slice : slices)
+		nodeCount += slice.size();
+
+	// Create the nodes in id order, so the slabs are laid out in the same order as the volume
+	m_nodes.Reserve(m_nodes.GetCount() + nodeCount);
+	if (!bIsDense)
+		m_sparseHandles.reserve(m_sparseHandles.size() + nodeCount);
+
+	std::vector<std::vector<OctreeLayerNode*>> created(slices.size());
+	for (uint32 z = 0; z < slices.size(); ++z)
+	{
+		created[z].reserve(slices[z].size());
+		for (const PendingNode& pending : slices[z])
+			created[z].push_back(m_nodes.Get(CreateNode(pending.id, this, pending.values, pending.childFlags)));
+		std::vector<PendingNode>().swap(slices[z]);
+	}
+
+
+	// Children are all finished, so merge depths can be calculated in any order
+	ThreadPool::GetShared().ParallelFor(created.size(), [&created](uint32 z)
+	{
+		for (OctreeLayerNode* node : created[z])
+			node->RecalculateMergeDepth();
+	});
+
+	rebuildFlag = true;
+}
+
+bool OctreeLayer::BuildMesh(Mesh* target, const uint32& maxDepthOffset)
+{
+	if (!RequiresRebuild(maxDepthOffset))
+		return false;
+
+	PatchArena(maxDepthOffset);
+	UploadArena(target);
+	return true;
+}
+
+void OctreeLayer::BuildNodeMeshes(MeshBuilderMinimal& builder, const uint32& maxDepthOffset)
+{
+	RebuildDirtyBlocks(maxDepthOffset);
+
+	// Welds any vertices on edges shared between blocks
+	builder.Reserve(m_lastTriangleCount); // Edits rarely change the size of the mesh by much
+	for (const BuildBlock& block : m_buildBlocks)
+		builder.Append(block.builder);
+
+	m_lastTriangleCount = builder.GetIndexCount() / 3;
+}
+
+void OctreeLayer::PatchArena(const uint32& maxDepthOffset)
+{
+	RebuildDirtyBlocks(maxDepthOffset);
+
+	// Only the blocks which have been rebuilt are rewritten
+	for (uint32 i = 0; i < m_buildBlocks.size(); ++i)
+	{
+		BuildBlock& block = m_buildBlocks[i];
+		if (!block.bIsArenaStale)
+			continue;
+
+		RemoveSharedVertices(i);
+		m_arena.Write(block.range, block.builder);
+		AddSharedVertices(i);
+	}
+
+	// Weld any vertices which the rewritten blocks share with their neighbours
+	WeldSharedVertices(m_sharedEdges, m_changedEdges, m_buildBlocks, m_arena);
+	WeldSharedVertices(m_sharedPositions, m_changedPositions, m_buildBlocks, m_arena);
+
+	for (BuildBlock& block : m_buildBlocks)
+		block.bIsArenaStale = false;
+
+
+	// Close up the gaps once they start to build up
+	if (m_arena.ShouldCompact())
+	{
+		std::vector<MeshArena::Range*> ranges;
+		ranges.reserve(m_buildBlocks.size());
+		for (BuildBlock& block : m_buildBlocks)
+			ranges.push_back(&block.range);
+		m_arena.Compact(ranges);
+	}
+}
+
+void OctreeLayer::RebuildDirtyBlocks(const uint32& maxDepthOffset)
+{
+	// Merge decisions depend on the depth offset, so none of the caches can be used
+	if (maxDepthOffset != m_cachedDepthOffset)
+	{
+		MarkAllDirty();
+		m_cachedDepthOffset = maxDepthOffset;
+	}
+
+	// Any new blocks start off dirty
+	const uint32 blockCount = (m_nodes.GetSlotCount() + NodesPerBuildJob - 1) / NodesPerBuildJob;
+	m_buildBlocks.resize(blockCount);
+
+	ThreadPool::GetShared().ParallelFor(blockCount, [this, maxDepthOffset](uint32 i)
+	{
+		if (m_buildBlocks[i].bIsDirty)
+			RebuildBlock(i, maxDepthOffset);
+	});
+
+	rebuildFlag = false;
+}
+
+void OctreeLayer::AddSharedVertices(const uint32& index)
+{
+	BuildBlock& block = m_buildBlocks[index];
+	const MeshBuilderMinimal& builder = block.builder;
+
+	std::vector<uint64> edgeIds;
+	builder.GetVertexEdgeIDs(edgeIds);
+
+	// Vertices are shared in the same way Append would weld them
+	for (uint32 v = 0; v < edgeIds.size(); ++v)
+	{
+		if (edgeIds[v] != OctreeLayerTriangle::NoEdgeID)
+		{
+			AddSharedUser(m_sharedEdges, edgeIds[v], uvec2(index, v), m_changedEdges);
+			block.sharedEdges.push_back(edgeIds[v]);
+		}
+		else if (builder.IsWeldedByPosition(v))
+		{
+			AddSharedUser(m_sharedPositions, builder.GetVertex(v), uvec2(index, v), m_changedPositions);
+			block.sharedPositions.push_back(builder.GetVertex(v));
+		}
+	}
+}
+
+void OctreeLayer::RemoveSharedVertices(const uint32& index)
+{
+	BuildBlock& block = m_buildBlocks[index];
+
+	for (const uint64& edgeId : block.sharedEdges)
+		RemoveSharedUser(m_sharedEdges, edgeId, index, m_changedEdges);
+	for (const vec3& position : block.sharedPositions)
+		RemoveSharedUser(m_sharedPositions, position, index, m_changedPositions);
+
+	block.sharedEdges.clear();
+	block.sharedPositions.clear();
+}
+
+void OctreeLayer::RebuildBlock(const uint32& index, const uint32& maxDepthOffset)
+{
+	BuildBlock& block = m_buildBlocks[index];
+	const float isoLevel = m_volume->GetIsoLevel();
+
+	// Neighbouring nodes share most of their edges, so only resolve each seam once per block
+	// (Kept per thread, as blocks are built at the same time, and cleared for each block as other layers may use the same thread)
+	static thread_local EdgeOverrideCache overrideCache;
+	overrideCache.Clear();
+
+	// Re-mesh any dirty nodes, keeping the cached triangles for the rest
+	std::vector<OctreeLayerTriangle> triangles;
+	triangles.reserve(block.triangles.size());
+
+	m_nodes.ForEachInRange(index * NodesPerBuildJob, (index + 1) * NodesPerBuildJob, [this, &block, &triangles, isoLevel, maxDepthOffset](OctreeLayerNode* node)
+	{
+		const uint32 start = triangles.size();
+
+		if (node->IsDirty())
+			node->BuildMesh(isoLevel, triangles, maxDepthOffset, this, maxDepthOffset, overrideCache);
+		else
+			triangles.insert(triangles.end(), block.triangles.begin() + node->GetCacheStart(), block.triangles.begin() + node->GetCacheStart() + node->GetCacheCount());
+
+		node->SetCache(start, triangles.size() - start);
+	});
+
+	block.triangles.swap(triangles);
+
+
+	// Weld the triangles back together
+	MeshBuilderMinimal& builder = block.builder;
+	builder.Clear();
+	builder.Reserve(block.triangles.size());
+	WeldTriangles(block.triangles.data(), block.triangles.size(), builder);
+
+	block.bIsDirty = false;
+	block.bIsArenaStale = true;
+}
+
+void OctreeLayer::MarkDirty(const uint32& x, const uint32& y, const uint32& z)
+{
+	const uint32 stride = GetStride();
+	const uint32 width = m_layerResolution - 1;
+	const uvec3 coords(x, y, z);
+
+	// Find the cells whose corners/edges could hold this voxel
+	uvec3 lower;
+	uvec3 upper;
+	for (uint32 i = 0; i < 3; ++i)
+	{
+		const uint32 ceilCell = (coords[i] + stride - 1) / stride;
+		lower[i] = ceilCell >= 1 ? ceilCell - 1 : 0;
+		upper[i] = glm::min(coords[i] / stride, width - 1);
 	}
 
-	// Force build to happen
-	if (rebuildFlag)
+	// Nodes only ever read voxels which are inside of a node, so if none of these exist nothing can have changed
+	// (If any deeper nodes held this voxel, their parents in this layer would too)
+	bool isInsideNode = false;
+	for (uint32 cz = lower.z; cz <= upper.z && !isInsideNode; ++cz)
+		for (uint32 cy = lower.y; cy <= upper.y && !isInsideNode; ++cy)
+			for (uint32 cx = lower.x; cx <= upper.x && !isInsideNode; ++cx)
+				isInsideNode = (FindHandle(GetID(cx, cy, cz)) != NodePool<OctreeLayerNode>::InvalidHandle);
+
+	if (isInsideNode)
+		MarkCellsDirty(lower, upper);
+}
+
+void OctreeLayer::MarkCellsDirty(const uvec3& lower, const uvec3& upper)
+{
+	const uint32 width = m_layerResolution - 1;
+	uint32 margin = 1;
+	if (m_volume->GetSeamMode() == LayeredSeamMode::TransitionCells && m_cachedDepthOffset != 0)
+		margin = (m_cachedDepthOffset > 1 ? 4 : 2);
+	const uvec3 start(lower.x > margin ? lower.x - margin : 0, lower.y > margin ? lower.y - margin : 0, lower.z > margin ? lower.z - margin : 0);
+	const uvec3 end = glm::min(upper + uvec3(margin, margin, margin), uvec3(width - 1, width - 1, width - 1));
+
+	for (uint32 cz = start.z; cz <= end.z; ++cz)
+		for (uint32 cy = start.y; cy <= end.y; ++cy)
+			for (uint32 cx = start.x; cx <= end.x; ++cx)
+			{
+				const uint32 handle = FindHandle(GetID(cx, cy, cz));
+				if (handle == NodePool<OctreeLayerNode>::InvalidHandle)
+					continue;
+
+				OctreeLayerNode* node = m_nodes.Get(handle);
+				if (!node->IsDirty())
+				{
+					node->MarkDirty();
+					MarkBlockDirty(handle);
+				}
+			}
+}
+
+void OctreeLayer::MarkAllDirty()
+{
+	m_nodes.ForEach([](OctreeLayerNode* node) { node->MarkDirty(); });
+
+	for (BuildBlock& block : m_buildBlocks)
+		block.bIsDirty = true;
+	rebuildFlag = true;
+}
+
+void OctreeLayer::RecalculateStaleNodes()
+{
+	for (const uint32& id : m_staleNodes)
 	{
-		for (const auto& node : m_nodes)
-			node.second->BuildMesh(m_volume->GetIsoLevel(), builder, maxDepthOffset, this, maxDepthOffset);
-		rebuildFlag = false;
-		return true;
+		// Node may have been removed or already recalculated (If queued more than once)
+		const uint32 handle = FindHandle(id);
+		if (handle == NodePool<OctreeLayerNode>::InvalidHandle)
+			continue;
+
+		OctreeLayerNode* node = m_nodes.Get(handle);
+		if (node->IsStatsStale())
+			node->RecalculateMergeDepth();
 	}
-	return false;
+
+	m_staleNodes.clear();
 }
 
 bool OctreeLayer::ProjectEdgeOntoFace(const uvec3& a, const uvec3& b, const uint32& maxDepthOffset, vec3& overrideOutput, const uvec3& c00, const uvec3& c01, const uvec3& c10, const uvec3& c11) const
@@ -620,7 +1310,7 @@ bool OctreeLayer::ProjectEdgeOntoFace(const uvec3& a, const uvec3& b, const uint
 	
 	// Unexpected number of edges, so check next layer
 	if (edges.size() != 2)
-		return false;// (nextLayer != nullptr ? nextLayer->OverrideEdge(a, b, maxDepthOffset - 1, overrideOutput) : false);
+		return false;// (nextLayer != nullptr ? nextLayer->OverrideEdge(a, b, maxDepthOffset - 1, overrideOutput, overrideID) : false);
 	
 
 	// Project point onto line through vector rejection method
@@ -634,7 +1324,7 @@ bool OctreeLayer::ProjectEdgeOntoFace(const uvec3& a, const uvec3& b, const uint
 	return true;
 }
 
-bool OctreeLayer::OverrideEdge(const uvec3& a, const uvec3& b, const uint32& maxDepthOffset, vec3& overrideOutput) const
+bool OctreeLayer::OverrideEdge(const uvec3& a, const uvec3& b, const uint32& maxDepthOffset, vec3& overrideOutput, uint64& overrideID) const
 {
 	// At lowest depth, so cannot override edge
 	if (maxDepthOffset == 0)
@@ -660,7 +1350,7 @@ bool OctreeLayer::OverrideEdge(const uvec3& a, const uvec3& b, const uint32& max
 
 		// Edge is entirely encased in this layer
 		if (remA.y != 0 && remA.z != 0)
-			return (nextLayer != nullptr ? nextLayer->OverrideEdge(a, b, maxDepthOffset - 1, overrideOutput) : false);
+			return (nextLayer != nullptr ? nextLayer->OverrideEdge(a, b, maxDepthOffset - 1, overrideOutput, overrideID) : false);
 
 
 		// Edge is inline with edge at this res
@@ -682,11 +1372,12 @@ bool OctreeLayer::OverrideEdge(const uvec3& a, const uvec3& b, const uint32& max
 				// TODO - Check there is an edge at this res
 
 				overrideOutput = MC::VertexLerp(isolevel, layerA, layerB, m_volume->Get(layerA.x, layerA.y, layerA.z), m_volume->Get(layerB.x, layerB.y, layerB.z));
+				overrideID = MeshBuilderMinimal::GetEdgeID(layerA, 0, m_strideLevel);
 				return true;
 			}
 			// Edge is not locked to this res
 			else
-				return (nextLayer != nullptr ? nextLayer->OverrideEdge(a, b, maxDepthOffset - 1, overrideOutput) : false);
+				return (nextLayer != nullptr ? nextLayer->OverrideEdge(a, b, maxDepthOffset - 1, overrideOutput, overrideID) : false);
 		}
 
 		// Falls on y-face 
@@ -709,7 +1400,7 @@ bool OctreeLayer::OverrideEdge(const uvec3& a, const uvec3& b, const uint32& max
 			}
 			// Edge is not locked to this res
 			else
-				return (nextLayer != nullptr ? nextLayer->OverrideEdge(a, b, maxDepthOffset - 1, overrideOutput) : false);
+				return (nextLayer != nullptr ? nextLayer->OverrideEdge(a, b, maxDepthOffset - 1, overrideOutput, overrideID) : false);
 		}
 
 		// Falls on z-face 
@@ -732,7 +1423,7 @@ bool OctreeLayer::OverrideEdge(const uvec3& a, const uvec3& b, const uint32& max
 			}
 			// Edge is not locked to this res
 			else
-				return (nextLayer != nullptr ? nextLayer->OverrideEdge(a, b, maxDepthOffset - 1, overrideOutput) : false);
+				return (nextLayer != nullptr ? nextLayer->OverrideEdge(a, b, maxDepthOffset - 1, overrideOutput, overrideID) : false);
 		}
 	}
 
@@ -747,7 +1438,7 @@ bool OctreeLayer::OverrideEdge(const uvec3& a, const uvec3& b, const uint32& max
 
 		// Edge is entirely encased in this layer
 		if (remA.x != 0 && remA.z != 0)
-			return (nextLayer != nullptr ? nextLayer->OverrideEdge(a, b, maxDepthOffset - 1, overrideOutput) : false);
+			return (nextLayer != nullptr ? nextLayer->OverrideEdge(a, b, maxDepthOffset - 1, overrideOutput, overrideID) : false);
 
 
 		// Edge is inline with edge at this res
@@ -769,11 +1460,12 @@ bool OctreeLayer::OverrideEdge(const uvec3& a, const uvec3& b, const uint32& max
 				// TODO - Check there is an edge at this res
 
 				overrideOutput = MC::VertexLerp(isolevel, layerA, layerB, m_volume->Get(layerA.x, layerA.y, layerA.z), m_volume->Get(layerB.x, layerB.y, layerB.z));
+				overrideID = MeshBuilderMinimal::GetEdgeID(layerA, 1, m_strideLevel);
 				return true;
 			}
 			// Edge is not locked to this res
 			else
-				return (nextLayer != nullptr ? nextLayer->OverrideEdge(a, b, maxDepthOffset - 1, overrideOutput) : false);
+				return (nextLayer != nullptr ? nextLayer->OverrideEdge(a, b, maxDepthOffset - 1, overrideOutput, overrideID) : false);
 		}
 
 		// Falls on x-face 
@@ -796,7 +1488,7 @@ bool OctreeLayer::OverrideEdge(const uvec3& a, const uvec3& b, const uint32& max
 			}
 			// Edge is not locked to this res
 			else
-				return (nextLayer != nullptr ? nextLayer->OverrideEdge(a, b, maxDepthOffset - 1, overrideOutput) : false);
+				return (nextLayer != nullptr ? nextLayer->OverrideEdge(a, b, maxDepthOffset - 1, overrideOutput, overrideID) : false);
 		}
 
 		// Falls on z-face 
@@ -819,7 +1511,7 @@ bool OctreeLayer::OverrideEdge(const uvec3& a, const uvec3& b, const uint32& max
 			}
 			// Edge is not locked to this res
 			else
-				return (nextLayer != nullptr ? nextLayer->OverrideEdge(a, b, maxDepthOffset - 1, overrideOutput) : false);
+				return (nextLayer != nullptr ? nextLayer->OverrideEdge(a, b, maxDepthOffset - 1, overrideOutput, overrideID) : false);
 		}
 	}
 
@@ -834,7 +1526,7 @@ bool OctreeLayer::OverrideEdge(const uvec3& a, const uvec3& b, const uint32& max
 
 		// Edge is entirely encased in this layer
 		if (remA.x != 0 && remA.y != 0)
-			return (nextLayer != nullptr ? nextLayer->OverrideEdge(a, b, maxDepthOffset - 1, overrideOutput) : false);
+			return (nextLayer != nullptr ? nextLayer->OverrideEdge(a, b, maxDepthOffset - 1, overrideOutput, overrideID) : false);
 
 
 		// Edge is inline with edge at this res
@@ -856,11 +1548,12 @@ bool OctreeLayer::OverrideEdge(const uvec3& a, const uvec3& b, const uint32& max
 				// TODO - Check there is an edge at this res
 
 				overrideOutput = MC::VertexLerp(isolevel, layerA, layerB, m_volume->Get(layerA.x, layerA.y, layerA.z), m_volume->Get(layerB.x, layerB.y, layerB.z));
+				overrideID = MeshBuilderMinimal::GetEdgeID(layerA, 2, m_strideLevel);
 				return true;
 			}
 			// Edge is not locked to this res
 			else
-				return (nextLayer != nullptr ? nextLayer->OverrideEdge(a, b, maxDepthOffset - 1, overrideOutput) : false);
+				return (nextLayer != nullptr ? nextLayer->OverrideEdge(a, b, maxDepthOffset - 1, overrideOutput, overrideID) : false);
 		}
 
 		// Falls on x-face 
@@ -883,7 +1576,7 @@ bool OctreeLayer::OverrideEdge(const uvec3& a, const uvec3& b, const uint32& max
 			}
 			// Edge is not locked to this res
 			else
-				return (nextLayer != nullptr ? nextLayer->OverrideEdge(a, b, maxDepthOffset - 1, overrideOutput) : false);
+				return (nextLayer != nullptr ? nextLayer->OverrideEdge(a, b, maxDepthOffset - 1, overrideOutput, overrideID) : false);
 		}
 
 		// Falls on y-face 
@@ -907,13 +1600,13 @@ bool OctreeLayer::OverrideEdge(const uvec3& a, const uvec3& b, const uint32& max
 			}
 			// Edge is not locked to this res
 			else
-				return (nextLayer != nullptr ? nextLayer->OverrideEdge(a, b, maxDepthOffset - 1, overrideOutput) : false);
+				return (nextLayer != nullptr ? nextLayer->OverrideEdge(a, b, maxDepthOffset - 1, overrideOutput, overrideID) : false);
 		}
 	}
 
 
 	// Wasn't overridden at this layer, so pass it to the next
-	return (nextLayer != nullptr ? nextLayer->OverrideEdge(a, b, maxDepthOffset - 1, overrideOutput) : false);
+	return (nextLayer != nullptr ? nextLayer->OverrideEdge(a, b, maxDepthOffset - 1, overrideOutput, overrideID) : false);
 }
 
 bool OctreeLayer::AttemptNodeOffsetFetch(const uvec3& localCoords, const ivec3& offset, OctreeLayerNode*& outNode) const
@@ -930,14 +1623,203 @@ bool OctreeLayer::AttemptNodeOffsetFetch(const uvec3& localCoords, const ivec3&
 
 	
 	// Attempt to find the node
-	auto it = m_nodes.find(id);
-	if (it == m_nodes.end())
+	const uint32 handle = FindHandle(id);
+	if (handle == NodePool<OctreeLayerNode>::InvalidHandle)
 		return false;
 	else
 	{
-		outNode = it->second;
+		outNode = m_nodes.Get(handle);
+		return true;
+	}
+}
+
+bool OctreeLayer::IsNodeSplit(const OctreeLayerNode* node, const uvec3& coords, const uint32& maxDepthOffset, const OctreeLayer* highestLayer) const
+{
+	if (!IsNodeSplitBalanced(node, coords, maxDepthOffset, highestLayer))
+		return false;
+
+	if (m_volume->GetSeamMode() != LayeredSeamMode::TransitionCells || node->GetPinchedEdges() == 0)
+		return true;
+
+	// Every node in the group has to split, and find the same group, so they all come to the same answer
+	// (Anything larger is left at this resolution, rather than following the pinched edges any further)
+	uvec3 group[27];
+	uvec3 otherGroup[27];
+	const uint32 count = GetPinchedGroup(node, coords, group);
+
+	for (uint32 i = 1; i < count; ++i)
+	{
+		OctreeLayerNode* other;
+		AttemptNodeOffsetFetch(group[i], ivec3(0, 0, 0), other);
+		if (!IsNodeSplitBalanced(other, group[i], maxDepthOffset, highestLayer) || !AreAncestorsSplit(group[i], coords, maxDepthOffset, highestLayer))
+			return false;
+
+		if (GetPinchedGroup(other, group[i], otherGroup) != count)
+			return false;
+		for (uint32 j = 1; j < count; ++j)
+			if (std::find(group, group + count, otherGroup[j]) == group + count)
+				return false;
+	}
+
+	return true;
+}
+
+uint32 OctreeLayer::GetPinchedGroup(const OctreeLayerNode* node, const uvec3& coords, uvec3* outCells) const
+{
+	const int32 width = m_layerResolution - 1;
+	const uint16 pinchedEdges = node->GetPinchedEdges();
+	uint32 count = 0;
+	outCells[count++] = coords;
+
+	for (uint32 e = 0; e < 12; ++e)
+	{
+		if ((pinchedEdges & (1 << e)) == 0)
+			continue;
+
+		const uvec3 start = coords + MC::CornerOffset(MC::EdgeCorners[e][0]);
+		const uint32 axis = MC::EdgeAxis[e];
+		const uint32 uAxis = (axis + 1) % 3;
+		const uint32 vAxis = (axis + 2) % 3;
+		for (uint32 i = 0; i < 4; ++i)
+		{
+			ivec3 other = ivec3(start);
+			other[uAxis] -= 1 - (i & 1);
+			other[vAxis] -= 1 - (i >> 1);
+			if (other[uAxis] < 0 || other[vAxis] < 0 || other[uAxis] >= width || other[vAxis] >= width)
+				continue;
+
+			OctreeLayerNode* neighbour;
+			if (std::find(outCells, outCells + count, uvec3(other)) == outCells + count && AttemptNodeOffsetFetch(uvec3(other), ivec3(0, 0, 0), neighbour))
+				outCells[count++] = uvec3(other);
+		}
+	}
+
+	return count;
+}
+
+bool OctreeLayer::IsNodeSplitBalanced(const OctreeLayerNode* node, const uvec3& coords, const uint32& maxDepthOffset, const OctreeLayer* highestLayer) const
+{
+	if (!node->RequiresHigherDetail(maxDepthOffset))
+		return false;
+
+	if (m_volume->GetSeamMode() != LayeredSeamMode::TransitionCells || this == highestLayer || previousLayer == nullptr)
 		return true;
+
+	// Only split once the parent's neighbours on this node's sides are, so the children never sit against a node 2 layers coarser
+	// (Neighbours inside of the parent are its siblings, which are always reached)
+	const uvec3 parentCoords = coords / 2u;
+	const int32 parentWidth = previousLayer->GetLayerResolution() - 1;
+
+	for (const auto& face : TransitionFaces)
+	{
+		const uint32 axis = 3 - face.uAxis - face.vAxis;
+		if (((coords[axis] & 1) != 0) != (face.direction[axis] > 0))
+			continue;
+
+		const ivec3 neighbourCoords = ivec3(parentCoords) + face.direction;
+		if (neighbourCoords[axis] < 0 || neighbourCoords[axis] >= parentWidth)
+			continue;
+
+		OctreeLayerNode* neighbour;
+		if (previousLayer->AttemptNodeOffsetFetch(uvec3(neighbourCoords), ivec3(0, 0, 0), neighbour) && !previousLayer->IsNodeSplit(neighbour, uvec3(neighbourCoords), maxDepthOffset + 1, highestLayer))
+			return false;
+	}
+
+	return true;
+}
+
+bool OctreeLayer::IsNodeDrawn(const uvec3& coords, const uvec3& splitCoords, const uint32& maxDepthOffset, const OctreeLayer* highestLayer) const
+{
+	OctreeLayerNode* node;
+	if (!AttemptNodeOffsetFetch(coords, ivec3(0, 0, 0), node) || IsNodeSplit(node, coords, maxDepthOffset, highestLayer))
+		return false;
+
+	return AreAncestorsSplit(coords, splitCoords, maxDepthOffset, highestLayer);
+}
+
+bool OctreeLayer::AreAncestorsSplit(const uvec3& coords, const uvec3& reachedCoords, const uint32& maxDepthOffset, const OctreeLayer* highestLayer) const
+{
+	// The reached node's ancestors must all be split for it to be reached, so only the ancestors which aren't shared with it need checking
+	uvec3 current = coords;
+	uvec3 reached = reachedCoords;
+	uint32 depthOffset = maxDepthOffset;
+
+	for (const OctreeLayer* layer = this; layer != highestLayer && layer->previousLayer != nullptr; layer = layer->previousLayer)
+	{
+		current = current / 2u;
+		reached = reached / 2u;
+		++depthOffset;
+
+		if (current == reached)
+			return true;
+
+		OctreeLayerNode* node;
+		if (!layer->previousLayer->AttemptNodeOffsetFetch(current, ivec3(0, 0, 0), node) || !layer->previousLayer->IsNodeSplit(node, current, depthOffset, highestLayer))
+			return false;
+	}
+
+	return true;
+}
+
+bool OctreeLayer::IsEdgePinched(const uvec3& start, const uint32& axis) const
+{
+	const LayeredVolume* volume = m_volume;
+	const float isoLevel = volume->GetIsoLevel();
+	const uint32 stride = GetStride();
+
+	uvec3 corners[3] = { start * stride, start * stride, start * stride };
+	corners[1][axis] += stride / 2;
+	corners[2][axis] += stride;
+
+	bool isInside[3];
+	for (uint32 i = 0; i < 3; ++i)
+		isInside[i] = volume->Get(corners[i].x, corners[i].y, corners[i].z) > isoLevel;
+
+	return isInside[0] == isInside[2] && isInside[0] != isInside[1];
+}
+
+bool OctreeLayer::IsEdgeSplitDiagonally(const uvec3& start, const uint32& axis, const uvec3& reachedCoords, const uint32& maxDepthOffset, const OctreeLayer* highestLayer) const
+{
+	const int32 width = m_layerResolution - 1;
+	const uint32 uAxis = (axis + 1) % 3;
+	const uint32 vAxis = (axis + 2) % 3;
+
+	// Check the 4 nodes around the edge (0 and 3 are diagonally opposite, as are 1 and 2)
+	bool isSplit[4];
+	for (uint32 i = 0; i < 4; ++i)
+	{
+		ivec3 coords = ivec3(start);
+		coords[uAxis] -= 1 - (i & 1);
+		coords[vAxis] -= 1 - (i >> 1);
+
+		OctreeLayerNode* node;
+		isSplit[i] =
+			coords[uAxis] >= 0 && coords[vAxis] >= 0 && coords[uAxis] < width && coords[vAxis] < width &&
+			AttemptNodeOffsetFetch(uvec3(coords), ivec3(0, 0, 0), node) && IsNodeSplit(node, uvec3(coords), maxDepthOffset, highestLayer) &&
+			AreAncestorsSplit(uvec3(coords), reachedCoords, maxDepthOffset, highestLayer);
 	}
+
+	return (isSplit[0] && isSplit[3] && !isSplit[1] && !isSplit[2]) || (isSplit[1] && isSplit[2] && !isSplit[0] && !isSplit[3]);
+}
+
+void OctreeLayer::GetFineEdgeVertex(const uvec3& start, const uint32& axis, vec3& outVertex, uint64& outID) const
+{
+	const LayeredVolume* volume = m_volume;
+	const float isoLevel = volume->GetIsoLevel();
+	const uint32 stride = GetStride();
+
+	uvec3 corners[3] = { start * stride, start * stride, start * stride };
+	corners[1][axis] += stride / 2;
+	corners[2][axis] += stride;
+
+	float values[3];
+	for (uint32 i = 0; i < 3; ++i)
+		values[i] = volume->Get(corners[i].x, corners[i].y, corners[i].z);
+
+	// Lowest corner first, as the children interpolate their edges
+	const uint32 half = ((values[0] > isoLevel) != (values[1] > isoLevel) ? 0 : 1);
+	outVertex = MC::VertexLerp(isoLevel, vec3(corners[half]), vec3(corners[half + 1]), values[half], values[half + 1]);
+	outID = MeshBuilderMinimal::GetEdgeID(corners[half], axis, m_strideLevel - 1);
 }
 
 bool OctreeLayer::AttemptNodeFetch(const uint32& id, OctreeLayerNode*& outNode, const bool& createIfAbsent)
@@ -961,14 +1843,17 @@ bool OctreeLayer::AttemptNodeFetch(const uint32& id, OctreeLayerNode*& outNode,
 	// Node must be in this layer
 	else
 	{
-		auto it = m_nodes.find(id);
-		if (it == m_nodes.end())
+		const uint32 handle = FindHandle(id);
+		if (handle == NodePool<OctreeLayerNode>::InvalidHandle)
 		{
 			// Make the node, as it currently doesn't exist
 			if (createIfAbsent)
 			{
-				outNode = new OctreeLayerNode(id, this);
-				m_nodes[id] = outNode;
+				outNode = m_nodes.Get(CreateNode(id, this));
+
+				// Neighbours may need to match their seams up with this node
+				const uvec3 coords = GetLocalCoords(id);
+				MarkCellsDirty(coords, coords);
 				return true;
 			}
 			else
@@ -976,7 +1861,7 @@ bool OctreeLayer::AttemptNodeFetch(const uint32& id, OctreeLayerNode*& outNode,
 		}
 		else
 		{
-			outNode = it->second;
+			outNode = m_nodes.Get(handle);
 			return true;
 		}
 	}
@@ -996,6 +1881,8 @@ LayeredVolume::~LayeredVolume()
 {
 	for (Mesh* mesh : m_meshes)
 		delete mesh;
+	if (m_viewMesh != nullptr)
+		delete m_viewMesh;
 
 	if (m_material != nullptr)
 		delete m_material;
@@ -1024,9 +1911,9 @@ void LayeredVolume::Update(const float & deltaTime)
 {
 	if (TEST_REBUILD)
 	{
-		MeshBuilderMinimal builder;
-		m_layers[currentLod]->BuildMesh(builder, lodDepth);
-		builder.BuildMesh(m_meshes[currentLod]);
+		RecalculateStaleStats();
+
+		m_layers[currentLod]->BuildMesh(m_meshes[currentLod], lodDepth);
 
 		LOG("Build Count:%i", m_meshes[currentLod]->GetDrawCount());
 		TEST_REBUILD = false;
@@ -1043,16 +1930,30 @@ void LayeredVolume::Draw(const Window * window, const float & deltaTime)
 		drawWireFrame = !drawWireFrame;
 	if (keyboard->IsKeyPressed(Keyboard::Key::KV_R))
 		drawMainObject = !drawMainObject;
+	if (keyboard->IsKeyPressed(Keyboard::Key::KV_L))
+	{
+		bUseViewLod = !bUseViewLod;
+		LOG("View LOD %s", bUseViewLod ? "On" : "Off");
+	}
+
 
+	// Either pick the detail of each node from the camera, or draw a single layer
+	Mesh* mesh = m_meshes[currentLod];
+	if (bUseViewLod)
+	{
+		const Camera* camera = GetLevel()->GetCamera();
+		UpdateViewMesh(camera->GetLocation(), camera->GetFoV(), window->GetHeight());
+		mesh = m_viewMesh;
+	}
 
-	if (m_meshes[currentLod] != nullptr)
+	if (mesh != nullptr)
 	{
 		Transform t;
 
 		if (drawMainObject)
 		{
 			m_material->Bind(window, GetLevel());
-			m_material->PrepareMesh(m_meshes[currentLod]);
+			m_material->PrepareMesh(mesh);
 			m_material->RenderInstance(&t);
 			m_material->Unbind(window, GetLevel());
 		}
@@ -1060,7 +1961,7 @@ void LayeredVolume::Draw(const Window * window, const float & deltaTime)
 		if (drawWireFrame)
 		{
 			m_wireMaterial->Bind(window, GetLevel());
-			m_wireMaterial->PrepareMesh(m_meshes[currentLod]);
+			m_wireMaterial->PrepareMesh(mesh);
 			m_wireMaterial->RenderInstance(&t);
 			m_wireMaterial->Unbind(window, GetLevel());
 		}
@@ -1072,7 +1973,7 @@ void LayeredVolume::Draw(const Window * window, const float & deltaTime)
 		buildDebugMesh = false;
 		TEST_REBUILD = true;
 		for (OctreeLayer* layer : m_layers)
-			layer->rebuildFlag = true;
+			layer->MarkAllDirty();
 
 		LOG("Done");
 	}
@@ -1081,11 +1982,19 @@ void LayeredVolume::Draw(const Window * window, const float & deltaTime)
 		buildDebugMesh = true;
 		TEST_REBUILD = true;
 		for (OctreeLayer* layer : m_layers)
-			layer->rebuildFlag = true;
+			layer->MarkAllDirty();
 
 		LOG("Done");
 	}
 
+	if (keyboard->IsKeyPressed(Keyboard::Key::KV_O))
+	{
+		SetSeamMode(m_seamMode == LayeredSeamMode::EdgeOverride ? LayeredSeamMode::TransitionCells : LayeredSeamMode::EdgeOverride);
+		TEST_REBUILD = true;
+
+		LOG("Seams %s", m_seamMode == LayeredSeamMode::EdgeOverride ? "Edge Override" : "Transition Cells");
+	}
+
 	if (keyboard->IsKeyPressed(Keyboard::Key::KV_U))
 	{
 		currentLod++;
@@ -1125,8 +2034,7 @@ void LayeredVolume::Init(const uvec3 & resolution, const vec3 & scale)
 
 	m_resolution = resolution;
 	m_scale = scale;
-	m_data.clear();
-	m_data.resize(resolution.x * resolution.y * resolution.z);
+	m_data.Init(resolution, m_layout, EncodeVoxel(DEFAULT_VALUE));
 
 
 	// Allocate number of layers
@@ -1158,18 +2066,384 @@ void LayeredVolume::Init(const uvec3 & resolution, const vec3 & scale)
 
 	// Create meshes
 	for (uint32 i = 0; i < m_layers.size(); ++i)
+	{
 		m_meshes.push_back(new Mesh);
+		m_meshes.back()->MarkDynamic();
+	}
+	if (m_viewMesh == nullptr)
+		m_viewMesh = new Mesh;
 
 	currentLod = m_layers.size() - 1;
 }
 
 void LayeredVolume::Set(uint32 x, uint32 y, uint32 z, float value)
 {
+	// Layers will be built once the load is finished
+	if (bIsBulkLoading)
+	{
+		m_data.Set(x, y, z, EncodeVoxel(value));
+		return;
+	}
+
+	// Layers should see the value which is actually stored
+	const VoxelSample sample = EncodeVoxel(value);
+	value = DecodeVoxel(sample);
+
+	if (m_data.Get(x, y, z) == sample)
+		return;
+
 	// Notify any layers of any changes
 	for (OctreeLayer* layer : m_layers)
 		TEST_REBUILD |= layer->HandlePush(x, y, z, value);
 
-	m_data[GetIndex(x, y, z)] = value;
+	m_data.Set(x, y, z, sample);
+	bViewMeshStale = true;
+
+	if (IsOnNodeGrid(x, y, z))
+		for (OctreeLayer* layer : m_layers)
+			layer->MarkDirty(x, y, z);
+}
+
+void LayeredVolume::ApplyDeltas(const std::vector<VoxelDelta>& deltas)
+{
+	// Layers will be built once the load is finished (Writing in order still leaves the last change to each voxel)
+	if (bIsBulkLoading)
+	{
+		for (const VoxelDelta& delta : deltas)
+			m_data.Set(delta.coord.x, delta.coord.y, delta.coord.z, EncodeVoxel(delta.value));
+		return;
+	}
+
+	PrepareDeltaBatch(deltas, m_deltaBatch);
+
+	// Drop any deltas which don't change what's stored, so they don't dirty any nodes
+	uint32 changedCount = 0;
+	for (const VoxelDelta& delta : m_deltaBatch)
+	{
+		const VoxelSample sample = EncodeVoxel(delta.value);
+		if (m_data.Get(delta.coord.x, delta.coord.y, delta.coord.z) == sample)
+			continue;
+
+		m_data.Set(delta.coord.x, delta.coord.y, delta.coord.z, sample);
+
+		VoxelDelta& changed = m_deltaBatch[changedCount++];
+		changed.coord = delta.coord;
+		changed.value = DecodeVoxel(sample); // Layers should see the value which is actually stored
+	}
+	m_deltaBatch.resize(changedCount);
+	if (changedCount != 0)
+		bViewMeshStale = true;
+
+	// Notify a layer at a time, so each layer's nodes stay warm while the batch is pushed
+	for (OctreeLayer* layer : m_layers)
+	{
+		for (const VoxelDelta& delta : m_deltaBatch)
+			TEST_REBUILD |= layer->HandlePush(delta.coord.x, delta.coord.y, delta.coord.z, delta.value);
+
+		for (const VoxelDelta& delta : m_deltaBatch)
+			if (IsOnNodeGrid(delta.coord.x, delta.coord.y, delta.coord.z))
+				layer->MarkDirty(delta.coord.x, delta.coord.y, delta.coord.z);
+	}
+}
+
+void LayeredVolume::RecalculateStaleStats()
+{
+	// Each node's merge depth depends on its children's, so start from the deepest layer
+	for (auto it = m_layers.rbegin(); it != m_layers.rend(); ++it)
+		(*it)->RecalculateStaleNodes();
+}
+
+void LayeredVolume::SetSeamMode(const LayeredSeamMode& mode)
+{
+	if (m_seamMode == mode)
+		return;
+
+	m_seamMode = mode;
+	for (OctreeLayer* layer : m_layers)
+		layer->MarkAllDirty();
+}
+
+void LayeredVolume::UpdateViewMesh(const vec3& viewLocation, const float& fov, const float& screenHeight)
+{
+	// Nothing can have changed since the last selection
+	if (!bViewMeshStale && viewLocation == m_viewLocation && fov == m_viewFov && screenHeight == m_viewScreenHeight)
+		return;
+
+	m_viewLocation = viewLocation;
+	m_viewFov = fov;
+	m_viewScreenHeight = screenHeight;
+
+	// The error of each node depends on its merge depth
+	RecalculateStaleStats();
+
+	std::vector<ViewCandidate> nodes;
+	const bool hasSelectionChanged = SelectViewNodes(viewLocation, fov, screenHeight, nodes);
+
+	if (hasSelectionChanged || bViewMeshStale)
+	{
+		BuildViewMesh(nodes);
+		bViewMeshStale = false;
+	}
+}
+
+bool LayeredVolume::SelectViewNodes(const vec3& viewLocation, const float& fov, const float& screenHeight, std::vector<ViewCandidate>& outNodes)
+{
+	// How many pixels something 1 unit across covers, when it's 1 unit away
+	const float pixelsPerUnit = screenHeight / (2.0f * tan(glm::radians(fov) * 0.5f));
+	const float hysteresisScale = 1.0f / (1.0f - m_viewHysteresis);
+
+	auto getPriority = [this, &viewLocation, pixelsPerUnit, hysteresisScale](const OctreeLayer* layer, const OctreeLayerNode* node)
+	{
+		// Drawing a node rather than its children can move the surface by up to the node's size
+		const float stride = layer->GetStride();
+		const vec3 lower = vec3(layer->GetLocalCoords(node->GetID())) * stride;
+		const vec3 closest = glm::clamp(viewLocation, lower, lower + stride);
+		const float distance = glm::max(glm::length(closest - viewLocation), 1.0f); // Clamped, so nodes around the camera don't have an infinite error
+
+		// Nodes whose children can all be merged safely keep the same shape, so only lose smoothness
+		const float detail = node->RequiresHigherDetail(1) ? 1.0f : 0.5f;
+
+		float error = stride * detail * pixelsPerUnit / distance;
+		if (m_viewSplitNodes.find(node->GetID()) != m_viewSplitNodes.end())
+			error *= hysteresisScale;
+		return error;
+	};
+
+	// Nodes without any triangles or children never need drawing
+	auto isVisible = [](const OctreeLayerNode* node) { return MC::CaseTriangleCount(node->GetCaseIndex()) != 0 || node->HasChildren(); };
+
+	auto compare = [](const ViewCandidate& a, const ViewCandidate& b) { return a.priority < b.priority; };
+	std::vector<ViewCandidate> queue;
+	std::unordered_set<uint32> splitNodes;
+	uint32 triangleCount = 0;
+
+	// Always draw the coarsest layer
+	OctreeLayer* root = m_layers[0];
+	root->ForEachNode([root, &queue, &triangleCount, &getPriority, &isVisible](OctreeLayerNode* node)
+	{
+		if (!isVisible(node))
+			return;
+
+		queue.push_back(ViewCandidate{ root, node, getPriority(root, node) });
+		triangleCount += MC::CaseTriangleCount(node->GetCaseIndex());
+	});
+	std::make_heap(queue.begin(), queue.end(), compare);
+
+
+	std::vector<ViewCandidate> splits;
+	std::array<OctreeLayerNode*, 8> children;
+	while (!queue.empty())
+	{
+		std::pop_heap(queue.begin(), queue.end(), compare);
+		const ViewCandidate candidate = queue.back();
+		queue.pop_back();
+
+		// Already split, to keep a finer neighbour's children within 1 layer of it
+		if (splitNodes.find(candidate.node->GetID()) != splitNodes.end())
+			continue;
+
+		// Everything left is within the error
+		if (candidate.priority <= m_viewPixelError)
+		{
+			outNodes.push_back(candidate);
+			break;
+		}
+
+		splits.clear();
+		if (!CollectViewSplits(candidate.layer, candidate.node, splitNodes, splits))
+		{
+			outNodes.push_back(candidate);
+			continue;
+		}
+
+		// Work out how many triangles this would add, including any neighbours which have to be split with it
+		uint32 splitCount = triangleCount;
+		for (const ViewCandidate& split : splits)
+		{
+			split.node->FetchChildren(children);
+			splitCount -= MC::CaseTriangleCount(split.node->GetCaseIndex());
+			for (const OctreeLayerNode* child : children)
+				if (child)
+					splitCount += MC::CaseTriangleCount(child->GetCaseIndex());
+		}
+
+		// Out of budget, so leave everything else as it is (Rather than hunting for smaller splits, so the walk stays bounded by the budget)
+		if (splitCount > m_viewTriangleBudget)
+		{
+			for (const ViewCandidate& split : splits)
+				splitNodes.erase(split.node->GetID());
+
+			outNodes.push_back(candidate);
+			break;
+		}
+
+		triangleCount = splitCount;
+		for (const ViewCandidate& split : splits)
+		{
+			OctreeLayer* childLayer = split.layer->nextLayer;
+			split.node->FetchChildren(children);
+
+			for (OctreeLayerNode* child : children)
+				if (child && isVisible(child))
+				{
+					queue.push_back(ViewCandidate{ childLayer, child, getPriority(childLayer, child) });
+					std::push_heap(queue.begin(), queue.end(), compare);
+				}
+		}
+	}
+
+	// Anything left in the queue is drawn as it is (Skipping any nodes which have been split to balance a neighbour)
+	for (const ViewCandidate& candidate : queue)
+		if (splitNodes.find(candidate.node->GetID()) == splitNodes.end())
+			outNodes.push_back(candidate);
+
+	const bool hasChanged = (splitNodes != m_viewSplitNodes);
+	m_viewSplitNodes.swap(splitNodes);
+	return hasChanged;
+}
+
+bool LayeredVolume::CollectViewSplits(OctreeLayer* layer, OctreeLayerNode* node, std::unordered_set<uint32>& splitNodes, std::vector<ViewCandidate>& outSplits) const
+{
+	if (layer->nextLayer == nullptr || !node->HasChildren())
+		return false;
+
+	// The children's neighbours in the layer above must be drawn at this node's resolution or finer,
+	// so any coarser neighbour (The parent of this node's neighbour, if it isn't this node's parent) has to be split first
+	OctreeLayer* parentLayer = layer->previousLayer;
+	if (parentLayer != nullptr)
+	{
+		const ivec3 coords = ivec3(layer->GetLocalCoords(node->GetID()));
+		const int32 width = layer->GetLayerResolution() - 1;
+		const uint32 start = outSplits.size();
+
+		for (const auto& face : TransitionFaces)
+		{
+			const ivec3 neighbourCoords = coords + face.direction;
+			if (neighbourCoords.x < 0 || neighbourCoords.y < 0 || neighbourCoords.z < 0 || neighbourCoords.x >= width || neighbourCoords.y >= width || neighbourCoords.z >= width)
+				continue;
+
+			const uvec3 parentCoords = uvec3(neighbourCoords) / 2u;
+			if (parentCoords == uvec3(coords) / 2u)
+				continue;
+
+			OctreeLayerNode* parent;
+			const uint32 parentId = parentLayer->GetID(parentCoords.x, parentCoords.y, parentCoords.z);
+			if (splitNodes.find(parentId) != splitNodes.end() || !parentLayer->AttemptNodeFetch(parentId, parent, false))
+				continue;
+
+			if (!CollectViewSplits(parentLayer, parent, splitNodes, outSplits))
+			{
+				for (uint32 i = start; i < outSplits.size(); ++i)
+					splitNodes.erase(outSplits[i].node->GetID());
+				outSplits.resize(start);
+				return false;
+			}
+		}
+	}
+
+	splitNodes.insert(node->GetID());
+	outSplits.push_back(ViewCandidate{ layer, node, 0.0f });
+	return true;
+}
+
+void LayeredVolume::BuildViewMesh(const std::vector<ViewCandidate>& nodes)
+{
+	const float isoLevel = GetIsoLevel();
+	EdgeOverrideCache overrideCache; // Never used, as every node is meshed as the highest layer
+
+	std::vector<OctreeLayerTriangle> triangles;
+	triangles.reserve(m_viewTriangleCount);
+
+	for (const ViewCandidate& candidate : nodes)
+	{
+		OctreeLayer* layer = candidate.layer;
+		candidate.node->BuildMesh(isoLevel, triangles, 0, layer, 0, overrideCache);
+
+		// Close the faces against any neighbours which have been split, so are drawn a layer finer
+		// (The transition cell belongs to the split neighbour, so has to be built from its side)
+		const ivec3 coords = ivec3(layer->GetLocalCoords(candidate.node->GetID()));
+		const int32 width = layer->GetLayerResolution() - 1;
+
+		for (uint32 f = 0; f < 6; ++f)
+		{
+			const ivec3 neighbourCoords = coords + TransitionFaces[f].direction;
+			if (neighbourCoords.x < 0 || neighbourCoords.y < 0 || neighbourCoords.z < 0 || neighbourCoords.x >= width || neighbourCoords.y >= width || neighbourCoords.z >= width)
+				continue;
+
+			OctreeLayerNode* neighbour;
+			const uint32 neighbourId = layer->GetID(neighbourCoords.x, neighbourCoords.y, neighbourCoords.z);
+			if (m_viewSplitNodes.find(neighbourId) != m_viewSplitNodes.end() && layer->AttemptNodeFetch(neighbourId, neighbour, false))
+				neighbour->BuildTransitionCell(isoLevel, triangles, f ^ 1); // Faces are in opposing pairs
+		}
+	}
+
+	// Weld everything together, so normals are smoothed across nodes and layers
+	m_viewBuilder.Clear();
+	m_viewBuilder.MarkDynamic();
+	m_viewBuilder.Reserve(triangles.size());
+	WeldTriangles(triangles.data(), triangles.size(), m_viewBuilder);
+	m_viewBuilder.BuildMesh(m_viewMesh);
+
+	m_viewNodeCount = nodes.size();
+	m_viewTriangleCount = m_viewBuilder.GetIndexCount() / 3;
+}
+
+uint32 LayeredVolume::CountViewOpenEdges() const
+{
+	uint32 openEdges;
+	uint32 nonManifoldEdges;
+	CountSeamEdges(m_viewBuilder, m_octreeRes, openEdges, nonManifoldEdges);
+	return openEdges;
+}
+
+void LayeredVolume::CountLayerSeams(uint32& outOpenEdges, uint32& outNonManifoldEdges)
+{
+	outOpenEdges = 0;
+	outNonManifoldEdges = 0;
+
+	for (OctreeLayer* layer : m_layers)
+	{
+		// Building a stale layer here would leave its uploaded mesh behind, so only check the ones which are up to date
+		if (layer->RequiresRebuild(lodDepth))
+			continue;
+
+		// Nothing is dirty, so this only welds the cached blocks back together
+		MeshBuilderMinimal builder;
+		layer->BuildNodeMeshes(builder, lodDepth);
+
+		uint32 openEdges;
+		uint32 nonManifoldEdges;
+		CountSeamEdges(builder, m_octreeRes, openEdges, nonManifoldEdges);
+		outOpenEdges = glm::max(outOpenEdges, openEdges);
+		outNonManifoldEdges = glm::max(outNonManifoldEdges, nonManifoldEdges);
+	}
+}
+
+void LayeredVolume::BeginBulkLoad()
+{
+	bIsBulkLoading = true;
+}
+
+void LayeredVolume::EndBulkLoad()
+{
+	if (!bIsBulkLoading)
+		return;
+	bIsBulkLoading = false;
+
+	for (OctreeLayer* layer : m_layers)
+		layer->ClearNodes();
+
+	// Build from the deepest layer up, as each layer needs to know which of its children exist
+	for (auto it = m_layers.rbegin(); it != m_layers.rend(); ++it)
+		(*it)->BuildNodes();
+	bViewMeshStale = true;
+
+#ifdef _DEBUG
+	for (const OctreeLayer* layer : m_layers)
+		LOG("LayeredVolume layer %i: %i nodes using %iKB (%s)", layer->GetDepth(), layer->GetNodeCount(), (uint32)(layer->GetMemoryUsage() / 1024), layer->IsDense() ? "dense" : "hashed");
+#endif
+
+	TEST_REBUILD = true;
 }
 
 float LayeredVolume::Get(uint32 x, uint32 y, uint32 z)
@@ -1177,7 +2451,7 @@ float LayeredVolume::Get(uint32 x, uint32 y, uint32 z)
 	if (x >= m_resolution.x || y >= m_resolution.y || z >= m_resolution.z)
 		return UNKNOWN_BUILD_VALUE;
 
-	return m_data[GetIndex(x, y, z)];
+	return DecodeVoxel(m_data.Get(x, y, z));
 }
 
 float LayeredVolume::Get(uint32 x, uint32 y, uint32 z) const
@@ -1185,7 +2459,7 @@ float LayeredVolume::Get(uint32 x, uint32 y, uint32 z) const
 	if (x >= m_resolution.x || y >= m_resolution.y || z >= m_resolution.z)
 		return UNKNOWN_BUILD_VALUE;
 
-	return m_data[GetIndex(x, y, z)];
+	return DecodeVoxel(m_data.Get(x, y, z));
 }
 
 #include <chrono>
@@ -1195,43 +2469,60 @@ VoxelBuildResults LayeredVolume::Rebuild(const std::vector<VoxelDelta>& deltas,
 	// recreation ignored for LayeredVolume
 	VoxelBuildResults results;
 
-	results.buildTime.resize(m_layers.size());
+	results.buildTime.resize(m_layers.size(), 0);
 	results.tricount.resize(m_layers.size());
 
 
-	int64 startTime = duration_cast<milliseconds>(system_clock::now().time_since_epoch()).count();
+	int64 startTime = duration_cast<microseconds>(high_resolution_clock::now().time_since_epoch()).count();
 	int64 endTime;
 
 	// Insert values
-	for (const VoxelDelta& delta : deltas)
-	{
-		for (OctreeLayer* layer : m_layers)
-			layer->HandlePush(delta.coord.x, delta.coord.y, delta.coord.z, delta.value);
-
-		m_data[GetIndex(delta.coord.x, delta.coord.y, delta.coord.z)] = delta.value;
-	}
-	endTime = duration_cast<milliseconds>(system_clock::now().time_since_epoch()).count();
+	ApplyDeltas(deltas);
+	endTime = duration_cast<microseconds>(high_resolution_clock::now().time_since_epoch()).count();
 	results.insertTime = endTime - startTime;
 
 
+	RecalculateStaleStats();
+
+	// Work out which layers need rebuilding before any of them are built
+	const uint32 layerCount = m_layers.size();
+	std::vector<uint8> requiresBuild(layerCount);
+	for (uint32 i = 0; i < layerCount; ++i)
+		requiresBuild[i] = m_layers[i]->RequiresRebuild(lodDepth);
+
 	// Rebuild meshes
-	for (uint32 i = 0; i < m_layers.size(); ++i)
+	// (Layers only read from each other's nodes while meshing, so they can all be built at once, deepest/largest first)
+	ThreadPool::GetShared().ParallelFor(layerCount, [this, &results, &requiresBuild, layerCount](uint32 j)
 	{
-		int64 buildStartTime = duration_cast<milliseconds>(system_clock::now().time_since_epoch()).count();
+		const uint32 i = layerCount - 1 - j;
+		if (!requiresBuild[i])
+			return;
 
-		MeshBuilderMinimal builder;
-		builder.MarkDynamic();
-		if(m_layers[i]->BuildMesh(builder, lodDepth))
-			builder.BuildMesh(m_meshes[i]);
+		int64 buildStartTime = duration_cast<microseconds>(high_resolution_clock::now().time_since_epoch()).count();
+
+		m_layers[i]->PatchArena(lodDepth);
+
+		results.buildTime[i] = duration_cast<microseconds>(high_resolution_clock::now().time_since_epoch()).count() - buildStartTime;
+	});
+
+	// Meshes have to be uploaded on this thread
+	for (uint32 i = 0; i < layerCount; ++i)
+	{
+		int64 buildStartTime = duration_cast<microseconds>(high_resolution_clock::now().time_since_epoch()).count();
+
+		// Only the blocks which have changed are uploaded
+		if (requiresBuild[i])
+			m_layers[i]->UploadArena(m_meshes[i]);
 		
-		endTime = duration_cast<milliseconds>(system_clock::now().time_since_epoch()).count();
-		results.buildTime[i] = endTime - buildStartTime;
-		results.tricount[i] = m_meshes[i]->GetDrawCount();
+		endTime = duration_cast<microseconds>(high_resolution_clock::now().time_since_epoch()).count();
+		results.buildTime[i] += endTime - buildStartTime;
+		results.tricount[i] = m_layers[i]->GetArenaIndexCount(); // Mesh also draws the degenerate triangles left in any gaps
 	}
+	TEST_REBUILD = false;
 
 
 	// Total time
-	endTime = duration_cast<milliseconds>(system_clock::now().time_since_epoch()).count();
+	endTime = duration_cast<microseconds>(high_resolution_clock::now().time_since_epoch()).count();
 	results.totalTime = endTime - startTime;
 	return results;
 }
\ No newline at end of file
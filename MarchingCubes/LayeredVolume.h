@@ -1,11 +1,18 @@
 #pragma once
 #include "Object.h"
 #include "VoxelVolume.h"
+#include "VoxelSample.h"
+#include "VoxelGrid.h"
 #include "MeshBuilder.h"
 #include "Mesh.h"
+#include "MeshArena.h"
 #include "MarchingCubes.h"
+#include "NodePool.h"
+#include "EdgeOverrideCache.h"
+#include "TransitionCells.h"
 
 #include <unordered_map>
+#include <unordered_set>
 #include <array>
 
 
@@ -14,6 +21,30 @@ class LayeredVolume;
 class OctreeLayer;
 
 
+/**
+* How the gaps between nodes which are meshed at different resolutions are closed
+*/
+enum class LayeredSeamMode : uint8
+{
+	EdgeOverride = 0,	// Move the fine vertices onto the coarse edges they meet (Searches the layers for every edge)
+	TransitionCells		// Fill each face between a coarse node and its finer neighbour with a transition cell (See TransitionCells.h)
+};
+
+
+/**
+* A triangle which a node has built, stored so it can be re-added to the layer's mesh without rebuilding the node
+*/
+struct OctreeLayerTriangle
+{
+	/// Vertices which weren't built on an edge are shared by position instead
+	static const uint64 NoEdgeID = ~0ULL;
+
+	uint64 edgeIds[3];
+	vec3 vertices[3];
+	vec3 normal;
+};
+
+
 /**
 * An octree node to be used in layers
 */
@@ -33,9 +64,26 @@ private:
 	//float m_stdDeviation;
 	OctreeLayer* m_layer;
 
+	bool bIsDirty = true; // Does the geometry in the cache need rebuilding
+	bool bStatsStale = false; // Do the merge depth and cached intersections need recalculating (If set, so are all of its ancestors)
+	bool bHasMultipleIntersections = false;
+	uint16 m_pinchedEdges = 0; // Bitset of the edges which cross the surface at both halves, but not from end to end (Cached by RecalculateMergeDepth)
+	uint32 m_cacheStart = 0; // Where this node's triangles are in its build block's cache
+	uint32 m_cacheCount = 0;
+
 public:
 	OctreeLayerNode(const uint32& id, OctreeLayer* layer, const bool& initaliseValues = true);
 
+	/**
+	* Create a node during a bulk build of the layer
+	* (The parent is left alone and the merge depth is expected to be calculated, once the whole layer exists)
+	* @param id					The id of the node
+	* @param layer				The layer this node is in
+	* @param values				The values at each corner of this node
+	* @param childFlags			Which of the children exist
+	*/
+	OctreeLayerNode(const uint32& id, OctreeLayer* layer, const std::array<float, 8>& values, const uint8& childFlags);
+
 	/**
 	* Called just before this node is going to be deleted (During runtime)
 	* This won't get called at the end cleanup
@@ -55,12 +103,13 @@ public:
 	/**
 	* Build the actual mesh for just this node
 	* @param isoLevel				The iso level to build at
-	* @param builder				The builder which will create this mesh
+	* @param out					Where to store the triangles
 	* @param maxDepthOffset			How much deeper should be considered for meshing (In relation to the layer this node is on)
 	* @param highestLayer			The highest layer that is being built
 	* @param highestLayerOffset		How much deeper should be considered for meshing (In relation to the top layer)
+	* @param overrideCache			Edges which have already been resolved against highestLayer during this build
 	*/
-	void BuildMesh(const float& isoLevel, MeshBuilderMinimal& builder, const uint32& maxDepthOffset, OctreeLayer* highestLayer, const uint32& highestLayerOffset);
+	void BuildMesh(const float& isoLevel, std::vector<OctreeLayerTriangle>& out, const uint32& maxDepthOffset, OctreeLayer* highestLayer, const uint32& highestLayerOffset, EdgeOverrideCache& overrideCache);
 
 	///
 	/// Tree Funcs
@@ -117,7 +166,7 @@ public:
 	* Does the case of this node only contain a single connected face
 	* @returns True if only a single face exist for this case
 	*/
-	bool IsSimpleCase() const;
+	inline bool IsSimpleCase() const { return MC::IsSimpleCase(m_caseIndex); }
 
 	/**
 	* Is it safe to merge this nodes children
@@ -128,22 +177,61 @@ public:
 
 	/**
 	* Does this node have multiple intersections on any of it's edges
-	* (Will check all children down to leafs or when maxDepthOffset == 0)
+	* (Cached for the whole subtree by RecalculateMergeDepth)
 	* @returns True if any of it's edges has multiple intersections
 	*/
-	bool HasMultipleIntersections() const;
+	inline bool HasMultipleIntersections() const { return bHasMultipleIntersections; }
+
+	/** Bitset of this node's edges which are pinched (See OctreeLayer::IsEdgePinched. Only cached for nodes with children) */
+	inline uint16 GetPinchedEdges() const { return m_pinchedEdges; }
+
+	/**
+	* Recalculate all detail required parts and the cached intersections
+	* (Assumes children's merge depths are correct)
+	*/
+	void RecalculateMergeDepth();
+
+	/**
+	* Flag this node and its ancestors as needing their merge depths recalculated, on the next stats pass
+	* (Stops at the first ancestor which is already stale, as everything above it must be too)
+	*/
+	void MarkStatsStale();
 
 private:
 	/**
-	* Recalculate stats relevant to this node
+	* Check just the edges between this node's children for multiple intersections
+	* @param children			This node's children
+	* @returns True if any of the children's edges has multiple intersections
 	*/
-	void RecalculateStats();
+	bool CheckChildIntersections(const std::array<OctreeLayerNode*, 8>& children) const;
 
 	/**
-	* Recalculate all detail required parts
-	* (Assumes children's merge depths are correct)
+	* Recalculate the case index from the current corner values
 	*/
-	void RecalculateMergeDepth();
+	void RecalculateCaseIndex();
+
+	/**
+	* Build a transition cell on each face which is shared with a neighbour that is being meshed at this node's resolution
+	* (Expects this node to be split, so its children are meshed instead. As with Transvoxel, the cells only line up with the
+	* children, which is why OctreeLayer::IsNodeSplit never splits them again next to a neighbour at this resolution)
+	* @param isoLevel				The iso level to build at
+	* @param out					Where to store the triangles
+	* @param maxDepthOffset			How much deeper should be considered for meshing (In relation to the layer this node is on)
+	* @param highestLayer			The highest layer that is being built
+	*/
+	void BuildTransitionCells(const float& isoLevel, std::vector<OctreeLayerTriangle>& out, const uint32& maxDepthOffset, const OctreeLayer* highestLayer) const;
+
+public:
+	/**
+	* Build the transition cell on a single face of this node, between its children and the neighbour on that side
+	* (Expects the neighbour to be meshed at this node's resolution and this node's children at theirs)
+	* @param isoLevel				The iso level to build at
+	* @param out					Where to store the triangles
+	* @param faceIndex				Which face to build on (-x, +x, -y, +y, -z, +z)
+	* @param fineBorders			Bitset of the borders (Bottom, Top, Left, Right) whose coarse vertex is moved onto the fine vertex
+	*								(See OctreeLayer::IsEdgeSplitDiagonally)
+	*/
+	void BuildTransitionCell(const float& isoLevel, std::vector<OctreeLayerTriangle>& out, const uint32& faceIndex, const uint8& fineBorders = 0) const;
 
 private:
 	/**
@@ -175,10 +263,20 @@ private:
 public:
 	inline uint32 GetID() const { return m_id; }
 	inline bool FlaggedForDeletion() const { return m_caseIndex == 0 && m_childFlags == 0; }
+	inline bool HasChildren() const { return m_childFlags != 0; }
 
 	inline uint8 GetCaseIndex() const { return m_caseIndex; }
 	inline bool HasEdge(const uint32& edgeId) const { return (MC::CaseRequiredEdges[m_caseIndex] & edgeId) != 0; }
 
+	inline bool IsDirty() const { return bIsDirty; }
+	inline bool IsStatsStale() const { return bStatsStale; }
+	inline void MarkDirty() { bIsDirty = true; }
+
+	/** Where this node's triangles are in its build block's cache (Only valid once it's clean) */
+	inline uint32 GetCacheStart() const { return m_cacheStart; }
+	inline uint32 GetCacheCount() const { return m_cacheCount; }
+	inline void SetCache(const uint32& start, const uint32& count) { m_cacheStart = start; m_cacheCount = count; bIsDirty = false; }
+
 private:
 	inline uint32 GetIndex(const uint32& x, const uint32& y, const uint32& z) const { return x + 2 * (y + 2 * z); }
 };
@@ -189,25 +287,71 @@ private:
 */
 class OctreeLayer 
 {
+public:
+	/**
+	* The cached geometry for a block of NodesPerBuildJob slots in the node pool
+	*/
+	struct BuildBlock
+	{
+		std::vector<OctreeLayerTriangle> triangles; // Every node's triangles, in slot order
+		MeshBuilderMinimal builder; // The triangles welded into a mesh
+		MeshArena::Range range; // Where the welded mesh lives in the layer's arena
+		std::vector<uint64> sharedEdges; // Every edge this block has a vertex on (In the layer's shared vertices)
+		std::vector<vec3> sharedPositions; // The position of every vertex which is welded by position rather than by edge
+		bool bIsDirty = true;
+		bool bIsArenaStale = true; // Has the block been rebuilt since it was last written into the arena
+	};
+
+	/**
+	* A vertex which can be used by several blocks, which must all draw it at the same position with the same normal
+	*/
+	struct SharedVertex
+	{
+		static const uint32 MaxUsers = 8; // A vertex can at most sit on the corner of 8 cells
+
+		uint32 userCount = 0;
+		bool bIsChanged = false; // Already queued to be re-welded
+		std::array<uvec2, MaxUsers> users; // (Block, index of the vertex in the block's builder)
+	};
+
+	/// Layers with at most this many possible nodes store a handle for every node, rather than hashing the ids
+	static const uint32 MaxDenseNodes = 32 * 32 * 32;
+
+	/// How many slots of the node pool are meshed by each job (Fixed, so the mesh doesn't depend on the number of threads)
+	static const uint32 NodesPerBuildJob = 4096;
+
 	///
 	/// Vars
 	///
 private:
-	std::unordered_map<uint32, OctreeLayerNode*> m_nodes;
+	NodePool<OctreeLayerNode> m_nodes;
+	std::vector<uint32> m_denseHandles; // Handle for every possible node, indexed by (id - m_startIndex) (Only used by the coarse layers)
+	std::unordered_map<uint32, uint32> m_sparseHandles; // id -> handle (Used by the layers which are too large to index densely)
+	bool bIsDense;
 	const uint32 m_nodeResolution;
 	const uint32 m_layerResolution;
 	const uint32 m_depth;
 	const uint32 m_startIndex;	// The index at which this layer will start it's nodes
 	const uint32 m_endIndex;	// The index at which this layer will start it's nodes
+	uint32 m_strideLevel = 0;	// The stride is 2^m_strideLevel
+	uint32 m_lastTriangleCount = 0;
 	LayeredVolume* m_volume;
+
+	std::vector<BuildBlock> m_buildBlocks;
+	MeshArena m_arena; // Every block's welded mesh, so only the blocks which have changed are rewritten/uploaded
+	std::unordered_map<uint64, SharedVertex> m_sharedEdges; // edge id -> every block with a vertex on it
+	std::unordered_map<vec3, SharedVertex, vec3_KeyFuncs, vec3_KeyFuncs> m_sharedPositions; // position -> every block with a vertex there (Not on an edge)
+	std::vector<uint64> m_changedEdges; // Shared vertices whose blocks have changed since they were last welded
+	std::vector<vec3> m_changedPositions;
+	std::vector<uint32> m_staleNodes; // Ids of nodes whose merge depths need recalculating (May hold duplicates or removed nodes)
+	uint32 m_cachedDepthOffset = ~0U; // The maxDepthOffset the caches were built with
 public:
 	OctreeLayer* previousLayer = nullptr;
 	OctreeLayer* nextLayer = nullptr;
-	bool rebuildFlag = false;
+	bool rebuildFlag = false; // Has any node been marked as dirty since the last build
 
 public:
 	OctreeLayer(LayeredVolume* volume, const uint32& depth, const uint32& height, const uint32& nodeRes);
-	~OctreeLayer();
 
 	/**
 	* Handle when a value has been changed in the volume
@@ -218,22 +362,273 @@ public:
 	bool HandlePush(const uint32& x, const uint32& y, const uint32& z, const float& value);
 
 	/**
-	* Build a mesh starting at this layer
+	* Build a mesh starting at this layer, and upload it if anything has changed
+	* @param target				The mesh to upload to (Must be the same mesh every time)
 	* @param maxDepthOffset		How much deeped should be considered for meshing
-	* @param builder		The builder which will create this mesh
 	* @returns True if the mesh has changed
 	*/
-	bool BuildMesh(MeshBuilderMinimal& builder, const uint32& maxDepthOffset);
+	bool BuildMesh(Mesh* target, const uint32& maxDepthOffset);
+
+	/**
+	* Does this layer need rebuilding (Any of its nodes have been marked as dirty, or the depth offset has changed)
+	* @param maxDepthOffset		How much deeped should be considered for meshing
+	*/
+	inline bool RequiresRebuild(const uint32& maxDepthOffset) const { return rebuildFlag || maxDepthOffset != m_cachedDepthOffset; }
+
+	/**
+	* Build the mesh for this layer, only re-meshing the nodes which are dirty
+	* Nodes are meshed in blocks across the shared thread pool, then appended in order, so the result is the same for any number of threads
+	* (Only writes to this layer's caches, so different layers can be built at the same time)
+	* @param builder			The builder which will create this mesh
+	* @param maxDepthOffset		How much deeped should be considered for meshing
+	*/
+	void BuildNodeMeshes(MeshBuilderMinimal& builder, const uint32& maxDepthOffset);
+
+	/**
+	* Build the mesh for this layer into its arena, only rewriting the blocks which have been rebuilt
+	* Vertices which are shared between blocks are welded by giving every copy the same position and normal (As BuildNodeMeshes would)
+	* (Only writes to this layer, so different layers can be built at the same time)
+	* @param maxDepthOffset		How much deeped should be considered for meshing
+	*/
+	void PatchArena(const uint32& maxDepthOffset);
+
+	/**
+	* Upload any changes PatchArena has made (Must be called on the main thread)
+	* @param target				The mesh to upload to (Must be the same mesh every time)
+	*/
+	inline void UploadArena(Mesh* target) { m_arena.Upload(target); }
+
+	/**
+	* Call func for every node in this layer
+	* @param func				Called with each node
+	*/
+	template<typename Func>
+	inline void ForEachNode(Func func) const { m_nodes.ForEach(func); }
+
+	/**
+	* Mark every node whose mesh could be affected by a change to this voxel as dirty
+	* A node's mesh only depends on the voxels in its cell and its neighbours' cells (Through edge overrides, transition cells and merging), so
+	* that's every node within 1 cell of the cells touching this voxel
+	* (Expected to be called after the value has been pushed, so any nodes created/removed by it are accounted for)
+	* @param x,y,z				The world coordinate which has changed
+	*/
+	void MarkDirty(const uint32& x, const uint32& y, const uint32& z);
+
+	/**
+	* Mark every node in this layer as dirty, so the whole mesh is rebuilt
+	*/
+	void MarkAllDirty();
+
+	/**
+	* Recalculate the merge depth of every node which has been flagged as stale since the last call
+	* (Expects the next layer's stale nodes to have already been recalculated)
+	*/
+	void RecalculateStaleNodes();
+
+	/**
+	* Queue a node to have its merge depth recalculated by the next RecalculateStaleNodes
+	* @param id					The id of the node
+	*/
+	inline void QueueStaleNode(const uint32& id) { m_staleNodes.push_back(id); }
+
+private:
+	/**
+	* Re-mesh the dirty blocks across the shared thread pool
+	* @param maxDepthOffset		How much deeped should be considered for meshing
+	*/
+	void RebuildDirtyBlocks(const uint32& maxDepthOffset);
+
+	/**
+	* Register every vertex in a block's builder which could be shared with another block
+	* @param index				The index of the block
+	*/
+	void AddSharedVertices(const uint32& index);
+
+	/**
+	* Stop a block from using any shared vertices (Before it is rewritten or removed)
+	* @param index				The index of the block
+	*/
+	void RemoveSharedVertices(const uint32& index);
+
+	/**
+	* Re-mesh any dirty nodes in a block and weld the block's triangles together again
+	* @param index				The index of the block
+	* @param maxDepthOffset		How much deeped should be considered for meshing
+	*/
+	void RebuildBlock(const uint32& index, const uint32& maxDepthOffset);
+
+	/**
+	* Mark every node near this range of cells as dirty
+	* (Within 1 cell, or further for transition cells, as a split depends on the nodes around any pinched edges and the parent's neighbours)
+	* @param lower,upper		The first and last cell (Inclusive)
+	*/
+	void MarkCellsDirty(const uvec3& lower, const uvec3& upper);
+
+	/**
+	* Mark the block holding this node as needing to be rebuilt
+	* @param handle				The handle of the node
+	*/
+	inline void MarkBlockDirty(const uint32& handle)
+	{
+		const uint32 block = handle / NodesPerBuildJob;
+		if (block < m_buildBlocks.size())
+			m_buildBlocks[block].bIsDirty = true;
+		rebuildFlag = true;
+	}
+public:
 
 	/**
 	* Should the edge connecting these 2 points be overridden (i.e. is a high-res edge meeting a low-res edge)
 	* @param a,b				The desired edge to build (Only 1 axis is expected to change value in this pair)
 	* @param maxDepthOffset		How much deeped should be considered for meshing
 	* @param overrideOutput		Where to store the new edge, if overriden
+	* @param overrideID			Where to store the id of the edge the vertex has been moved onto, if it is now on a lower res edge
 	* @returns True if this edge has been overridden
 	*/
-	bool OverrideEdge(const uvec3& a, const uvec3& b, const uint32& maxDepthOffset, vec3& overrideOutput) const;
+	bool OverrideEdge(const uvec3& a, const uvec3& b, const uint32& maxDepthOffset, vec3& overrideOutput, uint64& overrideID) const;
+
+	/**
+	* OverrideEdge, but the result for each edge is remembered, so nodes which share the edge don't have to resolve it again
+	* (Nothing can change during a build, so the results stay valid until the cache is cleared)
+	* @param a,b				The desired edge to build (Only 1 axis is expected to change value in this pair)
+	* @param maxDepthOffset		How much deeped should be considered for meshing (Must be the same for every call until the cache is cleared)
+	* @param overrideCache		Where results are remembered
+	* @param overrideOutput		Where to store the new edge, if overriden
+	* @param overrideID			The id of the edge being built, which is replaced by the id of the edge the vertex has been moved onto, if overriden
+	* @returns True if this edge has been overridden
+	*/
+	inline bool OverrideEdgeCached(const uvec3& a, const uvec3& b, const uint32& maxDepthOffset, EdgeOverrideCache& overrideCache, vec3& overrideOutput, uint64& overrideID) const
+	{
+		bool isNew;
+		EdgeOverrideCache::Entry& entry = overrideCache.FindOrAdd(overrideID, isNew);
+		if (isNew)
+		{
+			entry.overrideId = overrideID;
+			entry.bIsOverridden = OverrideEdge(a, b, maxDepthOffset, entry.position, entry.overrideId);
+		}
+
+		if (!entry.bIsOverridden)
+			return false;
+
+		overrideOutput = entry.position;
+		overrideID = entry.overrideId;
+		return true;
+	}
+
+	/**
+	* Is this node split, so its children are meshed instead, when building from highestLayer
+	* In transition mode a node is only split once every neighbour of its parent is, so nodes are never meshed next to a neighbour
+	* more than a layer apart (Transition cells can only stitch a node onto its neighbour's children, as with Transvoxel)
+	* It also isn't split when one of its edges is pinched, unless all of the nodes around that edge are too (See IsEdgePinched and GetPinchedGroup)
+	* @param node				The node to check
+	* @param coords				The local coordinates of the node
+	* @param maxDepthOffset		How much deeper should be considered for meshing (In relation to this layer)
+	* @param highestLayer		The highest layer that is being built
+	* @returns True if the node's children are meshed instead of it, assuming its ancestors are split
+	*/
+	bool IsNodeSplit(const OctreeLayerNode* node, const uvec3& coords, const uint32& maxDepthOffset, const OctreeLayer* highestLayer) const;
+
+	/**
+	* Is the node at these coordinates being meshed at this layer's resolution, when building from highestLayer
+	* @param coords				The local coordinates of the node
+	* @param splitCoords		The local coordinates of a node in this layer which is being split (So its ancestors are known to be split too)
+	* @param maxDepthOffset		How much deeper should be considered for meshing (In relation to this layer)
+	* @param highestLayer		The highest layer that is being built
+	* @returns True if the node exists and isn't split, whilst all of its ancestors below highestLayer are
+	*/
+	bool IsNodeDrawn(const uvec3& coords, const uvec3& splitCoords, const uint32& maxDepthOffset, const OctreeLayer* highestLayer) const;
+
+	/**
+	* Are the nodes around this edge split in a checkerboard (Two diagonally opposite nodes are split, whilst the other two are meshed here)
+	* The transition cells on all 4 faces around the edge would join the same coarse and fine vertex along it, so both the nodes meshed
+	* here and the transition cells use the fine vertex instead (See GetFineEdgeVertex)
+	* @param start				The local coordinates of the edge's lowest corner
+	* @param axis				The axis (0-x, 1-y, 2-z) the edge runs along
+	* @param reachedCoords		The local coordinates of a node around the edge which is being split or meshed (So its ancestors are known to be split)
+	* @param maxDepthOffset		How much deeper should be considered for meshing (In relation to this layer)
+	* @param highestLayer		The highest layer that is being built
+	*/
+	bool IsEdgeSplitDiagonally(const uvec3& start, const uint32& axis, const uvec3& reachedCoords, const uint32& maxDepthOffset, const OctreeLayer* highestLayer) const;
+
+	/**
+	* IsEdgeSplitDiagonally, but the fine vertex is looked up and the result for each edge is remembered
+	* @param start				The local coordinates of the edge's lowest corner
+	* @param axis				The axis (0-x, 1-y, 2-z) the edge runs along
+	* @param reachedCoords		The local coordinates of a node around the edge which is being meshed
+	* @param maxDepthOffset		How much deeper should be considered for meshing (Must be the same for every call until the cache is cleared)
+	* @param highestLayer		The highest layer that is being built
+	* @param overrideCache		Where results are remembered
+	* @param fineOutput			Where to store the fine vertex, if the edge is split diagonally
+	* @param edgeID				The id of the edge being built, which is replaced by the id of the fine edge, if split diagonally
+	* @returns True if the edge is split diagonally
+	*/
+	inline bool IsEdgeSplitDiagonallyCached(const uvec3& start, const uint32& axis, const uvec3& reachedCoords, const uint32& maxDepthOffset, const OctreeLayer* highestLayer, EdgeOverrideCache& overrideCache, vec3& fineOutput, uint64& edgeID) const
+	{
+		bool isNew;
+		EdgeOverrideCache::Entry& entry = overrideCache.FindOrAdd(edgeID, isNew);
+		if (isNew)
+		{
+			entry.bIsOverridden = IsEdgeSplitDiagonally(start, axis, reachedCoords, maxDepthOffset, highestLayer);
+			if (entry.bIsOverridden)
+				GetFineEdgeVertex(start, axis, entry.position, entry.overrideId);
+		}
+
+		if (!entry.bIsOverridden)
+			return false;
+
+		fineOutput = entry.position;
+		edgeID = entry.overrideId;
+		return true;
+	}
+
+	/**
+	* Find the vertex which this layer's children build on this edge (On whichever half of it is crossed)
+	* (Expects the edge to be crossed once at this layer's resolution)
+	* @param start				The local coordinates of the edge's lowest corner
+	* @param axis				The axis (0-x, 1-y, 2-z) the edge runs along
+	* @param outVertex			Where to store the vertex
+	* @param outID				Where to store the id of the fine edge the vertex is on
+	*/
+	void GetFineEdgeVertex(const uvec3& start, const uint32& axis, vec3& outVertex, uint64& outID) const;
+
+	/**
+	* Does this edge cross the surface at both of its halves, but not from end to end
+	* (If only the nodes diagonally across it are split, their children close the surface off against the transition cells
+	* either side of it, leaving 2 pieces of the surface touching along the edge)
+	* @param start				The local coordinates of the edge's lowest corner
+	* @param axis				The axis (0-x, 1-y, 2-z) the edge runs along
+	*/
+	bool IsEdgePinched(const uvec3& start, const uint32& axis) const;
+
 private:
+	/**
+	* Are all of this node's ancestors below highestLayer split
+	* @param coords				The local coordinates of the node
+	* @param reachedCoords		The local coordinates of a node in this layer whose ancestors are known to be split
+	* @param maxDepthOffset		How much deeper should be considered for meshing (In relation to this layer)
+	* @param highestLayer		The highest layer that is being built
+	*/
+	bool AreAncestorsSplit(const uvec3& coords, const uvec3& reachedCoords, const uint32& maxDepthOffset, const OctreeLayer* highestLayer) const;
+
+	/**
+	* IsNodeSplit, without checking the node's edges are pinched
+	* @param node				The node to check
+	* @param coords				The local coordinates of the node
+	* @param maxDepthOffset		How much deeper should be considered for meshing (In relation to this layer)
+	* @param highestLayer		The highest layer that is being built
+	*/
+	bool IsNodeSplitBalanced(const OctreeLayerNode* node, const uvec3& coords, const uint32& maxDepthOffset, const OctreeLayer* highestLayer) const;
+
+	/**
+	* Find the node and every node which shares one of its pinched edges (See IsEdgePinched)
+	* (These have to split together, or the surface is left touching itself along the edge)
+	* @param node				The node to start from
+	* @param coords				The local coordinates of the node
+	* @param outCells			Where to store the group's coordinates, starting with the node's (Room for all 27 nodes around it)
+	* @returns How many nodes are in the group
+	*/
+	uint32 GetPinchedGroup(const OctreeLayerNode* node, const uvec3& coords, uvec3* outCells) const;
+
 	/**
 	* Project a high-res point onto a low-res edge
 	* @param a,b				The desired edge to build (Only 1 axis is expected to change value in this pair)
@@ -262,6 +657,58 @@ private:
 	*/
 	bool AttemptNodeOffsetFetch(const uvec3& localCoords, const ivec3& offset, OctreeLayerNode*& outNode) const;
 
+	/**
+	* Retrieve the handle of the node with this id
+	* @param id					The id of the node (Expected to be in this layer)
+	* @returns The handle of the node or InvalidHandle, if it doesn't exist
+	*/
+	inline uint32 FindHandle(const uint32& id) const
+	{
+		if (bIsDense)
+			return m_denseHandles[id - m_startIndex];
+
+		auto it = m_sparseHandles.find(id);
+		return it == m_sparseHandles.end() ? NodePool<OctreeLayerNode>::InvalidHandle : it->second;
+	}
+
+	/**
+	* Create a node in this layer's pool and store its handle
+	* @param id					The id of the node
+	* @param args				Anything else to pass to the node's constructor
+	* @returns The handle of the new node
+	*/
+	template<typename... Args>
+	uint32 CreateNode(const uint32& id, Args&&... args)
+	{
+		const uint32 handle = m_nodes.Create(id, std::forward<Args>(args)...);
+		if (bIsDense)
+			m_denseHandles[id - m_startIndex] = handle;
+		else
+			m_sparseHandles[id] = handle;
+
+		MarkBlockDirty(handle);
+		return handle;
+	}
+
+	/**
+	* Remove a node from this layer and return its slot to the pool
+	* @param id					The id of the node
+	* @param handle				The handle of the node
+	*/
+	void DestroyNode(const uint32& id, const uint32& handle);
+
+public:
+	/**
+	* Delete every node in this layer
+	*/
+	void ClearNodes();
+
+	/**
+	* Create every node in this layer directly from the volume's data, rather than pushing each value
+	* (Expects the next layer to have already been built, as nodes need to know which children exist)
+	*/
+	void BuildNodes();
+
 public:
 	/**
 	* Retreive the ID for this local coordinate
@@ -306,12 +753,22 @@ public:
 	inline uint32 GetNodeResolution() const { return m_nodeResolution; }
 	inline uint32 GetLayerResolution() const { return m_layerResolution; }
 	inline uint32 GetStride() const { return m_nodeResolution - 1; }
+	inline uint32 GetStrideLevel() const { return m_strideLevel; }
 	inline uint32 GetDepth() const { return m_depth; }
 
 	inline uint32 GetStartID() const { return m_startIndex; }
 	inline uint32 GetEndID() const { return m_endIndex; }
 
 	inline LayeredVolume* GetVolume() const { return m_volume; }
+
+	inline uint32 GetNodeCount() const { return m_nodes.GetCount(); }
+	inline bool IsDense() const { return bIsDense; }
+
+	/** How many indices are in the arena (Not including any gaps) */
+	inline uint32 GetArenaIndexCount() const { return m_arena.GetIndexCount(); }
+
+	/** How many bytes are being used to store this layer's nodes, their lookup and their cached triangles */
+	uint64 GetMemoryUsage() const;
 };
 
 
@@ -331,18 +788,49 @@ private:
 	std::vector<Mesh*> m_meshes;
 	uint32 currentLod;
 	uint32 lodDepth = 1;
+	LayeredSeamMode m_seamMode = LayeredSeamMode::EdgeOverride;
+
+	///
+	/// View LOD vars
+	///
+	/**
+	* A node which could be drawn by the view-dependent mesh
+	*/
+	struct ViewCandidate
+	{
+		OctreeLayer* layer;
+		OctreeLayerNode* node;
+		float priority; // The node's screen-space error (In pixels)
+	};
+
+	Mesh* m_viewMesh = nullptr;
+	MeshBuilderMinimal m_viewBuilder; // Kept between builds, so its buffers are re-used
+	std::unordered_set<uint32> m_viewSplitNodes; // Ids of the nodes which were split by the last selection
+	uint32 m_viewNodeCount = 0;
+	uint32 m_viewTriangleCount = 0;
+	uint32 m_viewTriangleBudget = 250000;
+	float m_viewPixelError = 4.0f;
+	float m_viewHysteresis = 0.25f;
+	vec3 m_viewLocation; // The view the last selection was made from
+	float m_viewFov = 0.0f;
+	float m_viewScreenHeight = 0.0f;
+	bool bUseViewLod = false;
+	bool bViewMeshStale = true; // Has the volume (Or the budget or pixel error) changed since the view mesh was last built
 
 	///
 	/// Volume vars
 	///
-	std::vector<float> m_data;
+	VoxelGrid m_data;
+	VoxelLayout m_layout = VoxelLayout::Linear;
+	std::vector<VoxelDelta> m_deltaBatch;
 	std::vector<OctreeLayer*> m_layers; // Declared in order from least depth to greatest
 	float m_isoLevel;
 	vec3 m_scale = vec3(1, 1, 1);
 	uvec3 m_resolution;
 	uint32 m_octreeRes;
+	bool bIsBulkLoading = false;
 
-	bool TEST_REBUILD;
+	bool TEST_REBUILD = false;
 
 public:
 	LayeredVolume();
@@ -365,6 +853,9 @@ public:
 	virtual VoxelBuildResults Rebuild(const std::vector<VoxelDelta>& deltas, VoxelBuildResults* recreation) override;
 
 	virtual void Set(uint32 x, uint32 y, uint32 z, float value) override;
+	virtual void ApplyDeltas(const std::vector<VoxelDelta>& deltas) override;
+	virtual void BeginBulkLoad() override;
+	virtual void EndBulkLoad() override;
 	virtual float Get(uint32 x, uint32 y, uint32 z) override; // TODO - FIX THAT GET
 	float Get(uint32 x, uint32 y, uint32 z) const;
 
@@ -373,12 +864,113 @@ public:
 
 	virtual float GetIsoLevel() const override { return m_isoLevel; }
 
+private:
+	/**
+	* Recalculate the merge depths of any nodes which have changed since the last build, from the deepest layer up
+	* (Pushes only flag nodes, so each node is recalculated once per build, rather than once per pushed value)
+	*/
+	void RecalculateStaleStats();
+
 	///
-	/// Getters & Setters
+	/// View LOD functions
 	///
+public:
+	/**
+	* Choose which nodes to draw from this point of view, then rebuild the view mesh if the selection or the volume has changed
+	* (Nothing is re-selected if neither the view nor the volume has changed since the last call)
+	* @param viewLocation		Where the camera is
+	* @param fov				The camera's vertical field of view (In degrees)
+	* @param screenHeight		The height of the screen (In pixels)
+	*/
+	void UpdateViewMesh(const vec3& viewLocation, const float& fov, const float& screenHeight);
+
+	/**
+	* Count the edges in the last view mesh which only have a triangle on one side
+	* (Vertices are matched by position, and edges on the sides of the volume are skipped, as the surface is cut off there)
+	* @returns How many open edges there are
+	*/
+	uint32 CountViewOpenEdges() const;
+
+	/**
+	* Count the edges in each layer's mesh which are open or have more than 2 triangles, as with CountViewOpenEdges
+	* (Only layers which are up to date are checked, as they're rebuilt from their caches)
+	* @param outOpenEdges		The most open edges in any layer
+	* @param outNonManifoldEdges	The most edges with more than 2 triangles in any layer
+	*/
+	void CountLayerSeams(uint32& outOpenEdges, uint32& outNonManifoldEdges);
+
 private:
-	inline uint32 GetIndex(uint32 x, uint32 y, uint32 z) const { return x + m_resolution.x * (y + m_resolution.y * z); }
+	/**
+	* Walk down from the coarsest layer, always splitting the node with the largest screen-space error into its children,
+	* until every node is within the pixel error or the next split would go over the triangle budget
+	* Nodes which were split by the last selection have their error scaled up by the hysteresis, so they don't merge again as soon as they fall within it
+	* (Neighbouring nodes are kept within 1 layer of each other, so every face between layers can be closed with a transition cell)
+	* @param viewLocation		Where the camera is
+	* @param fov				The camera's vertical field of view (In degrees)
+	* @param screenHeight		The height of the screen (In pixels)
+	* @param outNodes			Where to store the nodes to draw
+	* @returns True if a different set of nodes has been selected since the last call
+	*/
+	bool SelectViewNodes(const vec3& viewLocation, const float& fov, const float& screenHeight, std::vector<ViewCandidate>& outNodes);
+
+	/**
+	* Find every node which has to be split for this node to be split, so its children aren't more than 1 layer finer than any of their neighbours
+	* @param layer				The layer the node is in
+	* @param node				The node to split
+	* @param splitNodes			The ids of every node which is split so far (Any nodes which need splitting are added)
+	* @param outSplits			Where to add the nodes which need splitting (Coarsest first)
+	* @returns False if the node, or one of the neighbours it depends on, has no children to split into
+	*/
+	bool CollectViewSplits(OctreeLayer* layer, OctreeLayerNode* node, std::unordered_set<uint32>& splitNodes, std::vector<ViewCandidate>& outSplits) const;
+
+	/**
+	* Mesh every selected node at its own resolution, closing each face against a split neighbour with a transition cell, then weld it all together
+	* @param nodes				Every node to draw
+	*/
+	void BuildViewMesh(const std::vector<ViewCandidate>& nodes);
+
+	///
+	/// Getters & Setters
+	///
 public:
 	inline uint32 GetOctreeResolution() const { return m_octreeRes; }
+
+	/** Is this voxel a corner of any node (Nodes never read voxels between the corners of the deepest layer, so changes to them can't affect the meshes) */
+	inline bool IsOnNodeGrid(const uint32& x, const uint32& y, const uint32& z) const 
+	{
+		const uint32 stride = m_layers.back()->GetStride();
+		return x % stride == 0 && y % stride == 0 && z % stride == 0;
+	}
+
+	/** How the voxels should be laid out in memory (Only takes effect on the next Init) */
+	inline void SetLayout(const VoxelLayout& layout) { m_layout = layout; }
+	inline VoxelLayout GetLayout() const { return m_layout; }
+
+	/**
+	* Change how the gaps between resolutions are closed (Every layer is rebuilt on the next build)
+	* @param mode				The new seam mode
+	*/
+	void SetSeamMode(const LayeredSeamMode& mode);
+	inline LayeredSeamMode GetSeamMode() const { return m_seamMode; }
+
+	/** Should the mesh be chosen per node from the camera's point of view, rather than drawing a single layer's mesh */
+	inline void SetUseViewLod(const bool& use) { bUseViewLod = use; }
+	inline bool IsUsingViewLod() const { return bUseViewLod; }
+
+	/** The most triangles the view mesh's nodes should use (The coarsest layer is always drawn, even if it goes over, and the transition cells are on top of this) */
+	inline void SetViewTriangleBudget(const uint32& budget) { m_viewTriangleBudget = budget; bViewMeshStale = true; }
+	inline uint32 GetViewTriangleBudget() const { return m_viewTriangleBudget; }
+
+	/** How large a node's error can be on screen (In pixels) before it's split */
+	inline void SetViewPixelError(const float& error) { m_viewPixelError = error; bViewMeshStale = true; }
+	inline float GetViewPixelError() const { return m_viewPixelError; }
+
+	/** How far (As a fraction of the pixel error) a split node's error has to fall below the pixel error before it's merged again */
+	inline void SetViewHysteresis(const float& hysteresis) { m_viewHysteresis = glm::clamp(hysteresis, 0.0f, 0.9f); }
+	inline float GetViewHysteresis() const { return m_viewHysteresis; }
+
+	inline const Mesh* GetViewMesh() const { return m_viewMesh; }
+	inline uint32 GetViewTriangleCount() const { return m_viewTriangleCount; }
+	inline uint32 GetViewNodeCount() const { return m_viewNodeCount; }
 };
 
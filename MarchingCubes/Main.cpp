@@ -160,40 +160,18 @@ public:
 	{
 	
 		// Smooth edges based on density
-#define VERT_LERP(x0, y0, z0, x1, y1, z1) (vec3(x0 + x1, y0 + y1, z0 + z1) * 0.5f) * 10.0f;
 		vec3 temp;
 		vec3 edges[12];
 
 
-		if (MC::CaseRequiredEdges[m_caseIndex] & 1)
-			edges[0] = VERT_LERP(0, 0, 0, 1, 0, 0);
-		if (MC::CaseRequiredEdges[m_caseIndex] & 2)
-			edges[1] = VERT_LERP(1, 0, 0, 1, 0, 1);
-		if (MC::CaseRequiredEdges[m_caseIndex] & 4)
-			edges[2] = VERT_LERP(0, 0, 1, 1, 0, 1);
-		if (MC::CaseRequiredEdges[m_caseIndex] & 8)
-			edges[3] = VERT_LERP(0, 0, 0, 0, 0, 1);
-		if (MC::CaseRequiredEdges[m_caseIndex] & 16)
-			edges[4] = VERT_LERP(0, 1, 0, 1, 1, 0);
-		if (MC::CaseRequiredEdges[m_caseIndex] & 32)
-			edges[5] = VERT_LERP(1, 1, 0, 1, 1, 1);
-		if (MC::CaseRequiredEdges[m_caseIndex] & 64)
-			edges[6] = VERT_LERP(0, 1, 1, 1, 1, 1);
-		if (MC::CaseRequiredEdges[m_caseIndex] & 128)
-			edges[7] = VERT_LERP(0, 1, 0, 0, 1, 1);
-		if (MC::CaseRequiredEdges[m_caseIndex] & 256)
-			edges[8] = VERT_LERP(0, 0, 0, 0, 1, 0);
-		if (MC::CaseRequiredEdges[m_caseIndex] & 512)
-			edges[9] = VERT_LERP(1, 0, 0, 1, 1, 0);
-		if (MC::CaseRequiredEdges[m_caseIndex] & 1024)
-			edges[10] = VERT_LERP(1, 0, 1, 1, 1, 1);
-		if (MC::CaseRequiredEdges[m_caseIndex] & 2048)
-			edges[11] = VERT_LERP(0, 0, 1, 0, 1, 1);
+		for (uint32 e = 0; e < 12; ++e)
+			if (MC::CaseRequiredEdges[m_caseIndex] & (1 << e))
+				edges[e] = vec3(MC::CornerOffset(MC::EdgeCorners[e][0]) + MC::CornerOffset(MC::EdgeCorners[e][1])) * 0.5f * 10.0f;
 
 
 
 		// Add triangles for this case
-		int8* caseEdges = MC::Cases[m_caseIndex];
+		const int8* caseEdges = MC::Cases[m_caseIndex];
 		while (*caseEdges != -1)
 		{
 			int8 edge0 = *(caseEdges++);
@@ -211,46 +189,6 @@ public:
 };
 //*/
 
-#include "MarchingCubes.h"
-#include <iostream>
-
-void DebugFuncCreateSimpleCases() 
-{
-	for (uint32 i = 0; i < 255; ++i)
-	{
-		// Check all faces
-		uint32 r0 = (MC::CaseRequiredEdges[i] & 1) ? 1 : 0;
-		uint32 r1 = (MC::CaseRequiredEdges[i] & 2) ? 1 : 0;
-		uint32 r2 = (MC::CaseRequiredEdges[i] & 4) ? 1 : 0;
-		uint32 r3 = (MC::CaseRequiredEdges[i] & 8) ? 1 : 0;
-		uint32 r4 = (MC::CaseRequiredEdges[i] & 16) ? 1 : 0;
-		uint32 r5 = (MC::CaseRequiredEdges[i] & 32) ? 1 : 0;
-		uint32 r6 = (MC::CaseRequiredEdges[i] & 64) ? 1 : 0;
-		uint32 r7 = (MC::CaseRequiredEdges[i] & 128) ? 1 : 0;
-		uint32 r8 = (MC::CaseRequiredEdges[i] & 256) ? 1 : 0;
-		uint32 r9 = (MC::CaseRequiredEdges[i] & 512) ? 1 : 0;
-		uint32 r10 = (MC::CaseRequiredEdges[i] & 1024) ? 1 : 0;
-		uint32 r11 = (MC::CaseRequiredEdges[i] & 2048) ? 1 : 0;
-
-		if ((r0 + r1 + r2 + r3) > 2)
-			continue;
-		if ((r3 + r11 + r7 + r8) > 2)
-			continue;
-		if ((r0 + r9 + r4 + r8) > 2)
-			continue;
-		if ((r1 + r9 + r5 + r10) > 2)
-			continue;
-		if ((r2 + r10 + r6 + r11) > 2)
-			continue;
-		if ((r4 + r5 + r6 + r7) > 2)
-			continue;
-		
-		std::cout << (uint32)i << ", ";
-	}
-
-	return;
-}
-
 
 
 int main(int argc, char** argv)
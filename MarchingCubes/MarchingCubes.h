@@ -51,7 +51,7 @@ namespace MC
 	};
 
 	/// Lookup table for what triangles should be made for specific cases
-	static int8 Cases[256][16] =
+	static constexpr int8 Cases[256][16] =
 	{
 		{ -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1 },
 		{ 0, 8, 3, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1 },
@@ -312,7 +312,7 @@ namespace MC
 	};
 
 	/// Lookup table for which edges each case requires
-	static int16 CaseRequiredEdges[256] = {
+	static constexpr int16 CaseRequiredEdges[256] = {
 		0x0  , 0x109, 0x203, 0x30a, 0x406, 0x50f, 0x605, 0x70c,
 		0x80c, 0x905, 0xa0f, 0xb06, 0xc0a, 0xd03, 0xe09, 0xf00,
 		0x190, 0x99 , 0x393, 0x29a, 0x596, 0x49f, 0x795, 0x69c,
@@ -346,4 +346,125 @@ namespace MC
 		0xf00, 0xe09, 0xd03, 0xc0a, 0xb06, 0xa0f, 0x905, 0x80c,
 		0x70c, 0x605, 0x50f, 0x406, 0x30a, 0x203, 0x109, 0x0
 	};
-}
\ No newline at end of file
+
+	/// The (x, y, z) offset of each corner (Numbered by their bit in the case index) from the cell's origin
+	static constexpr uint8 CornerOffsets[8][3] =
+	{
+		{ 0, 0, 0 }, { 1, 0, 0 }, { 1, 0, 1 }, { 0, 0, 1 },
+		{ 0, 1, 0 }, { 1, 1, 0 }, { 1, 1, 1 }, { 0, 1, 1 }
+	};
+
+	/// Which corners each edge connects (Lowest corner first, so neighbouring cells interpolate a shared edge in the same direction)
+	static constexpr uint8 EdgeCorners[12][2] =
+	{
+		{ 0, 1 }, { 1, 2 }, { 3, 2 }, { 0, 3 },
+		{ 4, 5 }, { 5, 6 }, { 7, 6 }, { 4, 7 },
+		{ 0, 4 }, { 1, 5 }, { 2, 6 }, { 3, 7 }
+	};
+
+	/** The offset of this corner from the cell's origin */
+	inline uvec3 CornerOffset(const uint32& corner) { return uvec3(CornerOffsets[corner][0], CornerOffsets[corner][1], CornerOffsets[corner][2]); }
+
+	/** Check every edge steps a single voxel in the positive direction from its first corner to its second */
+	constexpr bool EdgeCornersAscend()
+	{
+		for (uint32 e = 0; e < 12; ++e)
+		{
+			uint32 steps = 0;
+			for (uint32 axis = 0; axis < 3; ++axis)
+			{
+				if (CornerOffsets[EdgeCorners[e][1]][axis] < CornerOffsets[EdgeCorners[e][0]][axis])
+					return false;
+				steps += CornerOffsets[EdgeCorners[e][1]][axis] - CornerOffsets[EdgeCorners[e][0]][axis];
+			}
+			if (steps != 1)
+				return false;
+		}
+		return true;
+	}
+	static_assert(EdgeCornersAscend(), "MC::EdgeCorners must list the lowest corner of each edge first");
+
+	/// Which edges lie on each face of the cell (Bottom, Top, Back, Front, Left, Right)
+	static constexpr uint8 FaceEdges[6][4] =
+	{
+		{ 0, 1, 2, 3 },
+		{ 4, 5, 6, 7 },
+		{ 0, 9, 4, 8 },
+		{ 2, 10, 6, 11 },
+		{ 3, 11, 7, 8 },
+		{ 1, 9, 5, 10 }
+	};
+
+
+	/**
+	* Facts about each case, which are worked out from the tables above at compile time
+	*/
+	struct CaseProperties
+	{
+		uint8 triangleCount[256];
+		uint8 vertexCount[256]; // How many distinct edges the triangles use
+		uint16 usedEdges[256]; // The edges the triangles use (Should always match CaseRequiredEdges)
+		uint32 simpleCases[8]; // Bitset of the cases which only contain a single connected face
+	};
+
+	/**
+	* Work out the properties for every case
+	* A case is simple if it isn't empty/full and none of its faces are intersected more than twice
+	*/
+	constexpr CaseProperties BuildCaseProperties()
+	{
+		CaseProperties props = {};
+
+		for (uint32 c = 0; c < 256; ++c)
+		{
+			for (uint32 i = 0; i < 16 && Cases[c][i] != -1; ++i)
+				props.usedEdges[c] |= (uint16)(1 << Cases[c][i]);
+
+			for (uint32 i = 0; i < 16 && Cases[c][i] != -1; i += 3)
+				++props.triangleCount[c];
+
+			for (uint32 e = 0; e < 12; ++e)
+				if ((CaseRequiredEdges[c] & (1 << e)) != 0)
+					++props.vertexCount[c];
+
+			bool isSimple = (c != 0 && c != 255);
+			for (uint32 f = 0; f < 6; ++f)
+			{
+				uint32 faceIntersections = 0;
+				for (uint32 i = 0; i < 4; ++i)
+					if ((CaseRequiredEdges[c] & (1 << FaceEdges[f][i])) != 0)
+						++faceIntersections;
+
+				if (faceIntersections > 2)
+					isSimple = false;
+			}
+
+			if (isSimple)
+				props.simpleCases[c / 32] |= (1U << (c % 32));
+		}
+
+		return props;
+	}
+
+	static constexpr CaseProperties CaseInfo = BuildCaseProperties();
+
+	/** Check every case's triangles only use the edges which CaseRequiredEdges says they do */
+	constexpr bool CaseTablesMatch()
+	{
+		for (uint32 c = 0; c < 256; ++c)
+			if (CaseInfo.usedEdges[c] != (uint16)CaseRequiredEdges[c])
+				return false;
+		return true;
+	}
+	static_assert(CaseTablesMatch(), "MC::Cases and MC::CaseRequiredEdges disagree");
+
+
+	/** How many triangles this case builds */
+	constexpr uint32 CaseTriangleCount(const uint8& caseIndex) { return CaseInfo.triangleCount[caseIndex]; }
+
+	/** How many vertices this case needs (One for each intersected edge) */
+	constexpr uint32 CaseVertexCount(const uint8& caseIndex) { return CaseInfo.vertexCount[caseIndex]; }
+
+	/** Does this case only contain a single connected face */
+	constexpr bool IsSimpleCase(const uint8& caseIndex) { return (CaseInfo.simpleCases[caseIndex / 32] & (1U << (caseIndex % 32))) != 0; }
+}
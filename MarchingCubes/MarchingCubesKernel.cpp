@@ -0,0 +1,395 @@
+#include "MarchingCubesKernel.h"
+#include "Logger.h"
+
+#include <cstring>
+
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__x86_64__) || defined(__i386__)
+#define MC_KERNEL_X86
+
+#include <immintrin.h>
+#ifdef _MSC_VER
+#include <intrin.h>
+#define MC_TARGET_AVX2
+#else
+#include <cpuid.h>
+#define MC_TARGET_AVX2 __attribute__((target("avx2")))
+#endif
+#endif
+
+
+// Same threshold used by MC::VertexLerp
+#define MC_CLOSE_VALUE 0.00001f
+
+
+
+///
+/// Scalar
+///
+
+template<typename T, typename IsoType>
+static uint32 ClassifyCellRowScalar(const T* row00, const T* row01, const T* row10, const T* row11, const uint32& start, const uint32& count, const IsoType& isoLevel, uint8* outCases)
+{
+	uint32 activeCount = 0;
+
+	for (uint32 x = start; x < count; ++x)
+	{
+		uint8 caseIndex = 0;
+		if (row00[x + 0] >= isoLevel) caseIndex |= 1;
+		if (row00[x + 1] >= isoLevel) caseIndex |= 2;
+		if (row01[x + 1] >= isoLevel) caseIndex |= 4;
+		if (row01[x + 0] >= isoLevel) caseIndex |= 8;
+		if (row10[x + 0] >= isoLevel) caseIndex |= 16;
+		if (row10[x + 1] >= isoLevel) caseIndex |= 32;
+		if (row11[x + 1] >= isoLevel) caseIndex |= 64;
+		if (row11[x + 0] >= isoLevel) caseIndex |= 128;
+
+		outCases[x] = caseIndex;
+		if (caseIndex != 0 && caseIndex != 255)
+			++activeCount;
+	}
+
+	return activeCount;
+}
+
+static void InterpolateEdgesScalar(const float* valueA, const float* valueB, float* outLerp, const uint32& start, const uint32& count, const float& isoLevel)
+{
+	for (uint32 i = start; i < count; ++i)
+	{
+		const float a = valueA[i];
+		const float b = valueB[i];
+
+		if (glm::abs(isoLevel - a) < MC_CLOSE_VALUE)
+			outLerp[i] = 0.0f;
+		else if (glm::abs(isoLevel - b) < MC_CLOSE_VALUE)
+			outLerp[i] = 1.0f;
+		else if (glm::abs(a - b) < MC_CLOSE_VALUE)
+			outLerp[i] = 0.0f;
+		else
+			outLerp[i] = (isoLevel - a) / (b - a);
+	}
+}
+
+
+
+#ifdef MC_KERNEL_X86
+
+/** Count how many bits are set in this mask */
+static inline uint32 BitCount(uint32 mask)
+{
+	uint32 count = 0;
+	for (; mask != 0; ++count)
+		mask &= mask - 1;
+	return count;
+}
+
+
+///
+/// SSE
+///
+
+static uint32 ClassifyCellRowSSE(const float* row00, const float* row01, const float* row10, const float* row11, const uint32& count, const float& isoLevel, uint8* outCases)
+{
+	const __m128 iso = _mm_set1_ps(isoLevel);
+	const __m128i trivialInside = _mm_set1_epi32(255);
+	const __m128i trivialOutside = _mm_setzero_si128();
+
+	uint32 activeCount = 0;
+	uint32 x = 0;
+
+	for (; x + 4 <= count; x += 4)
+	{
+		// Comparison sets every bit for a lane, so mask to the bit for that corner
+#define CORNER(row, offset, bit) _mm_and_si128(_mm_castps_si128(_mm_cmpge_ps(_mm_loadu_ps(row + x + offset), iso)), _mm_set1_epi32(bit))
+		__m128i cases = CORNER(row00, 0, 1);
+		cases = _mm_or_si128(cases, CORNER(row00, 1, 2));
+		cases = _mm_or_si128(cases, CORNER(row01, 1, 4));
+		cases = _mm_or_si128(cases, CORNER(row01, 0, 8));
+		cases = _mm_or_si128(cases, CORNER(row10, 0, 16));
+		cases = _mm_or_si128(cases, CORNER(row10, 1, 32));
+		cases = _mm_or_si128(cases, CORNER(row11, 1, 64));
+		cases = _mm_or_si128(cases, CORNER(row11, 0, 128));
+#undef CORNER
+
+		// Count cells which actually produce triangles
+		const __m128i trivial = _mm_or_si128(_mm_cmpeq_epi32(cases, trivialInside), _mm_cmpeq_epi32(cases, trivialOutside));
+		activeCount += 4 - BitCount(_mm_movemask_ps(_mm_castsi128_ps(trivial)));
+
+		// Narrow 4x32 to 4x8
+		__m128i packed = _mm_packs_epi32(cases, cases);
+		packed = _mm_packus_epi16(packed, packed);
+		const int32 bytes = _mm_cvtsi128_si32(packed);
+		memcpy(outCases + x, &bytes, 4);
+	}
+
+	return activeCount + ClassifyCellRowScalar(row00, row01, row10, row11, x, count, isoLevel, outCases);
+}
+
+static void InterpolateEdgesSSE(const float* valueA, const float* valueB, float* outLerp, const uint32& count, const float& isoLevel)
+{
+	const __m128 iso = _mm_set1_ps(isoLevel);
+	const __m128 closeValue = _mm_set1_ps(MC_CLOSE_VALUE);
+	const __m128 signMask = _mm_set1_ps(-0.0f);
+	const __m128 one = _mm_set1_ps(1.0f);
+
+	uint32 i = 0;
+	for (; i + 4 <= count; i += 4)
+	{
+		const __m128 a = _mm_loadu_ps(valueA + i);
+		const __m128 b = _mm_loadu_ps(valueB + i);
+
+		__m128 lerp = _mm_div_ps(_mm_sub_ps(iso, a), _mm_sub_ps(b, a));
+
+		// Snap to voxels when close (Applied in reverse order of priority used by MC::VertexLerp)
+		const __m128 closeA = _mm_cmplt_ps(_mm_andnot_ps(signMask, _mm_sub_ps(iso, a)), closeValue);
+		const __m128 closeB = _mm_cmplt_ps(_mm_andnot_ps(signMask, _mm_sub_ps(iso, b)), closeValue);
+		const __m128 closeAB = _mm_cmplt_ps(_mm_andnot_ps(signMask, _mm_sub_ps(a, b)), closeValue);
+
+		lerp = _mm_andnot_ps(closeAB, lerp);
+		lerp = _mm_or_ps(_mm_andnot_ps(closeB, lerp), _mm_and_ps(closeB, one));
+		lerp = _mm_andnot_ps(closeA, lerp);
+
+		_mm_storeu_ps(outLerp + i, lerp);
+	}
+
+	InterpolateEdgesScalar(valueA, valueB, outLerp, i, count, isoLevel);
+}
+
+
+///
+/// AVX2
+///
+
+MC_TARGET_AVX2 static uint32 ClassifyCellRowAVX2(const float* row00, const float* row01, const float* row10, const float* row11, const uint32& count, const float& isoLevel, uint8* outCases)
+{
+	const __m256 iso = _mm256_set1_ps(isoLevel);
+	const __m256i trivialInside = _mm256_set1_epi32(255);
+	const __m256i trivialOutside = _mm256_setzero_si256();
+
+	uint32 activeCount = 0;
+	uint32 x = 0;
+
+	for (; x + 8 <= count; x += 8)
+	{
+		// Comparison sets every bit for a lane, so mask to the bit for that corner
+#define CORNER(row, offset, bit) _mm256_and_si256(_mm256_castps_si256(_mm256_cmp_ps(_mm256_loadu_ps(row + x + offset), iso, _CMP_GE_OQ)), _mm256_set1_epi32(bit))
+		__m256i cases = CORNER(row00, 0, 1);
+		cases = _mm256_or_si256(cases, CORNER(row00, 1, 2));
+		cases = _mm256_or_si256(cases, CORNER(row01, 1, 4));
+		cases = _mm256_or_si256(cases, CORNER(row01, 0, 8));
+		cases = _mm256_or_si256(cases, CORNER(row10, 0, 16));
+		cases = _mm256_or_si256(cases, CORNER(row10, 1, 32));
+		cases = _mm256_or_si256(cases, CORNER(row11, 1, 64));
+		cases = _mm256_or_si256(cases, CORNER(row11, 0, 128));
+#undef CORNER
+
+		// Count cells which actually produce triangles
+		const __m256i trivial = _mm256_or_si256(_mm256_cmpeq_epi32(cases, trivialInside), _mm256_cmpeq_epi32(cases, trivialOutside));
+		activeCount += 8 - BitCount(_mm256_movemask_ps(_mm256_castsi256_ps(trivial)));
+
+		// Narrow 8x32 to 8x8
+		__m128i packed = _mm_packus_epi32(_mm256_castsi256_si128(cases), _mm256_extracti128_si256(cases, 1));
+		packed = _mm_packus_epi16(packed, packed);
+		_mm_storel_epi64((__m128i*)(outCases + x), packed);
+	}
+
+	return activeCount + ClassifyCellRowScalar(row00, row01, row10, row11, x, count, isoLevel, outCases);
+}
+
+MC_TARGET_AVX2 static void InterpolateEdgesAVX2(const float* valueA, const float* valueB, float* outLerp, const uint32& count, const float& isoLevel)
+{
+	const __m256 iso = _mm256_set1_ps(isoLevel);
+	const __m256 closeValue = _mm256_set1_ps(MC_CLOSE_VALUE);
+	const __m256 signMask = _mm256_set1_ps(-0.0f);
+	const __m256 zero = _mm256_setzero_ps();
+	const __m256 one = _mm256_set1_ps(1.0f);
+
+	uint32 i = 0;
+	for (; i + 8 <= count; i += 8)
+	{
+		const __m256 a = _mm256_loadu_ps(valueA + i);
+		const __m256 b = _mm256_loadu_ps(valueB + i);
+
+		__m256 lerp = _mm256_div_ps(_mm256_sub_ps(iso, a), _mm256_sub_ps(b, a));
+
+		// Snap to voxels when close (Applied in reverse order of priority used by MC::VertexLerp)
+		const __m256 closeA = _mm256_cmp_ps(_mm256_andnot_ps(signMask, _mm256_sub_ps(iso, a)), closeValue, _CMP_LT_OQ);
+		const __m256 closeB = _mm256_cmp_ps(_mm256_andnot_ps(signMask, _mm256_sub_ps(iso, b)), closeValue, _CMP_LT_OQ);
+		const __m256 closeAB = _mm256_cmp_ps(_mm256_andnot_ps(signMask, _mm256_sub_ps(a, b)), closeValue, _CMP_LT_OQ);
+
+		lerp = _mm256_blendv_ps(lerp, zero, closeAB);
+		lerp = _mm256_blendv_ps(lerp, one, closeB);
+		lerp = _mm256_blendv_ps(lerp, zero, closeA);
+
+		_mm256_storeu_ps(outLerp + i, lerp);
+	}
+
+	InterpolateEdgesScalar(valueA, valueB, outLerp, i, count, isoLevel);
+}
+
+
+///
+/// CPU detection
+///
+
+static void CpuId(int32 info[4], const int32& leaf, const int32& subLeaf)
+{
+#ifdef _MSC_VER
+	__cpuidex(info, leaf, subLeaf);
+#else
+	__cpuid_count(leaf, subLeaf, info[0], info[1], info[2], info[3]);
+#endif
+}
+
+static uint64 GetEnabledOSFeatures()
+{
+#ifdef _MSC_VER
+	return _xgetbv(0);
+#else
+	uint32 eax, edx;
+	__asm__("xgetbv" : "=a"(eax), "=d"(edx) : "c"(0));
+	return ((uint64)edx << 32) | eax;
+#endif
+}
+
+#endif
+
+
+
+/**
+* Find the best instruction set which this CPU supports
+*/
+static MC::KernelInstructionSet DetectInstructionSet()
+{
+#ifdef MC_KERNEL_X86
+	int32 info[4];
+	CpuId(info, 0, 0);
+	const int32 maxLeaf = info[0];
+
+	CpuId(info, 1, 0);
+	const bool hasSSE2 = (info[3] & (1 << 26)) != 0;
+	const bool hasOSXSave = (info[2] & (1 << 27)) != 0;
+	const bool hasAVX = (info[2] & (1 << 28)) != 0;
+
+	// OS must also save the YMM registers for AVX to be usable
+	if (maxLeaf >= 7 && hasOSXSave && hasAVX && (GetEnabledOSFeatures() & 6) == 6)
+	{
+		CpuId(info, 7, 0);
+		if ((info[1] & (1 << 5)) != 0)
+			return MC::KernelInstructionSet::AVX2;
+	}
+
+	if (hasSSE2)
+		return MC::KernelInstructionSet::SSE;
+#endif
+	return MC::KernelInstructionSet::Scalar;
+}
+
+/**
+* The best supported instruction set (Detected once)
+*/
+static MC::KernelInstructionSet GetSupportedInstructionSet()
+{
+	static const MC::KernelInstructionSet supported = DetectInstructionSet();
+	return supported;
+}
+
+/**
+* The instruction set currently in use
+*/
+static MC::KernelInstructionSet& GetCurrentInstructionSet()
+{
+	static MC::KernelInstructionSet current = GetSupportedInstructionSet();
+	return current;
+}
+
+
+
+namespace MC
+{
+	uint32 ClassifyCellRow(const float* row00, const float* row01, const float* row10, const float* row11, const uint32& count, const float& isoLevel, uint8* outCases)
+	{
+		switch (GetCurrentInstructionSet())
+		{
+#ifdef MC_KERNEL_X86
+		case KernelInstructionSet::AVX2:
+			return ClassifyCellRowAVX2(row00, row01, row10, row11, count, isoLevel, outCases);
+		case KernelInstructionSet::SSE:
+			return ClassifyCellRowSSE(row00, row01, row10, row11, count, isoLevel, outCases);
+#endif
+		default:
+			return ClassifyCellRowScalar(row00, row01, row10, row11, 0, count, isoLevel, outCases);
+		}
+	}
+
+	uint32 ClassifyCellRow(const uint8* row00, const uint8* row01, const uint8* row10, const uint8* row11, const uint32& count, const uint32& threshold, uint8* outCases)
+	{
+		// Integer compares are simple enough for the compiler to vectorize
+		return ClassifyCellRowScalar(row00, row01, row10, row11, 0, count, threshold, outCases);
+	}
+
+	uint32 ClassifyCellRow(const uint16* row00, const uint16* row01, const uint16* row10, const uint16* row11, const uint32& count, const uint32& threshold, uint8* outCases)
+	{
+		return ClassifyCellRowScalar(row00, row01, row10, row11, 0, count, threshold, outCases);
+	}
+
+	void InterpolateEdges(EdgeBatch& batch, const float& isoLevel)
+	{
+		const uint32 count = batch.Size();
+		batch.lerp.resize(count);
+		if (count == 0)
+			return;
+
+		switch (GetCurrentInstructionSet())
+		{
+#ifdef MC_KERNEL_X86
+		case KernelInstructionSet::AVX2:
+			InterpolateEdgesAVX2(batch.valueA.data(), batch.valueB.data(), batch.lerp.data(), count, isoLevel);
+			break;
+		case KernelInstructionSet::SSE:
+			InterpolateEdgesSSE(batch.valueA.data(), batch.valueB.data(), batch.lerp.data(), count, isoLevel);
+			break;
+#endif
+		default:
+			InterpolateEdgesScalar(batch.valueA.data(), batch.valueB.data(), batch.lerp.data(), 0, count, isoLevel);
+			break;
+		}
+	}
+
+
+	KernelInstructionSet GetKernelInstructionSet()
+	{
+		return GetCurrentInstructionSet();
+	}
+
+	KernelInstructionSet SetKernelInstructionSet(const KernelInstructionSet& set)
+	{
+		if (IsKernelInstructionSetSupported(set))
+			GetCurrentInstructionSet() = set;
+		else
+		{
+			LOG_WARNING("%s kernel is not supported on this CPU, using %s instead", GetKernelInstructionSetName(set), GetKernelInstructionSetName(GetSupportedInstructionSet()));
+			GetCurrentInstructionSet() = GetSupportedInstructionSet();
+		}
+
+		return GetCurrentInstructionSet();
+	}
+
+	bool IsKernelInstructionSetSupported(const KernelInstructionSet& set)
+	{
+		return (uint8)set <= (uint8)GetSupportedInstructionSet();
+	}
+
+	const char* GetKernelInstructionSetName(const KernelInstructionSet& set)
+	{
+		switch (set)
+		{
+		case KernelInstructionSet::AVX2:
+			return "AVX2";
+		case KernelInstructionSet::SSE:
+			return "SSE";
+		default:
+			return "Scalar";
+		}
+	}
+}
\ No newline at end of file
@@ -0,0 +1,152 @@
+///
+/// Vectorized kernel for the hot parts of MC
+/// Cells are classified a whole row at a time, then the edges which are actually needed are
+/// gathered into a batch and interpolated together
+///
+#pragma once
+#include "Common.h"
+#include <vector>
+
+
+namespace MC
+{
+	/**
+	* The instruction sets the kernel is able to use
+	*/
+	enum class KernelInstructionSet : uint8
+	{
+		Scalar = 0,
+		SSE,
+		AVX2
+	};
+
+
+	/// The corner (x, y, z offset) which each edge starts at and the axis (0-x, 1-y, 2-z) it runs along
+	static const uint8 EdgeStart[12][3] =
+	{
+		{ 0, 0, 0 }, { 1, 0, 0 }, { 0, 0, 1 }, { 0, 0, 0 },
+		{ 0, 1, 0 }, { 1, 1, 0 }, { 0, 1, 1 }, { 0, 1, 0 },
+		{ 0, 0, 0 }, { 1, 0, 0 }, { 1, 0, 1 }, { 0, 0, 1 }
+	};
+	static const uint8 EdgeAxis[12] = { 0, 2, 0, 2, 0, 2, 0, 2, 1, 1, 1, 1 };
+
+
+	/**
+	* A batch of edge intersections which are waiting to be interpolated
+	* Every edge is 1 voxel long and runs in the positive direction along a single axis from its start
+	* (Values are stored as structure-of-arrays, so the interpolation can be vectorized)
+	*/
+	struct EdgeBatch
+	{
+		std::vector<vec3> start;
+		std::vector<uint8> axis;
+		std::vector<float> valueA;
+		std::vector<float> valueB;
+		std::vector<float> lerp; // Output of InterpolateEdges
+
+		/**
+		* Add an edge to be interpolated
+		* @param edgeStart		The position of the first voxel
+		* @param edgeAxis		The axis (0-x, 1-y, 2-z) the edge runs along
+		* @param aVal			The value at the first voxel
+		* @param bVal			The value at the second voxel
+		*/
+		inline void Push(const vec3& edgeStart, const uint8& edgeAxis, const float& aVal, const float& bVal)
+		{
+			start.emplace_back(edgeStart);
+			axis.emplace_back(edgeAxis);
+			valueA.emplace_back(aVal);
+			valueB.emplace_back(bVal);
+		}
+
+		/**
+		* Get the final position of an interpolated edge
+		* @param i				The index of the edge in this batch
+		*/
+		inline vec3 GetVertex(const uint32& i) const
+		{
+			vec3 vertex = start[i];
+			vertex[axis[i]] += lerp[i];
+			return vertex;
+		}
+
+		inline uint32 Size() const { return valueA.size(); }
+
+		/**
+		* Make sure this many edges can be pushed without reallocating
+		* @param count			How many edges are expected
+		*/
+		inline void Reserve(const uint32& count)
+		{
+			start.reserve(count);
+			axis.reserve(count);
+			valueA.reserve(count);
+			valueB.reserve(count);
+			lerp.reserve(count);
+		}
+
+		inline void Clear()
+		{
+			start.clear();
+			axis.clear();
+			valueA.clear();
+			valueB.clear();
+			lerp.clear();
+		}
+	};
+
+
+	/**
+	* Classify a row of cells running along x
+	* @param row00				Values at (y, z) (Must contain count + 1 values)
+	* @param row01				Values at (y, z + 1)
+	* @param row10				Values at (y + 1, z)
+	* @param row11				Values at (y + 1, z + 1)
+	* @param count				How many cells are in the row
+	* @param isoLevel			The isoLevel to use in MC (Corners >= isoLevel are inside)
+	* @param outCases			Where to store the case index for each cell
+	* @returns How many of the cells are not fully inside or outside of the surface
+	*/
+	uint32 ClassifyCellRow(const float* row00, const float* row01, const float* row10, const float* row11, const uint32& count, const float& isoLevel, uint8* outCases);
+
+	/**
+	* Classify a row of cells running along x, which are stored as quantized samples
+	* @param row00,row01,row10,row11	Samples for each row (As above)
+	* @param count				How many cells are in the row
+	* @param threshold			The smallest sample which is inside of the surface
+	* @param outCases			Where to store the case index for each cell
+	* @returns How many of the cells are not fully inside or outside of the surface
+	*/
+	uint32 ClassifyCellRow(const uint8* row00, const uint8* row01, const uint8* row10, const uint8* row11, const uint32& count, const uint32& threshold, uint8* outCases);
+	uint32 ClassifyCellRow(const uint16* row00, const uint16* row01, const uint16* row10, const uint16* row11, const uint32& count, const uint32& threshold, uint8* outCases);
+
+	/**
+	* Interpolate every edge in this batch (Equivalent to calling MC::VertexLerp on each)
+	* @param batch				The edges to interpolate (Results are stored in batch.lerp)
+	* @param isoLevel			The isoLevel to use in MC
+	*/
+	void InterpolateEdges(EdgeBatch& batch, const float& isoLevel);
+
+
+	/**
+	* Get the instruction set which the kernel is currently using
+	* (Defaults to the best which is supported by the CPU)
+	*/
+	KernelInstructionSet GetKernelInstructionSet();
+
+	/**
+	* Force the kernel to use a specific instruction set
+	* @param set				The desired instruction set (Falls back to the best supported, if not available)
+	* @returns The instruction set which is now in use
+	*/
+	KernelInstructionSet SetKernelInstructionSet(const KernelInstructionSet& set);
+
+	/**
+	* Is this instruction set supported by the CPU we are running on
+	* @param set				The instruction set to check
+	*/
+	bool IsKernelInstructionSetSupported(const KernelInstructionSet& set);
+
+	/** Get a readable name for this instruction set */
+	const char* GetKernelInstructionSetName(const KernelInstructionSet& set);
+}
@@ -29,6 +29,13 @@ void WorldMaterialBase::Bind(const Window* window, const Level* level)
 	if (m_uniformViewToClip == 0)
 		m_uniformViewToClip = m_shader->GetUniform("ViewToClip");
 
+	if (m_uniformPackedVertices == 0)
+	{
+		m_uniformPackedVertices = m_shader->GetUniform("PackedVertices");
+		m_uniformPackedOrigin = m_shader->GetUniform("PackedOrigin");
+		m_uniformPackedExtent = m_shader->GetUniform("PackedExtent");
+	}
+
 
 	m_shader->SetUniformMat4(m_uniformWorldToView, level->GetCamera()->GetViewMatrix());
 	m_shader->SetUniformMat4(m_uniformViewToClip, level->GetCamera()->GetPerspectiveMatrix(window));
@@ -47,12 +54,20 @@ void WorldMaterialBase::PrepareMesh(const Mesh* mesh)
 	glBindVertexArray(mesh->GetID()); 
 	
 	m_boundMeshDrawTris = mesh->ContainsTriangles();
+	m_boundMeshShortIndices = mesh->UsesShortIndices();
 	m_boundMeshDrawCount = mesh->GetDrawCount();
+
+	m_shader->SetUniformInt(m_uniformPackedVertices, mesh->UsesPackedVertices() ? 1 : 0);
+	if (mesh->UsesPackedVertices())
+	{
+		m_shader->SetUniformVec3(m_uniformPackedOrigin, mesh->GetPackedOrigin());
+		m_shader->SetUniformVec3(m_uniformPackedExtent, mesh->GetPackedExtent());
+	}
 }
 
 void WorldMaterialBase::RenderInstance(Transform* transform)
 {
 	m_shader->SetUniformMat4(m_uniformObjectToWorld, transform == nullptr ? mat4(1.0f) : transform->GetTransformMatrix());
 
-	glDrawElements(m_boundMeshDrawTris ? GL_TRIANGLES : GL_QUADS, m_boundMeshDrawCount, GL_UNSIGNED_INT, nullptr);
+	glDrawElements(m_boundMeshDrawTris ? GL_TRIANGLES : GL_QUADS, m_boundMeshDrawCount, m_boundMeshShortIndices ? GL_UNSIGNED_SHORT : GL_UNSIGNED_INT, nullptr);
 }
\ No newline at end of file
@@ -63,8 +63,12 @@ protected:
 	uint32 m_uniformObjectToWorld;
 	uint32 m_uniformWorldToView;
 	uint32 m_uniformViewToClip;
+	uint32 m_uniformPackedVertices = 0;
+	uint32 m_uniformPackedOrigin = 0;
+	uint32 m_uniformPackedExtent = 0;
 
 	bool m_boundMeshDrawTris;
+	bool m_boundMeshShortIndices = false;
 	uint32 m_boundMeshDrawCount;
 
 public:
@@ -1,7 +1,62 @@
 #include "Mesh.h"
 #include "Logger.h"
 
+
+#ifdef HEADLESS_BUILD
+///
+/// Headless builds have no GL context, so only keep track of what would have been uploaded
+///
+
+Mesh::Mesh()
+{
+}
+Mesh::~Mesh()
+{
+}
+
+void Mesh::SetTriangles(const std::vector<uint32>& triangles)
+{
+	m_drawCount = triangles.size();
+	bUsesQuads = false;
+	bUsesShortIndices = false;
+}
+
+void Mesh::SetTriangles(const std::vector<uint16>& triangles)
+{
+	m_drawCount = triangles.size();
+	bUsesQuads = false;
+	bUsesShortIndices = true;
+}
+
+void Mesh::SetQuads(const std::vector<uint32>& quads)
+{
+	m_drawCount = quads.size();
+	bUsesQuads = true;
+	bUsesShortIndices = false;
+}
+
+void Mesh::SetBufferData(const uint32& index, const void* data, const uint32& size, const uint32& width, const bool& normalized)
+{
+}
+
+void Mesh::UpdateTriangles(const std::vector<uint32>& triangles, const uint32& first, const uint32& count)
+{
+}
+
+void Mesh::UpdateBufferData(const uint32& index, const void* data, const uint32& offset, const uint32& size)
+{
+}
+
+void Mesh::SetPackedVertices(const std::vector<PackedVertex>& vertices, const vec3& origin, const vec3& extent)
+{
+	m_packedOrigin = origin;
+	m_packedExtent = extent;
+	bUsesPackedVertices = true;
+}
+
+#else
 #include <GL\glew.h>
+#include <cstddef>
 
 
 Mesh::Mesh()
@@ -27,6 +82,25 @@ void Mesh::SetTriangles(const std::vector<uint32>& triangles)
 
 	m_drawCount = triangles.size();
 	bUsesQuads = false;
+	bUsesShortIndices = false;
+
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+	glBindVertexArray(0);
+}
+
+void Mesh::SetTriangles(const std::vector<uint16>& triangles)
+{
+	glBindVertexArray(m_id);
+
+	if (m_triId == 0)
+		glGenBuffers(1, &m_triId);
+
+	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_triId);
+	glBufferData(GL_ELEMENT_ARRAY_BUFFER, triangles.size() * sizeof(uint16), triangles.data(), bIsDynamic ? GL_DYNAMIC_DRAW : GL_STATIC_DRAW);
+
+	m_drawCount = triangles.size();
+	bUsesQuads = false;
+	bUsesShortIndices = true;
 
 	glBindBuffer(GL_ARRAY_BUFFER, 0);
 	glBindVertexArray(0);
@@ -44,6 +118,7 @@ void Mesh::SetQuads(const std::vector<uint32>& quads)
 
 	m_drawCount = quads.size();
 	bUsesQuads = true;
+	bUsesShortIndices = false;
 
 	glBindBuffer(GL_ARRAY_BUFFER, 0);
 	glBindVertexArray(0);
@@ -73,4 +148,57 @@ void Mesh::SetBufferData(const uint32& index, const void* data, const uint32& si
 
 	glBindBuffer(GL_ARRAY_BUFFER, 0);
 	glBindVertexArray(0);
+}
+
+void Mesh::UpdateTriangles(const std::vector<uint32>& triangles, const uint32& first, const uint32& count)
+{
+	glBindVertexArray(m_id);
+
+	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_triId);
+	glBufferSubData(GL_ELEMENT_ARRAY_BUFFER, first * sizeof(uint32), count * sizeof(uint32), triangles.data() + first);
+
+	glBindVertexArray(0);
+}
+
+void Mesh::UpdateBufferData(const uint32& index, const void* data, const uint32& offset, const uint32& size)
+{
+	glBindBuffer(GL_ARRAY_BUFFER, m_bufferId[index]);
+	glBufferSubData(GL_ARRAY_BUFFER, offset, size, data);
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
+
+void Mesh::SetPackedVertices(const std::vector<PackedVertex>& vertices, const vec3& origin, const vec3& extent)
+{
+	uint32& id = m_bufferId[0];
+	if (id == 0)
+		glGenBuffers(1, &id);
+
+	glBindVertexArray(m_id);
+
+	glBindBuffer(GL_ARRAY_BUFFER, id);
+	glBufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(PackedVertex), vertices.data(), bIsDynamic ? GL_DYNAMIC_DRAW : GL_STATIC_DRAW);
+
+	// Both attributes read from the same interleaved buffer
+	glEnableVertexAttribArray(0);
+	glVertexAttribPointer(0, 3, GL_UNSIGNED_SHORT, GL_TRUE, sizeof(PackedVertex), (void*)offsetof(PackedVertex, position));
+	glEnableVertexAttribArray(1);
+	glVertexAttribPointer(1, 2, GL_BYTE, GL_TRUE, sizeof(PackedVertex), (void*)offsetof(PackedVertex, normal));
+
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+	glBindVertexArray(0);
+
+	m_packedOrigin = origin;
+	m_packedExtent = extent;
+	bUsesPackedVertices = true;
+}
+#endif
+
+void Mesh::SetPackedMesh(const PackedMeshData& data)
+{
+	SetPackedVertices(data.vertices, data.origin, data.extent);
+
+	if (data.UsesShortIndices())
+		SetTriangles(data.shortIndices);
+	else
+		SetTriangles(data.indices);
 }
\ No newline at end of file
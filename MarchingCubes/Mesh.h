@@ -1,5 +1,6 @@
 #pragma once
 #include "Common.h"
+#include "PackedVertex.h"
 
 #include <vector>
 
@@ -12,6 +13,7 @@
 * -2:	Colours (4 floats)
 * -3:	UVs (2 floats)
 * -3+:	Reserved for UVs, but can be used for custom data
+* Packed vertices are interleaved into buffer 0, but still read through attributes 0 (Positions) and 1 (Normals)
 */
 class Mesh
 {
@@ -30,6 +32,11 @@ private:
 	///
 	bool bIsDynamic = false;
 	bool bUsesQuads = false;
+	bool bUsesShortIndices = false;
+	bool bUsesPackedVertices = false;
+
+	vec3 m_packedOrigin;
+	vec3 m_packedExtent = vec3(1, 1, 1);
 
 public:
 	Mesh();
@@ -41,6 +48,12 @@ public:
 	*/
 	void SetTriangles(const std::vector<uint32>& triangles);
 
+	/**
+	* Set all of the triangles indices for this mesh, using 16-bit indices
+	* @param trangles		List of the indices for drawing a triangle
+	*/
+	void SetTriangles(const std::vector<uint16>& triangles);
+
 	/**
 	* Set all of the quad indices for this mesh
 	* @param trangles		List of the indices for drawing a quad
@@ -51,7 +64,7 @@ public:
 	* Store vertices into the correct buffer
 	* @param vertices		The vertex information to store
 	*/
-	inline void SetVertices(const std::vector<vec3>& vertices) { SetBufferData(0, vertices.data(), vertices.size() * sizeof(vec3), 3, false); }
+	inline void SetVertices(const std::vector<vec3>& vertices) { bUsesPackedVertices = false; SetBufferData(0, vertices.data(), vertices.size() * sizeof(vec3), 3, false); }
 
 	/**
 	* Store normals into the correct buffer
@@ -72,6 +85,50 @@ public:
 	*/
 	inline void SetUVs(const std::vector<vec2>& uvs, const uint32& channel = 0) { SetBufferData(3 + channel, uvs.data(), uvs.size() * sizeof(vec2), 2, false); }
 
+	/**
+	* Store interleaved positions and normals (Replaces SetVertices and SetNormals)
+	* @param vertices		The vertex information to store
+	* @param origin			The minimum corner the positions were quantized relative to
+	* @param extent			The size of the bounds the positions were quantized across
+	*/
+	void SetPackedVertices(const std::vector<PackedVertex>& vertices, const vec3& origin, const vec3& extent);
+
+	/**
+	* Store the vertices and triangles of a packed mesh
+	* @param data			The packed mesh to store
+	*/
+	void SetPackedMesh(const PackedMeshData& data);
+
+	/**
+	* Overwrite part of the triangle indices (Must lie within what was last passed to SetTriangles)
+	* @param triangles		The full list of indices
+	* @param first			The first index to upload
+	* @param count			How many indices to upload
+	*/
+	void UpdateTriangles(const std::vector<uint32>& triangles, const uint32& first, const uint32& count);
+
+	/**
+	* Overwrite part of the vertices (Must lie within what was last passed to SetVertices)
+	* @param vertices		The full list of vertices
+	* @param first			The first vertex to upload
+	* @param count			How many vertices to upload
+	*/
+	inline void UpdateVertices(const std::vector<vec3>& vertices, const uint32& first, const uint32& count) { UpdateBufferData(0, vertices.data() + first, first * sizeof(vec3), count * sizeof(vec3)); }
+
+	/**
+	* Overwrite part of the normals (Must lie within what was last passed to SetNormals)
+	* @param normals		The full list of normals
+	* @param first			The first normal to upload
+	* @param count			How many normals to upload
+	*/
+	inline void UpdateNormals(const std::vector<vec3>& normals, const uint32& first, const uint32& count) { UpdateBufferData(1, normals.data() + first, first * sizeof(vec3), count * sizeof(vec3)); }
+
+	/**
+	* Only draw the first few indices (e.g. When the buffer has spare capacity on the end)
+	* @param count			How many indices to draw
+	*/
+	inline void SetDrawCount(const uint32& count) { m_drawCount = count; }
+
 
 private:
 	/**
@@ -84,6 +141,15 @@ private:
 	*/
 	void SetBufferData(const uint32& index, const void* data, const uint32& size, const uint32& width, const bool& normalized);
 
+	/**
+	* Overwrite part of a buffer which has already been filled
+	* @param index			The index of the buffer to update
+	* @param data			The pointer to the new data
+	* @param offset			Where in the buffer to start writing (In bytes)
+	* @param size			The size in bytes of the data to write
+	*/
+	void UpdateBufferData(const uint32& index, const void* data, const uint32& offset, const uint32& size);
+
 
 	///
 	/// Getters & Setters
@@ -94,6 +160,12 @@ public:
 
 	inline bool ContainsTriangles() const { return !bUsesQuads; }
 	inline bool ContainsQuads() const { return bUsesQuads; }
+	inline bool UsesShortIndices() const { return bUsesShortIndices; }
+
+	/** Are the vertices stored as PackedVertex, so need decoding in the shader */
+	inline bool UsesPackedVertices() const { return bUsesPackedVertices; }
+	inline const vec3& GetPackedOrigin() const { return m_packedOrigin; }
+	inline const vec3& GetPackedExtent() const { return m_packedExtent; }
 
 	/// Stores data into a faster to write place
 	inline void MarkDynamic() { bIsDynamic = true; }
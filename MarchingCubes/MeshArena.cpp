@@ -0,0 +1,286 @@
+#include "MeshArena.h"
+#include "Mesh.h"
+#include "MeshBuilder.h"
+
+#include <algorithm>
+
+
+///
+/// Range allocator
+///
+
+uint32 RangeAllocator::Allocate(const uint32& size)
+{
+	if (size == 0)
+		return 0;
+
+	for (auto it = m_freeRanges.begin(); it != m_freeRanges.end(); ++it)
+		if (it->second >= size)
+		{
+			const uint32 start = it->first;
+			const uint32 remaining = it->second - size;
+			m_freeRanges.erase(it);
+
+			if (remaining != 0)
+				m_freeRanges[start + size] = remaining;
+
+			m_freeCount -= size;
+			return start;
+		}
+
+	// Nothing free is large enough, so grow
+	const uint32 start = m_end;
+	m_end += size;
+	return start;
+}
+
+void RangeAllocator::Free(const uint32& start, const uint32& size)
+{
+	if (size == 0)
+		return;
+
+	uint32 freeStart = start;
+	uint32 freeSize = size;
+
+	// Merge with the range after
+	auto next = m_freeRanges.lower_bound(start);
+	if (next != m_freeRanges.end() && next->first == start + size)
+	{
+		freeSize += next->second;
+		next = m_freeRanges.erase(next);
+	}
+
+	// Merge with the range before
+	if (next != m_freeRanges.begin())
+	{
+		auto prev = std::prev(next);
+		if (prev->first + prev->second == start)
+		{
+			freeStart = prev->first;
+			freeSize += prev->second;
+			m_freeRanges.erase(prev);
+		}
+	}
+
+	m_freeCount += size;
+
+	// Give the space back to the end, rather than leave a free range there
+	if (freeStart + freeSize == m_end)
+	{
+		m_end = freeStart;
+		m_freeCount -= freeSize;
+	}
+	else
+		m_freeRanges[freeStart] = freeSize;
+}
+
+void RangeAllocator::Reset(const uint32& end)
+{
+	m_freeRanges.clear();
+	m_end = end;
+	m_freeCount = 0;
+}
+
+
+///
+/// Mesh arena
+///
+
+void MeshArena::Write(Range& range, const MeshBuilderMinimal& builder)
+{
+	const std::vector<vec3>& vertices = builder.GetVertices();
+	const std::vector<vec3>& normals = builder.GetNormals();
+	const std::vector<uint32>& indices = builder.GetIndices();
+	const uint32 vertexCount = vertices.size();
+	const uint32 indexCount = indices.size();
+
+	// Reuse the current ranges if the data still fits, otherwise move it somewhere else
+	if (vertexCount <= range.vertexCount)
+		m_vertexRanges.Free(range.vertexStart + vertexCount, range.vertexCount - vertexCount);
+	else
+	{
+		m_vertexRanges.Free(range.vertexStart, range.vertexCount);
+		range.vertexStart = m_vertexRanges.Allocate(vertexCount);
+	}
+	range.vertexCount = vertexCount;
+
+	if (indexCount <= range.indexCount)
+		FreeIndices(range.indexStart + indexCount, range.indexCount - indexCount);
+	else
+	{
+		FreeIndices(range.indexStart, range.indexCount);
+		range.indexStart = m_indexRanges.Allocate(indexCount);
+	}
+	range.indexCount = indexCount;
+
+	EnsureCapacity();
+
+
+	// Copy in the new data
+	std::copy(vertices.begin(), vertices.end(), m_vertices.begin() + range.vertexStart);
+	std::copy(normals.begin(), normals.end(), m_normals.begin() + range.vertexStart);
+	for (uint32 i = 0; i < indexCount; ++i)
+		m_indices[range.indexStart + i] = range.vertexStart + indices[i];
+
+	if (vertexCount != 0)
+		m_dirtyVertices.emplace_back(range.vertexStart, vertexCount);
+	if (indexCount != 0)
+		m_dirtyIndices.emplace_back(range.indexStart, indexCount);
+}
+
+void MeshArena::SetVertex(const Range& range, const uint32& index, const vec3& vertex, const vec3& normal)
+{
+	const uint32 offset = range.vertexStart + index;
+	m_vertices[offset] = vertex;
+	m_normals[offset] = normal;
+	m_dirtyVertices.emplace_back(offset, 1);
+}
+
+void MeshArena::SetNormal(const Range& range, const uint32& index, const vec3& normal)
+{
+	const uint32 vertex = range.vertexStart + index;
+	m_normals[vertex] = normal;
+	m_dirtyVertices.emplace_back(vertex, 1);
+}
+
+void MeshArena::Release(Range& range)
+{
+	m_vertexRanges.Free(range.vertexStart, range.vertexCount);
+	FreeIndices(range.indexStart, range.indexCount);
+	range = Range();
+}
+
+void MeshArena::FreeIndices(const uint32& start, const uint32& count)
+{
+	if (count == 0)
+		return;
+
+	std::fill(m_indices.begin() + start, m_indices.begin() + start + count, 0);
+	m_dirtyIndices.emplace_back(start, count);
+	m_indexRanges.Free(start, count);
+}
+
+void MeshArena::EnsureCapacity()
+{
+	// Grow by doubling, so full uploads become rarer as the mesh grows
+	if (m_vertexRanges.GetEnd() > m_vertices.size())
+	{
+		const uint32 capacity = glm::max(m_vertexRanges.GetEnd(), glm::max(1024U, (uint32)m_vertices.size() * 2));
+		m_vertices.resize(capacity);
+		m_normals.resize(capacity);
+		bRequiresFullUpload = true;
+	}
+
+	if (m_indexRanges.GetEnd() > m_indices.size())
+	{
+		const uint32 capacity = glm::max(m_indexRanges.GetEnd(), glm::max(3072U, (uint32)m_indices.size() * 2));
+		m_indices.resize(capacity, 0);
+		bRequiresFullUpload = true;
+	}
+}
+
+bool MeshArena::ShouldCompact() const
+{
+	// Only worth it once over half of the drawn indices are gaps
+	const uint32 indexEnd = m_indexRanges.GetEnd();
+	const uint32 vertexEnd = m_vertexRanges.GetEnd();
+	return (indexEnd > 3072 && m_indexRanges.GetFreeCount() * 2 > indexEnd) || (vertexEnd > 1024 && m_vertexRanges.GetFreeCount() * 2 > vertexEnd);
+}
+
+void MeshArena::Compact(const std::vector<Range*>& ranges)
+{
+	std::vector<vec3> vertices;
+	std::vector<vec3> normals;
+	std::vector<uint32> indices;
+	vertices.reserve(m_vertices.size());
+	normals.reserve(m_normals.size());
+	indices.reserve(m_indices.size());
+
+	for (Range* range : ranges)
+	{
+		const uint32 vertexStart = vertices.size();
+		vertices.insert(vertices.end(), m_vertices.begin() + range->vertexStart, m_vertices.begin() + range->vertexStart + range->vertexCount);
+		normals.insert(normals.end(), m_normals.begin() + range->vertexStart, m_normals.begin() + range->vertexStart + range->vertexCount);
+
+		const uint32 indexStart = indices.size();
+		for (uint32 i = 0; i < range->indexCount; ++i)
+			indices.push_back(m_indices[range->indexStart + i] - range->vertexStart + vertexStart);
+
+		range->vertexStart = vertexStart;
+		range->indexStart = indexStart;
+	}
+
+	m_vertexRanges.Reset(vertices.size());
+	m_indexRanges.Reset(indices.size());
+
+	// Keep the current capacity, so the buffers don't immediately have to grow again
+	vertices.resize(m_vertices.size());
+	normals.resize(m_normals.size());
+	indices.resize(m_indices.size(), 0);
+	m_vertices.swap(vertices);
+	m_normals.swap(normals);
+	m_indices.swap(indices);
+
+	m_dirtyVertices.clear();
+	m_dirtyIndices.clear();
+	bRequiresFullUpload = true;
+}
+
+template<typename Func>
+void MeshArena::MergeRanges(std::vector<uvec2>& ranges, Func upload)
+{
+	if (ranges.empty())
+		return;
+
+	std::sort(ranges.begin(), ranges.end(), [](const uvec2& a, const uvec2& b) { return a.x < b.x; });
+
+	uvec2 current = ranges[0];
+	for (uint32 i = 1; i < ranges.size(); ++i)
+	{
+		const uvec2& range = ranges[i];
+		if (range.x <= current.x + current.y)
+			current.y = glm::max(current.x + current.y, range.x + range.y) - current.x;
+		else
+		{
+			upload(current.x, current.y);
+			current = range;
+		}
+	}
+	upload(current.x, current.y);
+	ranges.clear();
+}
+
+void MeshArena::Upload(Mesh* target)
+{
+	if (bRequiresFullUpload)
+	{
+		target->SetVertices(m_vertices);
+		target->SetNormals(m_normals);
+		target->SetTriangles(m_indices);
+
+		m_lastUploadSize = m_vertices.size() * sizeof(vec3) * 2 + m_indices.size() * sizeof(uint32);
+		m_dirtyVertices.clear();
+		m_dirtyIndices.clear();
+		bRequiresFullUpload = false;
+	}
+	else
+	{
+		m_lastUploadSize = 0;
+
+		MergeRanges(m_dirtyVertices, [this, target](const uint32& first, const uint32& count)
+		{
+			target->UpdateVertices(m_vertices, first, count);
+			target->UpdateNormals(m_normals, first, count);
+			m_lastUploadSize += count * sizeof(vec3) * 2;
+		});
+
+		MergeRanges(m_dirtyIndices, [this, target](const uint32& first, const uint32& count)
+		{
+			target->UpdateTriangles(m_indices, first, count);
+			m_lastUploadSize += count * sizeof(uint32);
+		});
+	}
+
+	// Anything past the last range is spare capacity, so isn't drawn
+	target->SetDrawCount(m_indexRanges.GetEnd());
+}
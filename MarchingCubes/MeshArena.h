@@ -0,0 +1,158 @@
+#pragma once
+#include "Common.h"
+#include <vector>
+#include <map>
+
+
+class Mesh;
+class MeshBuilderMinimal;
+
+
+/**
+* Hands out ranges of a growable buffer, re-using ranges which have been freed (First fit)
+*/
+class RangeAllocator
+{
+private:
+	std::map<uint32, uint32> m_freeRanges; // start -> size (Neighbouring ranges are always merged)
+	uint32 m_end = 0; // Nothing at or past here is allocated
+	uint32 m_freeCount = 0; // How much of the space before m_end is free
+
+public:
+	/**
+	* Find space for a range of this size
+	* @param size				How many elements the range holds
+	* @returns The start of the range
+	*/
+	uint32 Allocate(const uint32& size);
+
+	/**
+	* Return a range, so it can be handed out again
+	* @param start				The start of the range
+	* @param size				How many elements the range holds
+	*/
+	void Free(const uint32& start, const uint32& size);
+
+	/**
+	* Forget every range, as if this many elements had been allocated in a single block
+	* @param end				How many elements are in use
+	*/
+	void Reset(const uint32& end = 0);
+
+	inline uint32 GetEnd() const { return m_end; }
+	inline uint32 GetFreeCount() const { return m_freeCount; }
+};
+
+
+/**
+* A single mesh made up of many independent pieces, which can each be rewritten without touching the others
+* Only the parts of the buffers which have changed are re-uploaded
+*/
+class MeshArena
+{
+public:
+	/**
+	* Where a single piece's vertices and indices live in the arena
+	*/
+	struct Range
+	{
+		uint32 vertexStart = 0;
+		uint32 vertexCount = 0;
+		uint32 indexStart = 0;
+		uint32 indexCount = 0;
+	};
+
+private:
+	std::vector<vec3> m_vertices;
+	std::vector<vec3> m_normals;
+	std::vector<uint32> m_indices; // Freed indices are left as 0, so draw as degenerate triangles
+
+	RangeAllocator m_vertexRanges;
+	RangeAllocator m_indexRanges;
+
+	std::vector<uvec2> m_dirtyVertices; // (first, count) of each part of the vertex buffers which needs uploading
+	std::vector<uvec2> m_dirtyIndices; // (first, count) of each part of the index buffer which needs uploading
+	bool bRequiresFullUpload = true;
+	uint32 m_lastUploadSize = 0;
+
+public:
+	/**
+	* Replace a piece's data with the contents of this builder
+	* @param range				The piece's current range (Updated to where the new data lives)
+	* @param builder			The new data for the piece
+	*/
+	void Write(Range& range, const MeshBuilderMinimal& builder);
+
+	/**
+	* Replace the position and normal of a single vertex in a piece
+	* @param range				The piece's range
+	* @param index				The index of the vertex within the piece
+	* @param vertex				The new position
+	* @param normal				The new normal
+	*/
+	void SetVertex(const Range& range, const uint32& index, const vec3& vertex, const vec3& normal);
+
+	/**
+	* Replace the normal of a single vertex in a piece
+	* @param range				The piece's range
+	* @param index				The index of the vertex within the piece
+	* @param normal				The new normal
+	*/
+	void SetNormal(const Range& range, const uint32& index, const vec3& normal);
+
+	/**
+	* Remove a piece from the arena
+	* @param range				The piece's range (Emptied)
+	*/
+	void Release(Range& range);
+
+	/** Has enough space been freed that it's worth calling Compact */
+	bool ShouldCompact() const;
+
+	/**
+	* Move every piece next to each other, so there are no gaps left (Requires a full upload afterwards)
+	* @param ranges				Every piece which is currently in the arena (Updated to where the data has moved)
+	*/
+	void Compact(const std::vector<Range*>& ranges);
+
+	/**
+	* Upload any changes to this mesh
+	* @param target				The mesh to upload to (Must be the same mesh every time)
+	*/
+	void Upload(Mesh* target);
+
+private:
+	/**
+	* Make sure the buffers are large enough for everything which has been allocated
+	*/
+	void EnsureCapacity();
+
+	/**
+	* Free a range of indices, filling them with degenerate triangles
+	* @param start				The first index
+	* @param count				How many indices to free
+	*/
+	void FreeIndices(const uint32& start, const uint32& count);
+
+	/**
+	* Merge any overlapping or touching ranges, then pass each of them to upload
+	* @param ranges				The (first, count) of each range (Cleared afterwards)
+	* @param upload				Called with the first and count of each merged range
+	*/
+	template<typename Func>
+	static void MergeRanges(std::vector<uvec2>& ranges, Func upload);
+
+
+	///
+	/// Getters & Setters
+	///
+public:
+	/** How many indices are in use (Not including any gaps) */
+	inline uint32 GetIndexCount() const { return m_indexRanges.GetEnd() - m_indexRanges.GetFreeCount(); }
+
+	/** The position of a vertex within a piece */
+	inline const vec3& GetVertex(const Range& range, const uint32& index) const { return m_vertices[range.vertexStart + index]; }
+
+	/** How many bytes were sent to the GPU by the last upload */
+	inline uint32 GetLastUploadSize() const { return m_lastUploadSize; }
+};
@@ -1,6 +1,7 @@
 #include "MeshBuilder.h"
 #include "Mesh.h"
 #include "Logger.h"
+#include <algorithm>
 
 #define GLM_ENABLE_EXPERIMENTAL
 #include <gtx\vector_angle.hpp>
@@ -12,7 +13,8 @@ MeshBuilderMinimal::MeshBuilderMinimal()
 }
 
 MeshBuilderMinimal::MeshBuilderMinimal(const MeshBuilderMinimal& other) :
-	bIsDynamic(other.bIsDynamic), m_vertices(other.m_vertices), m_normals(other.m_normals), m_indices(other.m_indices), m_indexLookup(other.m_indexLookup)
+	bIsDynamic(other.bIsDynamic), m_vertices(other.m_vertices), m_normals(other.m_normals), m_indices(other.m_indices), m_indexLookup(other.m_indexLookup),
+	m_edgeTable(other.m_edgeTable), m_edgeCount(other.m_edgeCount), m_edgeShift(other.m_edgeShift)
 {
 }
 
@@ -36,167 +38,194 @@ uint32 MeshBuilderMinimal::AddVertex(const vec3& vertex, const vec3& normal)
 	return index;
 }
 
-void MeshBuilderMinimal::BuildMesh(Mesh* target) const
+uint32 MeshBuilderMinimal::AddEdgeVertex(const uint64& edgeId, const vec3& vertex, const vec3& normal)
 {
-	if (bIsDynamic)
-		target->MarkDynamic();
+	// Keep the table at most half full, so probes stay short
+	if ((m_edgeCount + 1) * 2 > m_edgeTable.size())
+		ResizeEdgeTable(glm::max(64U, (uint32)m_edgeTable.size() * 2));
 
-	target->SetVertices(m_vertices);
-	target->SetNormals(m_normals);
-	target->SetTriangles(m_indices);
-}
+	const uint32 mask = m_edgeTable.size() - 1;
+	uint32 slot = GetEdgeSlot(edgeId);
 
-struct uvec2_KeyFuncs
-{
-	inline size_t operator()(const uvec2& v)const
+	while (true)
 	{
-		return std::hash<uint32>()(v.x) ^ std::hash<uint32>()(v.y);
-	}
+		EdgeEntry& entry = m_edgeTable[slot];
 
-	inline bool operator()(const uvec2& a, const uvec2& b)const
-	{
-		return a.x == b.x && a.y == b.y;
+		// Found vertex entry already
+		if (entry.id == edgeId)
+		{
+			m_normals[entry.index] += normal; // Smooths normals
+			return entry.index;
+		}
+
+		// Unique entry
+		if (entry.id == EmptyEdgeID)
+		{
+			entry.id = edgeId;
+			entry.index = m_vertices.size();
+			m_vertices.push_back(vertex);
+			m_normals.push_back(normal);
+			m_edgeCount++;
+			return entry.index;
+		}
+
+		slot = (slot + 1) & mask;
 	}
-};
+}
 
-void MeshBuilderMinimal::PerformEdgeCollapseReduction(const uint32& count)
+void MeshBuilderMinimal::Append(const MeshBuilderMinimal& other)
 {
-	// As per https://github.com/andandandand/progressive-mesh-reduction-with-edge-collapse
+	std::vector<uint64> edgeIds;
+	other.GetVertexEdgeIDs(edgeIds);
 
-	while(m_indices.size() > count)
+	// Add the vertices in their original order, so the result only depends on the order things are appended in
+	std::vector<uint32> remap(other.m_vertices.size());
+	for (uint32 i = 0; i < other.m_vertices.size(); ++i)
 	{
-		if (count == 0 && m_indices.size() < 8)
-			return;
-
-		std::unordered_map<uint32, std::unordered_map<uvec2, vec3, uvec2_KeyFuncs, uvec2_KeyFuncs>> triNormals;
-		std::unordered_map<uvec2, float, uvec2_KeyFuncs, uvec2_KeyFuncs> edgeCosts;
+		const vec3& vertex = other.m_vertices[i];
+		const vec3& normal = other.m_normals[i];
 
-		// Produce triangle lists
-		for (uint32 i = 0; i < m_indices.size(); i += 3)
+		if (edgeIds[i] != EmptyEdgeID)
+			remap[i] = AddEdgeVertex(edgeIds[i], vertex, normal);
+		else
 		{
-			const uint32& a = m_indices[i + 0];
-			const uint32& b = m_indices[i + 1];
-			const uint32& c = m_indices[i + 2];
-
-			const vec3& A = m_vertices[a];
-			const vec3& B = m_vertices[b];
-			const vec3& C = m_vertices[c];
-
-			// Add normal
-			const vec3 normal = normalize(cross(B - A, C - A));
-			triNormals[a][uvec2(b, c)] = normal;
-			triNormals[b][uvec2(a, c)] = normal;
-			triNormals[c][uvec2(a, b)] = normal;
-
-			// Init with empty costs
-			edgeCosts[uvec2(b, a)] = 0.0f;
-			edgeCosts[uvec2(c, a)] = 0.0f;
-
-			edgeCosts[uvec2(a, b)] = 0.0f;
-			edgeCosts[uvec2(c, b)] = 0.0f;
-
-			edgeCosts[uvec2(a, c)] = 0.0f;
-			edgeCosts[uvec2(b, c)] = 0.0f;
+			// Only vertices which were shared by position should be shared here
+			if (other.IsWeldedByPosition(i))
+				remap[i] = AddVertex(vertex, normal);
+			else
+			{
+				remap[i] = AddUniqueVertex(vertex);
+				m_normals[remap[i]] = normal;
+			}
 		}
+	}
 
-		// Calculate costs
-		for (auto& edge : edgeCosts)
-		{
-			// Calc cost for a->b
-			const uint32& a = edge.first.x;
-			const uint32& b = edge.first.y;
-			const float len = length(m_vertices[a] - m_vertices[b]);
+	m_indices.reserve(m_indices.size() + other.m_indices.size());
+	for (const uint32& index : other.m_indices)
+		m_indices.push_back(remap[index]);
+}
 
-			float cost = 0;
+void MeshBuilderMinimal::GetVertexEdgeIDs(std::vector<uint64>& outEdgeIds) const
+{
+	outEdgeIds.assign(m_vertices.size(), (uint64)EmptyEdgeID);
+	for (const EdgeEntry& entry : m_edgeTable)
+		if (entry.id != EmptyEdgeID)
+			outEdgeIds[entry.index] = entry.id;
+}
 
-			for (auto& triA : triNormals[a])
-			{
-				float minPart = 10000000000;
+void MeshBuilderMinimal::Clear()
+{
+	m_vertices.clear();
+	m_normals.clear();
+	m_indices.clear();
+	m_indexLookup.clear();
+
+	if (m_edgeCount != 0)
+	{
+		std::fill(m_edgeTable.begin(), m_edgeTable.end(), EdgeEntry{ EmptyEdgeID, 0 });
+		m_edgeCount = 0;
+	}
+}
 
-				for (auto& triAinner : triNormals[a])
-				{
-					// Triangle does't contain edge a->b
-					if (triAinner.first.x != b && triAinner.first.y != b)
-						continue;
+void MeshBuilderMinimal::Reserve(const uint32& triangleCount)
+{
+	// Closed MC surfaces end up with roughly half as many vertices as triangles
+	const uint32 vertexCount = triangleCount / 2 + 1;
+	m_vertices.reserve(vertexCount);
+	m_normals.reserve(vertexCount);
+	m_indices.reserve(triangleCount * 3);
+
+	uint32 capacity = 64;
+	while (capacity < vertexCount * 2)
+		capacity *= 2;
+
+	if (capacity > m_edgeTable.size())
+		ResizeEdgeTable(capacity);
+}
 
-					const float inner = (1.0f - dot(triA.second, triAinner.second)) * 0.5f;
-					if (inner < minPart)
-						minPart = inner;
-				}
+void MeshBuilderMinimal::ResizeEdgeTable(const uint32& capacity)
+{
+	std::vector<EdgeEntry> oldTable;
+	oldTable.swap(m_edgeTable);
 
-				if (minPart > cost)
-					cost = minPart;
-			}
+	m_edgeTable.resize(capacity, EdgeEntry{ EmptyEdgeID, 0 });
+	m_edgeShift = 64;
+	for (uint32 size = capacity; size > 1; size >>= 1)
+		m_edgeShift--;
 
-			edge.second = cost;
+	const uint32 mask = capacity - 1;
+	for (const EdgeEntry& entry : oldTable)
+		if (entry.id != EmptyEdgeID)
+		{
+			uint32 slot = GetEdgeSlot(entry.id);
+			while (m_edgeTable[slot].id != EmptyEdgeID)
+				slot = (slot + 1) & mask;
+			m_edgeTable[slot] = entry;
 		}
+}
 
+void MeshBuilderMinimal::BuildMesh(Mesh* target) const
+{
+	if (bIsDynamic)
+		target->MarkDynamic();
 
-		std::unordered_map<uint32, uint32> edgeMerges;
+	target->SetVertices(m_vertices);
+	target->SetNormals(m_normals);
+	target->SetTriangles(m_indices);
+}
 
-		// Remove edges
-		float minCost = 10000000000;
-		uvec2 minEdge;
+void MeshBuilderMinimal::Pack(const vec3& origin, const vec3& extent, PackedMeshData& out) const
+{
+	VertexPacking::Pack(m_vertices, m_normals, m_indices, origin, extent, out);
+}
 
-		// Find edge with smallest cost
-		for (auto& pair : edgeCosts)
-			if (pair.second != 0 && pair.second < minCost)
-			{
-				minCost = pair.second;
-				minEdge = pair.first;
-			}
+void MeshBuilderMinimal::BuildPackedMesh(Mesh* target, const vec3& origin, const vec3& extent) const
+{
+	if (bIsDynamic)
+		target->MarkDynamic();
 
-		// Add merged edge to table
-		edgeMerges[minEdge.x] = minEdge.y;
+	PackedMeshData packed;
+	Pack(origin, extent, packed);
+	target->SetPackedMesh(packed);
+}
 
+void MeshBuilderMinimal::Simplify(const SimplifySettings& settings, SimplifyStats* outStats)
+{
+	MeshSimplifier::Simplify(m_vertices, m_normals, m_indices, settings, outStats);
 
-		// Put new edges into mesh
-		std::vector<vec3> oldVertices = m_vertices;
-		std::vector<vec3> oldNormals = m_normals;
-		std::vector<uint32> oldIndices = m_indices;
+	m_indexLookup.clear();
+	m_edgeTable.clear();
+	m_edgeCount = 0;
+	m_edgeShift = 64;
+}
 
+VertexCacheStats MeshBuilderMinimal::OptimiseVertexCache()
+{
+	const VertexCacheStats stats = VertexCache::Optimise(m_vertices, m_normals, m_indices);
 
-		m_vertices.clear();
-		m_normals.clear();
-		m_indices.clear();
-		m_indexLookup.clear();
+	m_indexLookup.clear();
+	m_edgeTable.clear();
+	m_edgeCount = 0;
+	m_edgeShift = 64;
+	return stats;
+}
 
-		for (uint32 i = 0; i < oldIndices.size(); i += 3)
-		{
-			uint32 a = oldIndices[i + 0];
-			uint32 b = oldIndices[i + 1];
-			uint32 c = oldIndices[i + 2];
-
-			auto it = edgeMerges.find(a);
-			if (it != edgeMerges.end())
-				a = it->second;
-			it = edgeMerges.find(b);
-			if (it != edgeMerges.end())
-				b = it->second;
-			it = edgeMerges.find(c);
-			if (it != edgeMerges.end())
-				c = it->second;
-
-			const vec3& A = oldVertices[a];
-			const vec3& B = oldVertices[b];
-			const vec3& C = oldVertices[c];
-
-			// Ignore triangle which is malformed
-			if (A == B || A == C || B == C)
-				continue;
-
-
-			const vec3 normal = glm::cross(B - A, C - A);
-			const float normalLengthSqrd = dot(normal, normal);
-
-			// If normal is 0 it means the edge has been moved so the face is now a line
-			if (normalLengthSqrd != 0.0f && !std::isnan(normalLengthSqrd))
-			{
-				const uint32 na = AddVertex(A, normal);
-				const uint32 nb = AddVertex(B, normal);
-				const uint32 nc = AddVertex(C, normal);
-				AddTriangle(na, nb, nc);
-			}
-		}
+void MeshBuilderMinimal::BuildClusteredLods(std::vector<MeshBuilderMinimal>& outLods) const
+{
+	std::vector<LodMeshData> lods(outLods.size());
+	MeshSimplifier::BuildClusteredLods(m_vertices, m_indices, 2.0f, lods);
+
+	for (uint32 i = 0; i < outLods.size(); ++i)
+	{
+		MeshBuilderMinimal& lod = outLods[i];
+		lod.m_vertices.swap(lods[i].vertices);
+		lod.m_normals.swap(lods[i].normals);
+		lod.m_indices.swap(lods[i].indices);
+		lod.bIsDynamic = bIsDynamic;
+
+		lod.m_indexLookup.clear();
+		lod.m_edgeTable.clear();
+		lod.m_edgeCount = 0;
+		lod.m_edgeShift = 64;
 	}
-}
+}
\ No newline at end of file
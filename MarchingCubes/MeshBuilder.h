@@ -1,5 +1,8 @@
 #pragma once
 #include "Common.h"
+#include "MeshSimplifier.h"
+#include "VertexCache.h"
+#include "PackedVertex.h"
 #include <vector>
 #include <unordered_map>
 
@@ -19,6 +22,20 @@ private:
 	std::vector<uint32> m_indices;
 	std::unordered_map<vec3, uint32, vec3_KeyFuncs, vec3_KeyFuncs> m_indexLookup;
 
+	///
+	/// Edge welding vars
+	///
+	struct EdgeEntry
+	{
+		uint64 id;
+		uint32 index;
+	};
+	static const uint64 EmptyEdgeID = ~0ULL;
+
+	std::vector<EdgeEntry> m_edgeTable; // Open-addressed (Linear probing), with a power of 2 size
+	uint32 m_edgeCount = 0;
+	uint32 m_edgeShift = 64;
+
 public:
 	MeshBuilderMinimal();
 	MeshBuilderMinimal(const MeshBuilderMinimal& other);
@@ -31,6 +48,82 @@ public:
 	*/
 	uint32 AddVertex(const vec3& vertex, const vec3& normal = vec3(0, 1, 0));
 
+	/**
+	* Add this vertex to the recipe, sharing it with any other vertex which was added for the same edge
+	* (Vertices are only matched by edge id, so vertices added through AddVertex will never be shared with these)
+	* @param edgeId			The id of the edge this vertex lies on (See GetEdgeID)
+	* @param vertex			The position of the vertex
+	* @param normal			The normal of the vertex
+	* @returns The index of the vertex
+	*/
+	uint32 AddEdgeVertex(const uint64& edgeId, const vec3& vertex, const vec3& normal);
+
+	/**
+	* Get the id of the edge which runs along a single axis from this voxel
+	* @param start			The voxel which the edge starts at (Each component must be below 2^19)
+	* @param axis			The axis the edge runs along (0-x, 1-y, 2-z)
+	* @param level			The edge spans 2^level voxels
+	*/
+	static inline uint64 GetEdgeID(const uvec3& start, const uint32& axis, const uint32& level = 0)
+	{
+		return (uint64)start.x | ((uint64)start.y << 19) | ((uint64)start.z << 38) | ((uint64)axis << 57) | ((uint64)level << 59);
+	}
+
+	/**
+	* Add everything from another builder onto the end of this one
+	* Any vertices on the same edge (Or at the same position, if added through AddVertex) are welded and their normals summed
+	* @param other			The builder to copy from
+	*/
+	void Append(const MeshBuilderMinimal& other);
+
+	/**
+	* Find which edge each vertex was added for (See AddEdgeVertex)
+	* @param outEdgeIds		Where to store the edge id of each vertex (~0 for any vertex which wasn't added for an edge)
+	*/
+	void GetVertexEdgeIDs(std::vector<uint64>& outEdgeIds) const;
+
+	/**
+	* Is this vertex welded by its position when appended onto another builder (i.e. Was it added through AddVertex)
+	* @param index			The index of the vertex
+	*/
+	inline bool IsWeldedByPosition(const uint32& index) const
+	{
+		auto it = m_indexLookup.find(m_vertices[index]);
+		return it != m_indexLookup.end() && it->second == index;
+	}
+
+	/**
+	* Reserve enough space to build a mesh of roughly this size without having to reallocate
+	* @param triangleCount	The number of triangles which are expected
+	*/
+	void Reserve(const uint32& triangleCount);
+
+	/**
+	* Add this vertex to the recipe without checking for an existing entry
+	* (Caller is responsible for sharing the vertex, as it won't be found by AddVertex)
+	* @param vertex			The position of the vertex
+	* @returns The index of the vertex
+	*/
+	inline uint32 AddUniqueVertex(const vec3& vertex)
+	{
+		m_vertices.push_back(vertex);
+		m_normals.push_back(vec3(0, 0, 0));
+		return m_vertices.size() - 1;
+	}
+
+	/**
+	* Accumulate this normal onto an existing vertex (Smooths normals)
+	* @param index			The index of the vertex
+	* @param normal			The normal to add
+	*/
+	inline void AddNormal(const uint32& index, const vec3& normal) { m_normals[index] += normal; }
+
+	/**
+	* Get the position of a vertex which has already been added
+	* @param index			The index of the vertex
+	*/
+	inline const vec3& GetVertex(const uint32& index) const { return m_vertices[index]; }
+
 	/**
 	* Connects these 3 vertices to form a triangle
 	* @param a,b,c			The index of the vertices to connect (In anticlockwise order)
@@ -48,15 +141,65 @@ public:
 	*/
 	void BuildMesh(class Mesh* target) const;
 
+	/**
+	* Packs the stored data (See PackedVertex), ready to be uploaded
+	* @param origin			The minimum corner that positions are stored relative to
+	* @param extent			The size of the space the positions are spread over
+	* @param out			Where to store the packed mesh
+	*/
+	void Pack(const vec3& origin, const vec3& extent, PackedMeshData& out) const;
 
 	/**
-	* Simply the mesh by performing edge-collapse
-	* @param count			How many triangles to remove
+	* Builds a mesh from the stored data, in the packed vertex format
+	* @param target			The mesh to upload the data to
+	* @param origin			The minimum corner that positions are stored relative to
+	* @param extent			The size of the space the positions are spread over
 	*/
-	void PerformEdgeCollapseReduction(const uint32& count);
+	void BuildPackedMesh(class Mesh* target, const vec3& origin, const vec3& extent) const;
+
+
+	/**
+	* Simplify the mesh by collapsing edges in order of quadric error (See MeshSimplifier)
+	* (Vertices are re-indexed, so any added afterwards won't be shared with the existing ones)
+	* @param settings		When to stop simplifying and what to preserve
+	* @param outStats		Where to store how long each stage took (Optional)
+	*/
+	void Simplify(const SimplifySettings& settings, SimplifyStats* outStats = nullptr);
+
+	/**
+	* Build simplified copies of this mesh by clustering vertices onto a grid (See MeshSimplifier::BuildClusteredLods)
+	* Much quicker than Simplify, for when rebuild time matters more than quality
+	* @param outLods		Where to store each LOD (outLods[i] snaps onto cells 2^(i+1) units wide)
+	*/
+	void BuildClusteredLods(std::vector<MeshBuilderMinimal>& outLods) const;
+
+	/**
+	* Reorder the triangles and vertices to make better use of the GPU's vertex cache (See VertexCache)
+	* (Vertices are re-indexed, so any added afterwards won't be shared with the existing ones)
+	* @returns The average cache miss ratio before and after
+	*/
+	VertexCacheStats OptimiseVertexCache();
 
 	/** Should the resulting mesh be consider for dynamically uploading data*/
 	inline void MarkDynamic() { bIsDynamic = true; }
 
 	inline uint32 GetIndexCount() const { return m_indices.size(); }
+	inline uint32 GetVertexCount() const { return m_vertices.size(); }
+
+	inline const std::vector<vec3>& GetVertices() const { return m_vertices; }
+	inline const std::vector<vec3>& GetNormals() const { return m_normals; }
+	inline const std::vector<uint32>& GetIndices() const { return m_indices; }
+
+	/** Remove all of the stored data, but keep the memory for the next mesh */
+	void Clear();
+
+private:
+	/**
+	* Resize the edge table, re-inserting every edge which is already in it
+	* @param capacity		The new capacity (Must be a power of 2)
+	*/
+	void ResizeEdgeTable(const uint32& capacity);
+
+	/** The slot an edge id should start probing from */
+	inline uint32 GetEdgeSlot(const uint64& edgeId) const { return (uint32)((edgeId * 0x9E3779B97F4A7C15ULL) >> m_edgeShift); }
 };
\ No newline at end of file
@@ -0,0 +1,947 @@
+#include "MeshSimplifier.h"
+#include "ThreadPool.h"
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cstring>
+#include <unordered_map>
+
+
+bool Quadric::Optimise(vec3& outPoint) const
+{
+	// Solve A.p = -b using the inverse of the upper 3x3 (Cofactors, as it is symmetric)
+	const double c00 = yy * zz - yz * yz;
+	const double c01 = xz * yz - xy * zz;
+	const double c02 = xy * yz - xz * yy;
+	const double c11 = xx * zz - xz * xz;
+	const double c12 = xy * xz - xx * yz;
+	const double c22 = xx * yy - xy * xy;
+
+	const double det = xx * c00 + xy * c01 + xz * c02;
+	if (std::abs(det) < 1e-12)
+		return false;
+
+	const double invDet = -1.0 / det;
+	outPoint = vec3(
+		(c00 * xw + c01 * yw + c02 * zw) * invDet,
+		(c01 * xw + c11 * yw + c12 * zw) * invDet,
+		(c02 * xw + c12 * yw + c22 * zw) * invDet
+	);
+	return true;
+}
+
+
+namespace
+{
+	/// How much more boundary edges should resist moving than the surface itself
+	const float BoundaryWeight = 1000.0f;
+
+	/// Collapses are rejected if they would rotate any face by more than ~80 degrees
+	const float FlipThreshold = 0.2f;
+
+
+	/// No collapse has been found for this vertex
+	const uint32 InvalidIndex = ~0U;
+
+	/// How many vertices each job looks at, when costing every edge up front
+	const uint32 RecalculateBlockSize = 4096;
+
+	/// How many cells the mesh's bounds are split into along each axis, when sorting into Morton order
+	/// (The codes are radix sorted a cell's worth of bits at a time, so take 3 passes)
+	const uint32 MortonGridBits = 10;
+	const uint32 MortonGridSize = 1 << MortonGridBits;
+
+
+	/// Costs are queued by the top bits of their float representation (Which orders the same as the cost, for positive floats)
+	/// so each bucket of the queue covers a doubling of cost
+	const uint32 CostBucketShift = 23;
+	const uint32 CostBucketCount = 1 << (32 - CostBucketShift);
+
+	/**
+	* Which queue bucket a collapse of this cost goes in
+	*/
+	inline uint32 GetCostBucket(const float& cost)
+	{
+		uint32 bits;
+		std::memcpy(&bits, &cost, sizeof(bits));
+		return bits >> CostBucketShift;
+	}
+
+	inline int64 GetTimeMicroseconds()
+	{
+		using namespace std::chrono;
+		return duration_cast<microseconds>(high_resolution_clock::now().time_since_epoch()).count();
+	}
+
+
+	/**
+	* Everything needed to cost a collapse at a vertex (Kept together, so each neighbour only pulls in one place in memory)
+	*/
+	struct CollapseVertex
+	{
+		Quadric quadric;
+		vec3 position;
+		float bestCost = FLT_MAX;
+		uint32 bestOther = InvalidIndex;		// Which vertex it's cheapest to collapse this vertex with
+		uint32 firstTriangle = 0;				// Where this vertex's faces start in the face lists
+		uint32 triangleCount = 0;
+		bool bIsPinned = false;
+	};
+
+	/**
+	* The faces using a vertex (Which can include some that have been deleted since)
+	*/
+	struct TriangleList
+	{
+		const uint32* first;
+		const uint32* last;
+
+		inline const uint32* begin() const { return first; }
+		inline const uint32* end() const { return last; }
+	};
+
+	/**
+	* A face, along with the cost of collapsing each of its edges (Edge i runs from corner i to corner i + 1)
+	* Edges shared by 2 faces run opposite ways around each, so the cost is only stored on the face where the edge runs to the higher vertex
+	* (Edges on the boundary only have the one face, so always store it). The other entry is left at FLT_MAX
+	* Faces which have been removed are left with every corner on the same vertex
+	*/
+	struct CollapseTriangle
+	{
+		std::array<uint32, 3> corners;
+		std::array<float, 3> edgeCosts;
+		std::array<bool, 3> bIsBoundary;
+
+		inline bool IsDeleted() const { return corners[0] == corners[1]; }
+		inline bool Contains(const uint32& vertex) const { return corners[0] == vertex || corners[1] == vertex || corners[2] == vertex; }
+		inline bool StoresCost(const uint32& edge) const { return bIsBoundary[edge] || corners[edge] < corners[(edge + 1) % 3]; }
+	};
+
+
+	/**
+	* Working state while simplifying a single mesh
+	* The cost of collapsing every edge is cached on the faces, and each vertex tracks its cheapest edge, which is queued by cost in a bucketed
+	* priority queue. After each collapse only the edges around the kept vertex are re-evaluated, and its neighbours pick their cheapest edge
+	* again out of the cached costs
+	* The cheapest bucket is always drained first, but within a bucket collapses are performed in vertex order, which keeps memory access local
+	* (Neighbouring vertices are usually close by in the buffers) rather than jumping around the mesh for every collapse
+	*/
+	class QuadricSimplifier
+	{
+	private:
+		std::vector<vec3>& m_positions;
+		std::vector<uint32>& m_indices;
+		const SimplifySettings& m_settings;
+
+		std::vector<CollapseVertex> m_vertices;
+		std::vector<CollapseTriangle> m_triangles;
+		std::vector<uint32> m_vertexTriangles;	// Every vertex's faces, one after the other (A collapse writes the kept vertex's new list onto the end)
+		uint32 m_triangleCount = 0;
+
+		std::vector<uint32> m_touched;			// Every neighbour of the last collapse, so its best collapse may be out of date
+		std::vector<float> m_touchedCosts;		// The new cost of collapsing each of those neighbours with the kept vertex
+
+		std::array<std::vector<uint32>, CostBucketCount> m_queue; // Vertices waiting to collapse, by the bucket of their best cost (Including out of date entries)
+		uint32 m_currentBucket = 0;
+
+	public:
+		QuadricSimplifier(std::vector<vec3>& positions, std::vector<uint32>& indices, const SimplifySettings& settings) :
+			m_positions(positions), m_indices(indices), m_settings(settings)
+		{}
+
+		/**
+		* Collapse edges until the mesh is down to the target, or out of cheap enough collapses
+		* @param stats				Where to record the time taken and how many collapses were made
+		*/
+		void Run(SimplifyStats& stats);
+
+	private:
+		void Setup();
+		bool Evaluate(const uint32& a, const uint32& b, double& outCost, vec3& outTarget) const;
+		bool WouldFlip(const uint32& vertex, const uint32& other, const vec3& target) const;
+		void Collapse(const uint32& keep, const uint32& remove, const vec3& target);
+
+		/**
+		* Re-evaluate the cost of collapsing the edges connected to this vertex
+		* @param vertex				The vertex whose edges have changed
+		* @param outNeighbours		Where to store every vertex the edges connect to
+		* @param outCosts			Where to store the cost of each of those edges
+		*/
+		void UpdateEdges(const uint32& vertex, std::vector<uint32>& outNeighbours, std::vector<float>& outCosts);
+
+		/**
+		* Find the cheapest collapse out of every edge connected to this vertex (From the cached costs)
+		* @param vertex				The vertex to update
+		*/
+		void RecalculateBest(const uint32& vertex);
+
+		/**
+		* Queue a vertex's best collapse, if it's allowed
+		* @param vertex				The vertex to queue
+		*/
+		void Enqueue(const uint32& vertex);
+
+		inline TriangleList GetTriangles(const uint32& vertex) const
+		{
+			const uint32* first = m_vertexTriangles.data() + m_vertices[vertex].firstTriangle;
+			return TriangleList{ first, first + m_vertices[vertex].triangleCount };
+		}
+	};
+
+
+	void QuadricSimplifier::Setup()
+	{
+		const uint32 vertexCount = m_positions.size();
+		const uint32 triangleCount = m_indices.size() / 3;
+
+		m_vertices.resize(vertexCount);
+		m_triangles.resize(triangleCount);
+
+
+		// Work through the mesh in Morton order, so everything around a collapse is close together in memory
+		// (Meshes built in slices spread each neighbourhood across several slices' worth of the buffers)
+		vec3 boundsMin(FLT_MAX, FLT_MAX, FLT_MAX);
+		vec3 boundsMax(-FLT_MAX, -FLT_MAX, -FLT_MAX);
+		for (const vec3& position : m_positions)
+		{
+			boundsMin = glm::min(boundsMin, position);
+			boundsMax = glm::max(boundsMax, position);
+		}
+
+		const vec3 extent = boundsMax - boundsMin;
+		const float maxExtent = glm::max(extent.x, glm::max(extent.y, extent.z));
+		const float gridScale = (maxExtent > 0.0f ? (float)(MortonGridSize - 1) / maxExtent : 0.0f);
+
+		std::vector<uint32> keys(vertexCount);
+		for (uint32 v = 0; v < vertexCount; ++v)
+			keys[v] = (uint32)MortonEncode(uvec3((m_positions[v] - boundsMin) * gridScale));
+
+		// Radix sort the codes from the lowest bits up (Each pass is stable, so vertices in the same cell stay in their original order)
+		std::vector<uint32> order(vertexCount);
+		std::vector<uint32> sorted(vertexCount);
+		for (uint32 v = 0; v < vertexCount; ++v)
+			order[v] = v;
+
+		std::vector<uint32> digitStarts(MortonGridSize);
+		for (uint32 shift = 0; shift < MortonGridBits * 3; shift += MortonGridBits)
+		{
+			const uint32 mask = MortonGridSize - 1;
+			std::fill(digitStarts.begin(), digitStarts.end(), 0);
+			for (const uint32& key : keys)
+				digitStarts[(key >> shift) & mask]++;
+
+			uint32 start = 0;
+			for (uint32& digitStart : digitStarts)
+			{
+				const uint32 count = digitStart;
+				digitStart = start;
+				start += count;
+			}
+
+			for (const uint32& v : order)
+				sorted[digitStarts[(keys[v] >> shift) & mask]++] = v;
+			order.swap(sorted);
+		}
+
+		std::vector<uint32> remap(vertexCount);
+		for (uint32 v = 0; v < vertexCount; ++v)
+		{
+			remap[order[v]] = v;
+			m_vertices[v].position = m_positions[order[v]];
+		}
+
+		// Faces are ordered by their lowest corner (Counting sort, as there are only as many keys as vertices)
+		std::vector<uint32> triangleStarts(vertexCount + 1, 0);
+		for (uint32 t = 0; t < triangleCount; ++t)
+			triangleStarts[glm::min(remap[m_indices[t * 3]], glm::min(remap[m_indices[t * 3 + 1]], remap[m_indices[t * 3 + 2]])) + 1]++;
+		for (uint32 v = 0; v < vertexCount; ++v)
+			triangleStarts[v + 1] += triangleStarts[v];
+
+		for (uint32 t = 0; t < triangleCount; ++t)
+		{
+			const std::array<uint32, 3> corners = { remap[m_indices[t * 3]], remap[m_indices[t * 3 + 1]], remap[m_indices[t * 3 + 2]] };
+			CollapseTriangle& triangle = m_triangles[triangleStarts[glm::min(corners[0], glm::min(corners[1], corners[2]))]++];
+			triangle.corners = corners;
+			triangle.edgeCosts.fill(FLT_MAX);
+			triangle.bIsBoundary.fill(false);
+		}
+
+
+		// Accumulate the plane of each face onto its corners (Weighted by area, so slivers don't dominate)
+		for (uint32 t = 0; t < triangleCount; ++t)
+		{
+			CollapseTriangle& triangle = m_triangles[t];
+			const std::array<uint32, 3>& tri = triangle.corners;
+			if (tri[0] == tri[1] || tri[0] == tri[2] || tri[1] == tri[2])
+			{
+				triangle.corners.fill(tri[0]);
+				continue;
+			}
+
+			const vec3& A = m_vertices[tri[0]].position;
+			const vec3 normal = glm::cross(m_vertices[tri[1]].position - A, m_vertices[tri[2]].position - A);
+			const float length = glm::length(normal);
+
+			if (length > 0.0f)
+			{
+				const Quadric plane = Quadric::FromPlane(normal / length, A, length * 0.5f);
+				m_vertices[tri[0]].quadric += plane;
+				m_vertices[tri[1]].quadric += plane;
+				m_vertices[tri[2]].quadric += plane;
+			}
+
+			m_vertices[tri[0]].triangleCount++;
+			m_vertices[tri[1]].triangleCount++;
+			m_vertices[tri[2]].triangleCount++;
+			m_triangleCount++;
+		}
+
+		// Lay the face lists out in vertex order, with room for the lists collapses write on the end
+		// (Each collapse writes out the kept vertex's whole list, so simplifying right down adds a little more than the starting lists again)
+		uint32 listEnd = 0;
+		for (CollapseVertex& vertex : m_vertices)
+		{
+			vertex.firstTriangle = listEnd;
+			listEnd += vertex.triangleCount;
+			vertex.triangleCount = 0;
+		}
+
+		m_vertexTriangles.reserve(listEnd * 5 / 2);
+		m_vertexTriangles.resize(listEnd);
+		for (uint32 t = 0; t < triangleCount; ++t)
+			if (!m_triangles[t].IsDeleted())
+				for (const uint32& corner : m_triangles[t].corners)
+				{
+					CollapseVertex& vertex = m_vertices[corner];
+					m_vertexTriangles[vertex.firstTriangle + vertex.triangleCount++] = t;
+				}
+
+
+		// Stop boundary edges from drifting, by adding a plane perpendicular to their face
+		// (Each edge is only found from the vertex it leaves, so only gets looked at once)
+		std::vector<std::array<uint32, 2>> fan;
+		for (uint32 a = 0; a < vertexCount; ++a)
+		{
+			// The other 2 corners of each face around the vertex, so they can be compared without going back to the faces
+			fan.clear();
+			for (const uint32& t : GetTriangles(a))
+			{
+				const std::array<uint32, 3>& tri = m_triangles[t].corners;
+				const uint32 corner = (tri[0] == a ? 0 : tri[1] == a ? 1 : 2);
+				fan.push_back({ tri[(corner + 1) % 3], tri[(corner + 2) % 3] });
+			}
+
+			const TriangleList triangles = GetTriangles(a);
+			for (uint32 i = 0; i < fan.size(); ++i)
+			{
+				const uint32 t = triangles.first[i];
+				const std::array<uint32, 3>& tri = m_triangles[t].corners;
+				const uint32 corner = (tri[0] == a ? 0 : tri[1] == a ? 1 : 2);
+				const uint32 b = fan[i][0];
+
+				// Edges which only belong to 1 face are on the boundary of the mesh
+				bool isShared = false;
+				for (uint32 j = 0; j < fan.size(); ++j)
+					if (j != i && (fan[j][0] == b || fan[j][1] == b))
+					{
+						isShared = true;
+						break;
+					}
+				if (isShared)
+					continue;
+
+				m_triangles[t].bIsBoundary[corner] = true;
+				const vec3 edge = m_vertices[b].position - m_vertices[a].position;
+				const vec3 faceNormal = glm::cross(m_vertices[tri[1]].position - m_vertices[tri[0]].position, m_vertices[tri[2]].position - m_vertices[tri[0]].position);
+				const vec3 normal = glm::cross(edge, faceNormal);
+				const float length = glm::length(normal);
+
+				if (length > 0.0f)
+				{
+					const Quadric plane = Quadric::FromPlane(normal / length, m_vertices[a].position, BoundaryWeight * glm::dot(edge, edge));
+					m_vertices[a].quadric += plane;
+					m_vertices[b].quadric += plane;
+				}
+			}
+		}
+
+
+		// Pin any vertices on a chunk boundary
+		if (m_settings.chunkSize > 0.0f)
+		{
+			const float invChunkSize = 1.0f / m_settings.chunkSize;
+			for (uint32 v = 0; v < vertexCount; ++v)
+			{
+				const vec3 chunkCoord = m_vertices[v].position * invChunkSize;
+				for (uint32 axis = 0; axis < 3; ++axis)
+					if (std::abs(chunkCoord[axis] - std::round(chunkCoord[axis])) < 1e-4f)
+						m_vertices[v].bIsPinned = true;
+			}
+		}
+	}
+
+	bool QuadricSimplifier::Evaluate(const uint32& a, const uint32& b, double& outCost, vec3& outTarget) const
+	{
+		const CollapseVertex& vertexA = m_vertices[a];
+		const CollapseVertex& vertexB = m_vertices[b];
+
+		// Nowhere for this edge to go
+		if (vertexA.bIsPinned && vertexB.bIsPinned)
+			return false;
+
+		const Quadric quadric = vertexA.quadric + vertexB.quadric;
+		const vec3& A = vertexA.position;
+		const vec3& B = vertexB.position;
+
+		vec3 target;
+		double cost;
+
+		if (vertexA.bIsPinned || vertexB.bIsPinned)
+		{
+			target = vertexA.bIsPinned ? A : B;
+			cost = quadric.Evaluate(target);
+		}
+		else
+		{
+			// Only trust the optimal point if it is near to the edge (Nearly singular quadrics can throw it miles away)
+			const vec3 midpoint = (A + B) * 0.5f;
+			const vec3 edge = B - A;
+
+			if (quadric.Optimise(target) && glm::dot(target - midpoint, target - midpoint) <= glm::dot(edge, edge))
+				cost = quadric.Evaluate(target);
+			else
+			{
+				// Just pick the best out of the ends and the middle
+				target = midpoint;
+				cost = quadric.Evaluate(midpoint);
+
+				const double costA = quadric.Evaluate(A);
+				if (costA < cost)
+				{
+					target = A;
+					cost = costA;
+				}
+				const double costB = quadric.Evaluate(B);
+				if (costB < cost)
+				{
+					target = B;
+					cost = costB;
+				}
+			}
+		}
+
+		outCost = glm::max(cost, 0.0);
+		outTarget = target;
+		return true;
+	}
+
+	bool QuadricSimplifier::WouldFlip(const uint32& vertex, const uint32& other, const vec3& target) const
+	{
+		for (const uint32& t : GetTriangles(vertex))
+		{
+			// Faces which contain the edge will be removed, so don't matter
+			const CollapseTriangle& triangle = m_triangles[t];
+			if (triangle.IsDeleted() || triangle.Contains(other))
+				continue;
+
+			const std::array<uint32, 3>& tri = triangle.corners;
+			vec3 corners[3] = { m_vertices[tri[0]].position, m_vertices[tri[1]].position, m_vertices[tri[2]].position };
+			const vec3 oldNormal = glm::cross(corners[1] - corners[0], corners[2] - corners[0]);
+
+			for (uint32 i = 0; i < 3; ++i)
+				if (tri[i] == vertex)
+					corners[i] = target;
+			const vec3 newNormal = glm::cross(corners[1] - corners[0], corners[2] - corners[0]);
+
+			const float oldLength2 = glm::dot(oldNormal, oldNormal);
+			const float newLength2 = glm::dot(newNormal, newNormal);
+			if (newLength2 == 0.0f)
+				return true;
+			if (oldLength2 == 0.0f)
+				continue;
+
+			// Compare the squares, to save a square root (Faces turned more than 90 degrees always flip)
+			const float alignment = glm::dot(oldNormal, newNormal);
+			if (alignment < 0.0f || alignment * alignment < FlipThreshold * FlipThreshold * oldLength2 * newLength2)
+				return true;
+		}
+
+		return false;
+	}
+
+	void QuadricSimplifier::Collapse(const uint32& keep, const uint32& remove, const vec3& target)
+	{
+		m_vertices[keep].position = target;
+		m_vertices[keep].quadric += m_vertices[remove].quadric;
+		m_vertices[remove].bestOther = InvalidIndex;
+
+		// Move the faces over onto the kept vertex, removing any which collapsed
+		// (The new list is written onto the end, which only reallocates if a mesh has far more faces around each vertex than usual)
+		const uint32 listStart = m_vertexTriangles.size();
+		CollapseVertex& removed = m_vertices[remove];
+		for (uint32 i = removed.firstTriangle; i < removed.firstTriangle + removed.triangleCount; ++i)
+		{
+			const uint32 t = m_vertexTriangles[i];
+			CollapseTriangle& triangle = m_triangles[t];
+			if (triangle.IsDeleted())
+				continue;
+
+			if (triangle.Contains(keep))
+			{
+				// Leave the face degenerate, so it gets dropped when the mesh is compacted
+				triangle.corners.fill(keep);
+				m_triangleCount--;
+				continue;
+			}
+
+			for (uint32& corner : triangle.corners)
+				if (corner == remove)
+					corner = keep;
+			m_vertexTriangles.push_back(t);
+		}
+		removed.triangleCount = 0;
+
+		// Drop any faces which have been deleted
+		CollapseVertex& kept = m_vertices[keep];
+		for (uint32 i = kept.firstTriangle; i < kept.firstTriangle + kept.triangleCount; ++i)
+		{
+			const uint32 t = m_vertexTriangles[i];
+			if (!m_triangles[t].IsDeleted())
+				m_vertexTriangles.push_back(t);
+		}
+
+		kept.firstTriangle = listStart;
+		kept.triangleCount = m_vertexTriangles.size() - listStart;
+
+		// Every edge around the kept vertex has a new cost
+		UpdateEdges(keep, m_touched, m_touchedCosts);
+	}
+
+	void QuadricSimplifier::UpdateEdges(const uint32& vertex, std::vector<uint32>& outNeighbours, std::vector<float>& outCosts)
+	{
+		outNeighbours.clear();
+		outCosts.clear();
+
+		for (const uint32& t : GetTriangles(vertex))
+		{
+			CollapseTriangle& triangle = m_triangles[t];
+			if (triangle.IsDeleted())
+				continue;
+
+			// The edges leaving and arriving at this vertex (Moving a face onto a new vertex can change which face stores the cost)
+			const uint32 corner = (triangle.corners[0] == vertex ? 0 : triangle.corners[1] == vertex ? 1 : 2);
+			const uint32 edges[2] = { corner, (corner + 2) % 3 };
+			const uint32 others[2] = { triangle.corners[(corner + 1) % 3], triangle.corners[(corner + 2) % 3] };
+
+			for (uint32 i = 0; i < 2; ++i)
+			{
+				float& edgeCost = triangle.edgeCosts[edges[i]];
+				edgeCost = FLT_MAX;
+				if (!triangle.StoresCost(edges[i]))
+					continue;
+
+				double cost;
+				vec3 target;
+				if (Evaluate(vertex, others[i], cost, target))
+					edgeCost = (float)cost;
+
+				outNeighbours.push_back(others[i]);
+				outCosts.push_back(edgeCost);
+			}
+		}
+	}
+
+	void QuadricSimplifier::RecalculateBest(const uint32& vertex)
+	{
+		CollapseVertex& state = m_vertices[vertex];
+		state.bestOther = InvalidIndex;
+		state.bestCost = FLT_MAX;
+
+		for (const uint32& t : GetTriangles(vertex))
+		{
+			const CollapseTriangle& triangle = m_triangles[t];
+			if (triangle.IsDeleted())
+				continue;
+
+			// The edges leaving and arriving at this vertex
+			const uint32 corner = (triangle.corners[0] == vertex ? 0 : triangle.corners[1] == vertex ? 1 : 2);
+			const uint32 next = (corner + 1) % 3;
+			const uint32 previous = (corner + 2) % 3;
+
+			if (triangle.edgeCosts[corner] < state.bestCost)
+			{
+				state.bestCost = triangle.edgeCosts[corner];
+				state.bestOther = triangle.corners[next];
+			}
+			if (triangle.edgeCosts[previous] < state.bestCost)
+			{
+				state.bestCost = triangle.edgeCosts[previous];
+				state.bestOther = triangle.corners[previous];
+			}
+		}
+	}
+
+	void QuadricSimplifier::Enqueue(const uint32& vertex)
+	{
+		const CollapseVertex& state = m_vertices[vertex];
+		if (state.bestOther == InvalidIndex || state.bestCost > m_settings.maxError)
+			return;
+
+		// Anything cheaper than what's being drained just goes in with it
+		m_queue[glm::max(GetCostBucket(state.bestCost), m_currentBucket)].push_back(vertex);
+	}
+
+	void QuadricSimplifier::Run(SimplifyStats& stats)
+	{
+		int64 startTime = GetTimeMicroseconds();
+		Setup();
+		int64 endTime = GetTimeMicroseconds();
+		stats.setupTime = endTime - startTime;
+		startTime = endTime;
+
+		// Cost every edge, then find every vertex's first collapse
+		// (Each edge and vertex only writes to its own entries, so both of these can be split up)
+		const uint32 triangleCount = m_triangles.size();
+		const uint32 triangleBlockCount = (triangleCount + RecalculateBlockSize - 1) / RecalculateBlockSize;
+		ThreadPool::GetShared().ParallelFor(triangleBlockCount, [this, triangleCount](uint32 block)
+		{
+			const uint32 end = glm::min(triangleCount, (block + 1) * RecalculateBlockSize);
+			for (uint32 t = block * RecalculateBlockSize; t < end; ++t)
+			{
+				CollapseTriangle& triangle = m_triangles[t];
+				if (triangle.IsDeleted())
+					continue;
+
+				double cost;
+				vec3 target;
+				for (uint32 i = 0; i < 3; ++i)
+					if (triangle.StoresCost(i) && Evaluate(triangle.corners[i], triangle.corners[(i + 1) % 3], cost, target))
+						triangle.edgeCosts[i] = (float)cost;
+			}
+		});
+
+		const uint32 vertexCount = m_vertices.size();
+		const uint32 blockCount = (vertexCount + RecalculateBlockSize - 1) / RecalculateBlockSize;
+		ThreadPool::GetShared().ParallelFor(blockCount, [this, vertexCount](uint32 block)
+		{
+			const uint32 end = glm::min(vertexCount, (block + 1) * RecalculateBlockSize);
+			for (uint32 v = block * RecalculateBlockSize; v < end; ++v)
+				RecalculateBest(v);
+		});
+
+		for (uint32 v = 0; v < vertexCount; ++v)
+			Enqueue(v);
+
+		endTime = GetTimeMicroseconds();
+		stats.costTime = endTime - startTime;
+		startTime = endTime;
+
+
+		std::vector<uint32> sweep;
+		while (m_triangleCount > m_settings.targetTriangles && m_currentBucket < CostBucketCount)
+		{
+			// Anything requeued into this bucket while it was being swept is picked up by the next sweep
+			sweep.clear();
+			sweep.swap(m_queue[m_currentBucket]);
+			if (sweep.size() == 0)
+			{
+				m_currentBucket++;
+				continue;
+			}
+
+			std::sort(sweep.begin(), sweep.end());
+			sweep.erase(std::unique(sweep.begin(), sweep.end()), sweep.end());
+			stats.sweepCount++;
+
+			for (uint32 i = 0; i < sweep.size() && m_triangleCount > m_settings.targetTriangles; ++i)
+			{
+				// The vertex has changed since it was queued (So is queued again further on)
+				const uint32 vertex = sweep[i];
+				const uint32 other = m_vertices[vertex].bestOther;
+				if (other == InvalidIndex || GetCostBucket(m_vertices[vertex].bestCost) > m_currentBucket)
+				{
+					stats.staleCount++;
+					continue;
+				}
+
+				double cost;
+				vec3 target;
+				Evaluate(vertex, other, cost, target);
+
+				// Always keep the pinned vertex, if there is one
+				uint32 keep = other;
+				uint32 remove = vertex;
+				if (m_vertices[remove].bIsPinned)
+					std::swap(keep, remove);
+
+				// Leave this vertex alone until something around it changes
+				if (WouldFlip(keep, remove, target) || WouldFlip(remove, keep, target))
+				{
+					m_vertices[vertex].bestOther = InvalidIndex;
+					stats.flipCount++;
+					continue;
+				}
+
+				Collapse(keep, remove, target);
+				stats.collapseCount++;
+
+				// Every edge to the kept vertex has changed, so neighbours which wanted either end need to look elsewhere
+				// (Other neighbours' edges are untouched, so only the edge to here could have become their best)
+				RecalculateBest(keep);
+				Enqueue(keep);
+
+				for (uint32 n = 0; n < m_touched.size(); ++n)
+				{
+					CollapseVertex& neighbour = m_vertices[m_touched[n]];
+					if (neighbour.bestOther == keep || neighbour.bestOther == remove || neighbour.bestOther == InvalidIndex)
+						RecalculateBest(m_touched[n]);
+					else if (m_touchedCosts[n] < neighbour.bestCost)
+					{
+						neighbour.bestCost = m_touchedCosts[n];
+						neighbour.bestOther = keep;
+					}
+					else
+						continue;
+
+					Enqueue(m_touched[n]);
+				}
+			}
+		}
+
+
+		stats.collapseTime = GetTimeMicroseconds() - startTime;
+
+
+		// Hand back the moved vertices and collapsed faces (Still in Morton order)
+		for (uint32 v = 0; v < vertexCount; ++v)
+			m_positions[v] = m_vertices[v].position;
+		for (uint32 t = 0; t < m_triangles.size(); ++t)
+			std::copy(m_triangles[t].corners.begin(), m_triangles[t].corners.end(), m_indices.begin() + t * 3);
+	}
+}
+
+
+void MeshSimplifier::Simplify(std::vector<vec3>& vertices, std::vector<vec3>& normals, std::vector<uint32>& indices, const SimplifySettings& settings, SimplifyStats* outStats)
+{
+	if (indices.size() / 3 <= settings.targetTriangles)
+		return;
+
+	SimplifyStats stats;
+	const int64 startTime = GetTimeMicroseconds();
+	QuadricSimplifier simplifier(vertices, indices, settings);
+	simplifier.Run(stats);
+
+
+	// Compact the mesh down to the faces which are left
+	std::vector<uint32> remap(vertices.size(), ~0U);
+	std::vector<vec3> oldVertices;
+	std::vector<uint32> oldIndices;
+	oldVertices.swap(vertices);
+	oldIndices.swap(indices);
+
+	normals.clear();
+	indices.reserve(oldIndices.size());
+
+	for (uint32 i = 0; i < oldIndices.size(); i += 3)
+	{
+		const uint32* tri = &oldIndices[i];
+		if (tri[0] == tri[1] || tri[0] == tri[2] || tri[1] == tri[2])
+			continue;
+
+		// Ignore triangle which is malformed
+		const vec3 normal = glm::cross(oldVertices[tri[1]] - oldVertices[tri[0]], oldVertices[tri[2]] - oldVertices[tri[0]]);
+		if (glm::dot(normal, normal) == 0.0f)
+			continue;
+
+		for (uint32 j = 0; j < 3; ++j)
+		{
+			uint32& index = remap[tri[j]];
+			if (index == ~0U)
+			{
+				index = vertices.size();
+				vertices.push_back(oldVertices[tri[j]]);
+				normals.push_back(vec3(0, 0, 0));
+			}
+
+			normals[index] += normal; // Smooths normals
+			indices.push_back(index);
+		}
+	}
+
+	// Anything the simplifier didn't time was spent handing the mesh back
+	stats.compactTime = GetTimeMicroseconds() - startTime - stats.setupTime - stats.costTime - stats.collapseTime;
+	if (outStats)
+		*outStats = stats;
+}
+
+
+namespace
+{
+	/**
+	* A group of vertices which are being snapped together
+	*/
+	struct VertexCluster
+	{
+		ivec3 cell;
+		Quadric quadric;
+		vec3 positionSum;
+		vec3 normal;
+		uint32 vertexCount = 0;
+	};
+
+	/**
+	* Pack a cell coordinate into a single key (21 bits per axis)
+	*/
+	inline uint64 GetCellKey(const ivec3& cell)
+	{
+		return ((uint64)(cell.x & 0x1FFFFF)) | ((uint64)(cell.y & 0x1FFFFF) << 21) | ((uint64)(cell.z & 0x1FFFFF) << 42);
+	}
+}
+
+
+void MeshSimplifier::BuildClusteredLods(const std::vector<vec3>& vertices, const std::vector<uint32>& indices, const float& baseCellSize, std::vector<LodMeshData>& outLods)
+{
+	const uint32 levelCount = outLods.size();
+	if (levelCount == 0)
+		return;
+
+
+	// Snap every vertex onto the first grid, then every cluster onto the grid above it
+	// (Each cell is exactly 8 cells of the level below, so clusters nest and only ever need looking up once)
+	std::vector<std::vector<VertexCluster>> clusters(levelCount);
+	std::vector<std::vector<uint32>> parents(levelCount);		// parents[0] maps vertices onto clusters[0], parents[n] maps clusters[n - 1] onto clusters[n]
+	std::unordered_map<uint64, uint32> lookup;
+
+	for (uint32 level = 0; level < levelCount; ++level)
+	{
+		const uint32 childCount = (level == 0 ? vertices.size() : clusters[level - 1].size());
+		std::vector<VertexCluster>& levelClusters = clusters[level];
+		std::vector<uint32>& levelParents = parents[level];
+
+		levelParents.resize(childCount);
+		lookup.clear();
+		lookup.reserve(childCount / 2);
+
+		for (uint32 i = 0; i < childCount; ++i)
+		{
+			ivec3 cell;
+			if (level == 0)
+				cell = ivec3(glm::floor(vertices[i] / baseCellSize));
+			else
+			{
+				const ivec3& childCell = clusters[level - 1][i].cell;
+				cell = ivec3(childCell.x >> 1, childCell.y >> 1, childCell.z >> 1);
+			}
+
+			auto it = lookup.find(GetCellKey(cell));
+			if (it != lookup.end())
+			{
+				levelParents[i] = it->second;
+				continue;
+			}
+
+			levelParents[i] = levelClusters.size();
+			lookup[GetCellKey(cell)] = levelClusters.size();
+			levelClusters.emplace_back();
+			levelClusters.back().cell = cell;
+		}
+	}
+
+
+	// Single pass over the faces: Accumulate each face's plane onto its corners and emit it for every LOD it survives in
+	for (LodMeshData& lod : outLods)
+	{
+		lod.indices.clear();
+		lod.indices.reserve(indices.size() / 4);
+	}
+
+	for (uint32 i = 0; i + 2 < indices.size(); i += 3)
+	{
+		uint32 corners[3] = { indices[i], indices[i + 1], indices[i + 2] };
+
+		const vec3& A = vertices[corners[0]];
+		const vec3 normal = glm::cross(vertices[corners[1]] - A, vertices[corners[2]] - A);
+		const float length = glm::length(normal);
+		if (length == 0.0f)
+			continue;
+
+		// Weighted by area, so slivers don't dominate
+		const Quadric plane = Quadric::FromPlane(normal / length, A, length * 0.5f);
+
+		for (uint32 level = 0; level < levelCount; ++level)
+		{
+			for (uint32 c = 0; c < 3; ++c)
+				corners[c] = parents[level][corners[c]];
+
+			if (level == 0)
+				for (uint32 c = 0; c < 3; ++c)
+					clusters[0][corners[c]].quadric += plane;
+
+			// Face has collapsed into a line or point
+			if (corners[0] == corners[1] || corners[0] == corners[2] || corners[1] == corners[2])
+				continue;
+
+			for (uint32 c = 0; c < 3; ++c)
+			{
+				clusters[level][corners[c]].normal += normal; // Smooths normals
+				outLods[level].indices.push_back(corners[c]);
+			}
+		}
+	}
+
+	for (uint32 v = 0; v < vertices.size(); ++v)
+	{
+		VertexCluster& cluster = clusters[0][parents[0][v]];
+		cluster.positionSum += vertices[v];
+		cluster.vertexCount++;
+	}
+
+	// Each cluster's quadric is just the sum of its children's
+	for (uint32 level = 1; level < levelCount; ++level)
+		for (uint32 i = 0; i < clusters[level - 1].size(); ++i)
+		{
+			const VertexCluster& child = clusters[level - 1][i];
+			VertexCluster& cluster = clusters[level][parents[level][i]];
+			cluster.quadric += child.quadric;
+			cluster.positionSum += child.positionSum;
+			cluster.vertexCount += child.vertexCount;
+		}
+
+
+	// Place each cluster which is still used at its best point
+	std::vector<uint32> remap;
+	for (uint32 level = 0; level < levelCount; ++level)
+	{
+		LodMeshData& lod = outLods[level];
+		const float cellSize = baseCellSize * (float)(1 << level);
+
+		lod.vertices.clear();
+		lod.normals.clear();
+		remap.assign(clusters[level].size(), ~0U);
+
+		for (uint32& index : lod.indices)
+		{
+			uint32& newIndex = remap[index];
+			if (newIndex == ~0U)
+			{
+				const VertexCluster& cluster = clusters[level][index];
+				const vec3 cellMin = vec3(cluster.cell) * cellSize;
+				const vec3 cellMax = cellMin + vec3(cellSize, cellSize, cellSize);
+
+				// Only trust the optimal point if it's inside of the cell, otherwise just use the average
+				vec3 point;
+				if (!cluster.quadric.Optimise(point) ||
+					point.x < cellMin.x || point.y < cellMin.y || point.z < cellMin.z ||
+					point.x > cellMax.x || point.y > cellMax.y || point.z > cellMax.z)
+					point = cluster.positionSum / (float)cluster.vertexCount;
+
+				newIndex = lod.vertices.size();
+				lod.vertices.push_back(point);
+				lod.normals.push_back(cluster.normal);
+			}
+
+			index = newIndex;
+		}
+	}
+}
@@ -0,0 +1,141 @@
+#pragma once
+#include "Common.h"
+#include <vector>
+#include <cfloat>
+
+
+/**
+* Symmetric 4x4 matrix which measures the sum of squared distances from a point to a set of planes (Garland-Heckbert)
+*/
+struct Quadric
+{
+	double xx, xy, xz, xw;
+	double yy, yz, yw;
+	double zz, zw;
+	double ww;
+
+	Quadric() : xx(0), xy(0), xz(0), xw(0), yy(0), yz(0), yw(0), zz(0), zw(0), ww(0) {}
+
+	/**
+	* Create the quadric for a single plane
+	* @param normal				The (normalized) normal of the plane
+	* @param point				Any point on the plane
+	* @param weight				How much this plane should count towards the error
+	*/
+	static inline Quadric FromPlane(const vec3& normal, const vec3& point, const float& weight)
+	{
+		const double a = normal.x;
+		const double b = normal.y;
+		const double c = normal.z;
+		const double d = -glm::dot(normal, point);
+
+		Quadric q;
+		q.xx = weight * a * a; q.xy = weight * a * b; q.xz = weight * a * c; q.xw = weight * a * d;
+		q.yy = weight * b * b; q.yz = weight * b * c; q.yw = weight * b * d;
+		q.zz = weight * c * c; q.zw = weight * c * d;
+		q.ww = weight * d * d;
+		return q;
+	}
+
+	inline Quadric& operator+=(const Quadric& other)
+	{
+		xx += other.xx; xy += other.xy; xz += other.xz; xw += other.xw;
+		yy += other.yy; yz += other.yz; yw += other.yw;
+		zz += other.zz; zw += other.zw;
+		ww += other.ww;
+		return *this;
+	}
+
+	inline Quadric operator+(const Quadric& other) const
+	{
+		Quadric q = *this;
+		q += other;
+		return q;
+	}
+
+	/**
+	* The error for this point
+	* @param p					The point to measure
+	*/
+	inline double Evaluate(const vec3& p) const
+	{
+		const double x = p.x;
+		const double y = p.y;
+		const double z = p.z;
+		return x * (xx * x + 2.0 * (xy * y + xz * z + xw)) + y * (yy * y + 2.0 * (yz * z + yw)) + z * (zz * z + 2.0 * zw) + ww;
+	}
+
+	/**
+	* Find the point with the smallest error
+	* @param outPoint			Where to store the point
+	* @returns False if there isn't a single best point (e.g. all of the planes are parallel)
+	*/
+	bool Optimise(vec3& outPoint) const;
+};
+
+
+/**
+* Settings for simplifying a mesh
+*/
+struct SimplifySettings
+{
+	uint32 targetTriangles = 0;		// Stop once the mesh is down to this many triangles
+	float maxError = FLT_MAX;		// Stop once the cheapest collapse would cost more than this (Roughly a squared distance)
+	float chunkSize = 0.0f;			// Vertices lying on a multiple of this on any axis are pinned, so chunks still line up (0 to disable)
+};
+
+/**
+* Where the time went while simplifying a mesh (Times are in microseconds)
+*/
+struct SimplifyStats
+{
+	int64 setupTime = 0;			// Sorting the mesh and building the quadrics, face lists and boundaries
+	int64 costTime = 0;				// Costing every edge and queuing each vertex's first collapse
+	int64 collapseTime = 0;			// Draining the queue
+	int64 compactTime = 0;			// Writing the mesh back without the removed faces and vertices, and rebuilding the normals
+	uint32 sweepCount = 0;			// How many times a bucket of the queue was swept
+	uint32 collapseCount = 0;
+	uint32 flipCount = 0;			// Collapses turned down because they would flip a face
+	uint32 staleCount = 0;			// Queue entries skipped because the vertex had changed since
+};
+
+
+/**
+* The output of a single simplified LOD
+*/
+struct LodMeshData
+{
+	std::vector<vec3> vertices;
+	std::vector<vec3> normals;
+	std::vector<uint32> indices;
+};
+
+
+/**
+* Mesh decimation using edge collapses, ordered by quadric error (Garland-Heckbert)
+* or by clustering vertices onto a grid (Lindstrom)
+*/
+namespace MeshSimplifier
+{
+	/**
+	* Simplify this indexed triangle mesh in place
+	* Vertices are re-indexed and normals are rebuilt from the remaining faces
+	* @param vertices			The positions of each vertex
+	* @param normals			The normals of each vertex
+	* @param indices			Every 3 indices make up a triangle
+	* @param settings			When to stop simplifying and what to preserve
+	* @param outStats			Where to store how long each stage took (Optional)
+	*/
+	void Simplify(std::vector<vec3>& vertices, std::vector<vec3>& normals, std::vector<uint32>& indices, const SimplifySettings& settings, SimplifyStats* outStats = nullptr);
+
+	/**
+	* Build a chain of LODs by snapping vertices together onto coarser and coarser grids
+	* Every vertex in a cell is replaced with the point in that cell which has the smallest quadric error, and any collapsed faces are dropped
+	* Runs in linear time, so is a lot quicker than Simplify, but the result follows the grid rather than the shape of the surface
+	* @param vertices			The positions of each vertex (In the same units as the grid)
+	* @param indices			Every 3 indices make up a triangle
+	* @param baseCellSize		How wide the cells are for the first LOD (Each LOD after that doubles it)
+	* @param outLods			Where to store each LOD (Its size decides how many get built)
+	*/
+	void BuildClusteredLods(const std::vector<vec3>& vertices, const std::vector<uint32>& indices, const float& baseCellSize, std::vector<LodMeshData>& outLods);
+}
@@ -0,0 +1,168 @@
+#pragma once
+#include "Common.h"
+
+#include <vector>
+#include <new>
+#include <utility>
+#include <type_traits>
+
+
+/**
+* Slab allocator for octree nodes, which hands out stable 32-bit handles rather than pointers
+* Nodes are stored in fixed size slabs, which are never moved or freed until the pool is cleared,
+* so both handles and pointers to nodes stay valid for as long as the node exists
+* Freed slots are re-used before any new slabs are allocated
+*/
+template<typename T>
+class NodePool
+{
+public:
+	/// Each slab holds 2^SlabShift nodes
+	static const uint32 SlabShift = 10;
+	static const uint32 SlabSize = 1 << SlabShift;
+	static const uint32 SlabMask = SlabSize - 1;
+
+	/// Handle which will never be handed out
+	static const uint32 InvalidHandle = ~0U;
+
+private:
+	typedef typename std::aligned_storage<sizeof(T), alignof(T)>::type Slot;
+
+	std::vector<Slot*> m_slabs;
+	std::vector<uint8> m_alive; // Is there currently a node in this slot
+	std::vector<uint32> m_freeHandles;
+	uint32 m_end = 0; // Every slot at or after this has never been used
+	uint32 m_count = 0;
+
+public:
+	NodePool() {}
+	NodePool(const NodePool&) = delete;
+	NodePool& operator=(const NodePool&) = delete;
+	~NodePool() { Clear(); }
+
+	/**
+	* Construct a new node in the pool
+	* @param args				What to pass to the node's constructor
+	* @returns The handle for the new node
+	*/
+	template<typename... Args>
+	uint32 Create(Args&&... args)
+	{
+		uint32 handle;
+		if (!m_freeHandles.empty())
+		{
+			handle = m_freeHandles.back();
+			m_freeHandles.pop_back();
+		}
+		else
+		{
+			handle = m_end++;
+			if ((handle >> SlabShift) >= m_slabs.size())
+			{
+				m_slabs.push_back(new Slot[SlabSize]);
+				m_alive.resize(m_slabs.size() * SlabSize, 0);
+			}
+		}
+
+		// Mark first, as the constructor is allowed to look the node up
+		m_alive[handle] = 1;
+		++m_count;
+		new (GetSlot(handle)) T(std::forward<Args>(args)...);
+		return handle;
+	}
+
+	/**
+	* Destroy a node, so its slot can be re-used
+	* @param handle				The handle of the node (Expected to be alive)
+	*/
+	void Destroy(const uint32& handle)
+	{
+		Get(handle)->~T();
+		m_alive[handle] = 0;
+		m_freeHandles.push_back(handle);
+		--m_count;
+	}
+
+	/**
+	* Destroy every node and release all of the slabs
+	*/
+	void Clear()
+	{
+		for (uint32 handle = 0; handle < m_end; ++handle)
+			if (m_alive[handle])
+				Get(handle)->~T();
+
+		for (Slot* slab : m_slabs)
+			delete[] slab;
+
+		m_slabs.clear();
+		m_alive.clear();
+		m_freeHandles.clear();
+		m_end = 0;
+		m_count = 0;
+	}
+
+	/**
+	* Make sure there is enough space for this many nodes, without allocating any more slabs
+	* @param count				How many nodes are expected to exist at once
+	*/
+	void Reserve(const uint32& count)
+	{
+		const uint32 slabCount = (count + SlabMask) >> SlabShift;
+		m_slabs.reserve(slabCount);
+		while (m_slabs.size() < slabCount)
+			m_slabs.push_back(new Slot[SlabSize]);
+		m_alive.resize(m_slabs.size() * SlabSize, 0);
+	}
+
+	/**
+	* Call func for every node in the pool, in slot order (So slabs are walked through memory in order)
+	* @param func				Called with each node
+	*/
+	template<typename Func>
+	void ForEach(Func func) const
+	{
+		ForEachInRange(0, m_end, func);
+	}
+
+	/**
+	* Call func for every node whose handle is in [first, end), in slot order
+	* @param first				The first handle to check
+	* @param end				The handle to stop at (Clamped to the slots in use)
+	* @param func				Called with each node
+	*/
+	template<typename Func>
+	void ForEachInRange(const uint32& first, uint32 end, Func func) const
+	{
+		end = glm::min(end, m_end);
+		for (uint32 handle = first; handle < end; ++handle)
+			if (m_alive[handle])
+				func(Get(handle));
+	}
+
+	///
+	/// Getters & Setters
+	///
+public:
+	inline T* Get(const uint32& handle) const { return reinterpret_cast<T*>(GetSlot(handle)); }
+	inline bool IsAlive(const uint32& handle) const { return handle < m_end && m_alive[handle] != 0; }
+
+	inline uint32 GetCount() const { return m_count; }
+
+	/** Every handle which is in use is below this */
+	inline uint32 GetSlotCount() const { return m_end; }
+
+	/** How many bytes the pool currently has allocated */
+	inline uint64 GetMemoryUsage() const
+	{
+		return (uint64)m_slabs.size() * SlabSize * sizeof(Slot) + m_slabs.capacity() * sizeof(Slot*) + m_alive.capacity() + m_freeHandles.capacity() * sizeof(uint32);
+	}
+
+private:
+	inline Slot* GetSlot(const uint32& handle) const { return m_slabs[handle >> SlabShift] + (handle & SlabMask); }
+};
+
+template<typename T> const uint32 NodePool<T>::SlabShift;
+template<typename T> const uint32 NodePool<T>::SlabSize;
+template<typename T> const uint32 NodePool<T>::SlabMask;
+template<typename T> const uint32 NodePool<T>::InvalidHandle;
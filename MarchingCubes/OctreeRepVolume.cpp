@@ -46,7 +46,7 @@ void OctRepNode::Push(const uint32& x, const uint32& y, const uint32& z, const f
 		{
 			m_values[GetIndex(x, y, z)] = value;
 			RecalculateStats();
-			outPacket.updatedNodes.emplace_back(this);
+			outPacket.OnModifyNode(this);
 		}
 		return;
 	}
@@ -58,7 +58,7 @@ void OctRepNode::Push(const uint32& x, const uint32& y, const uint32& z, const f
 		) 
 	{
 		m_values[GetIndex(x == 0 ? 0 : 1, y == 0 ? 0 : 1, z == 0 ? 0 : 1)] = value;
-		outPacket.updatedNodes.emplace_back(this);
+		outPacket.OnModifyNode(this);
 	}
 
 
@@ -88,7 +88,7 @@ void OctRepNode::Push(const uint32& x, const uint32& y, const uint32& z, const f
 			if (child == nullptr && value != DEFAULT_VALUE)
 			{
 				child = new OctRepNode(this, m_offset + uvec3(ox, oy, oz));
-				outPacket.newNodes.emplace_back(child);
+				outPacket.OnNewNode(child);
 			}
 
 			// Update value in child
@@ -109,7 +109,7 @@ void OctRepNode::Push(const uint32& x, const uint32& y, const uint32& z, const f
 	{
 		if (child != nullptr && child->IsDefaultValues())
 		{
-			outPacket.deletedNodes.emplace_back(child);
+			outPacket.OnDeleteNode(child);
 			delete child;
 			child = nullptr;
 		}
@@ -125,7 +125,7 @@ void OctRepNode::Push(const uint32& x, const uint32& y, const uint32& z, const f
 
 		// Has this node been updated
 		if (oldAverage != m_average || oldDeviation != m_stdDeviation)
-			outPacket.updatedNodes.emplace_back(this);
+			outPacket.OnModifyNode(this);
 	}
 }
 
@@ -147,7 +147,7 @@ void OctRepNode::RecalculateStats()
 uint32 OctRepNode::GetChildResolution() const 
 {
 	// Where res(i) = 1 + 2^(i+1)
-	return m_resolution > 3 ? (m_resolution - 1) / 2 + 1 : 2;
+	return GetChildResolution(m_resolution);
 }
 
 bool OctRepNode::IsDefaultValues() const
@@ -222,37 +222,16 @@ void OctRepNode::GeneratePartialMesh(const float& isoLevel, RetrieveEdgeCallback
 
 
 	// Smooth edges based on density
-#define VERT_LERP(x0, y0, z0, x1, y1, z1) edgeCallback(isoLevel, m_offset + uvec3(x0, y0, z0) * stride, m_offset + uvec3(x1, y1, z1) * stride, m_resolution)//MC::VertexLerp(isoLevel, worldCoord + vec3(x0, y0, z0)*resf, worldCoord + vec3(x1, y1, z1)*resf, v ## x0 ## y0 ## z0, v ## x1 ## y1 ## z1);
 	vec3 edges[12];
 
-	if (MC::CaseRequiredEdges[caseIndex] & 1)
-		edges[0] = VERT_LERP(0, 0, 0, 1, 0, 0);
-	if (MC::CaseRequiredEdges[caseIndex] & 2)
-		edges[1] = VERT_LERP(1, 0, 0, 1, 0, 1);
-	if (MC::CaseRequiredEdges[caseIndex] & 4)
-		edges[2] = VERT_LERP(0, 0, 1, 1, 0, 1);
-	if (MC::CaseRequiredEdges[caseIndex] & 8)
-		edges[3] = VERT_LERP(0, 0, 0, 0, 0, 1);
-	if (MC::CaseRequiredEdges[caseIndex] & 16)
-		edges[4] = VERT_LERP(0, 1, 0, 1, 1, 0);
-	if (MC::CaseRequiredEdges[caseIndex] & 32)
-		edges[5] = VERT_LERP(1, 1, 0, 1, 1, 1);
-	if (MC::CaseRequiredEdges[caseIndex] & 64)
-		edges[6] = VERT_LERP(0, 1, 1, 1, 1, 1);
-	if (MC::CaseRequiredEdges[caseIndex] & 128)
-		edges[7] = VERT_LERP(0, 1, 0, 0, 1, 1);
-	if (MC::CaseRequiredEdges[caseIndex] & 256)
-		edges[8] = VERT_LERP(0, 0, 0, 0, 1, 0);
-	if (MC::CaseRequiredEdges[caseIndex] & 512)
-		edges[9] = VERT_LERP(1, 0, 0, 1, 1, 0);
-	if (MC::CaseRequiredEdges[caseIndex] & 1024)
-		edges[10] = VERT_LERP(1, 0, 1, 1, 1, 1);
-	if (MC::CaseRequiredEdges[caseIndex] & 2048)
-		edges[11] = VERT_LERP(0, 0, 1, 0, 1, 1);
+	const uint32 requiredEdges = MC::CaseRequiredEdges[caseIndex];
+	for (uint32 e = 0; e < 12; ++e)
+		if (requiredEdges & (1 << e))
+			edges[e] = edgeCallback(isoLevel, m_offset + MC::CornerOffset(MC::EdgeCorners[e][0]) * stride, m_offset + MC::CornerOffset(MC::EdgeCorners[e][1]) * stride, m_resolution);
 
 
 	// Add triangles for this case
-	int8* caseEdges = MC::Cases[caseIndex];
+	const int8* caseEdges = MC::Cases[caseIndex];
 	while (*caseEdges != -1)
 	{
 		int8 edge0 = *(caseEdges++);
@@ -541,6 +520,22 @@ bool OctRepNode::HasMultipleEdgeIntersections(const float& isoLevel, const uint3
 	return false;
 }
 
+///
+/// Notify packet
+///
+void OctRepNotifyPacket::OnDeleteNode(const OctRepNode* node)
+{
+	auto it = changedNodes.find(const_cast<OctRepNode*>(node));
+	const bool wasNew = it != changedNodes.end() && it->second;
+	if (it != changedNodes.end())
+		changedNodes.erase(it);
+
+	// Nothing else has seen a node which was created since the last flush, so it can just be forgotten
+	if (!wasNew)
+		deletedNodes.push_back(DeletedNode{ node, node->GetOffset(), node->GetDepth() });
+}
+
+
 ///
 /// Octree layer
 ///
@@ -553,17 +548,9 @@ void OctreeRepLayer::OnModifyNode(OctRepNode* node)
 {
 }
 
-void OctreeRepLayer::OnDeleteNode(const OctRepNode* node) 
+void OctreeRepLayer::OnDeleteNode(const uvec3& offset) 
 {
-	// TODO - Better impl
-	for (auto it = m_nodes.begin(); it != m_nodes.end(); it++)
-	{
-		if (it->second == node)
-		{
-			m_nodes.erase(it);
-			return;
-		}
-	}
+	m_nodes.erase(offset);
 }
 
 bool OctreeRepLayer::AttemptGet(const uint32& x, const uint32& y, const uint32& z, OctRepNode*& outNode) const 
@@ -1368,8 +1355,11 @@ void OctreeRepVolume::Begin()
 	m_wireMaterial = new InteractionMaterial(vec4(0.0f, 1.0f, 0.0f, 1.0f));
 	m_debugMaterial = new InteractionMaterial(vec4(0.0f, 0.0f, 0.0f, 1.0f));
 
-	m_mesh = new Mesh;
-	m_mesh->MarkDynamic();
+	if (m_mesh == nullptr)
+	{
+		m_mesh = new Mesh;
+		m_mesh->MarkDynamic();
+	}
 
 	m_debugMesh = new Mesh;
 	m_debugMesh->MarkDynamic();
@@ -1429,10 +1419,8 @@ void OctreeRepVolume::Draw(const Window * window, const float & deltaTime)
 	// Completely rebuild mesh
 	if (keyboard->IsKeyPressed(Keyboard::Key::KV_N))
 	{
-		for (auto& pair : m_nodeLevel)
-			pair.second.isStale = true;
-		for (auto& pair : m_nodedebugLevel)
-			pair.second.isStale = true;
+		for (auto& pair : m_nodeLevel.nodes)
+			MarkStale(pair.first);
 
 		BuildMesh();
 		LOG("Done");
@@ -1459,12 +1447,17 @@ void OctreeRepVolume::Init(const uvec3 & resolution, const vec3 & scale)
 
 	m_resolution = resolution;
 	m_scale = scale;
-	m_data.clear();
-	m_data.resize(resolution.x * resolution.y * resolution.z);
+	m_data.Init(resolution, m_layout, EncodeVoxel(DEFAULT_VALUE));
 
 	m_octree = new OctRepNode(res);
 	m_layers.clear();
 
+	if (m_mesh == nullptr)
+	{
+		m_mesh = new Mesh;
+		m_mesh->MarkDynamic();
+	}
+
 	// Setup layers
 	//m_layers.emplace_back(this, 1U + (uint32)pow(2, 3));
 	//m_layers.emplace_back(this, 1U + (uint32)pow(2, 2));
@@ -1473,72 +1466,31 @@ void OctreeRepVolume::Init(const uvec3 & resolution, const vec3 & scale)
 	if(m_layers.size() > 1)
 		for (uint32 i = 0; i < m_layers.size() - 1; ++i)
 			m_layers[i].nextLayer = &m_layers[i + 1];
-}
-
-void OctreeRepVolume::Set(uint32 x, uint32 y, uint32 z, float value)
-{
-	m_data[GetIndex(x, y, z)] = value;
-
-	OctRepNotifyPacket changes;
-	m_octree->Push(x, y, z, value, changes);
-
 
-	// Go through layers to see if any are interested
+	// Work out which layer each depth of the tree belongs to, so nodes can go straight to their layer
+	m_depthLayers.clear();
+	for (uint32 depthRes = res; ; depthRes = OctRepNode::GetChildResolution(depthRes))
 	{
-		// New
-		for (OctRepNode* node : changes.newNodes)
-			for (OctreeRepLayer& layer : m_layers)
-				if (node->GetResolution() == layer.GetResolution())
-					layer.OnNewNode(node);
-
-		// Updated
-		for (OctRepNode* node : changes.updatedNodes)
-			for (OctreeRepLayer& layer : m_layers)
-				if (node->GetResolution() == layer.GetResolution())
-					layer.OnModifyNode(node);
-
-		// Deleted
-		for (OctRepNode* node : changes.deletedNodes)
-			for (OctreeRepLayer& layer : m_layers)
-				if (node->GetResolution() == layer.GetResolution())
-					layer.OnDeleteNode(node);
+		int32 layerIndex = -1;
+		for (uint32 i = 0; i < m_layers.size(); ++i)
+			if (m_layers[i].GetResolution() == depthRes)
+				layerIndex = i;
+		m_depthLayers.push_back(layerIndex);
+
+		if (depthRes <= 2)
+			break;
 	}
+}
 
+void OctreeRepVolume::Set(uint32 x, uint32 y, uint32 z, float value)
+{
+	// Nodes should see the value which is actually stored
+	const VoxelSample sample = EncodeVoxel(value);
+	value = DecodeVoxel(sample);
+	m_data.Set(x, y, z, sample);
 
-	// TEMP MESH DATA STUFF
-	// Remove deleted nodes
-	for (OctRepNode* node : changes.deletedNodes)
-	{
-		auto it = m_nodeLevel.find(node);
-		if (it != m_nodeLevel.end())
-			m_nodeLevel.erase(it);
-
-		auto it2 = m_nodedebugLevel.find(node);
-		if (it2 != m_nodedebugLevel.end())
-			m_nodedebugLevel.erase(it2);
-	}
-
-	// Add leaf nodes to list
-	for (OctRepNode* node : changes.newNodes)
-		if (node->GetResolution() == m_layers[0].GetResolution())
-		{
-			(m_nodeLevel[node] = VoxelPartialMeshData()).isStale = true;
-			(m_nodedebugLevel[node] = VoxelPartialMeshData()).isStale = true;
-		}
-
-
-	// Update leaf nodes to list
-	for (OctRepNode* node : changes.updatedNodes)
-	{
-		auto it = m_nodeLevel.find(node);
-		if (it != m_nodeLevel.end())
-			it->second.isStale = true;
-
-		auto it2 = m_nodedebugLevel.find(node);
-		if (it2 != m_nodedebugLevel.end())
-			it2->second.isStale = true;
-	}
-
+	// Layers are only told about the changes when the mesh is next built, so repeated edits to a node are only handled once
+	m_octree->Push(x, y, z, value, m_changes);
 
 	TEST_REBUILD = true;
 }
@@ -1548,7 +1500,7 @@ float OctreeRepVolume::Get(uint32 x, uint32 y, uint32 z)
 	if (x >= m_resolution.x || y >= m_resolution.y || z >= m_resolution.z)
 		return UNKNOWN_BUILD_VALUE;
 
-	return m_data[GetIndex(x, y, z)];
+	return DecodeVoxel(m_data.Get(x, y, z));
 }
 
 float OctreeRepVolume::Get(uint32 x, uint32 y, uint32 z) const
@@ -1556,67 +1508,263 @@ float OctreeRepVolume::Get(uint32 x, uint32 y, uint32 z) const
 	if (x >= m_resolution.x || y >= m_resolution.y || z >= m_resolution.z)
 		return UNKNOWN_BUILD_VALUE;
 
-	return m_data[GetIndex(x, y, z)];
+	return DecodeVoxel(m_data.Get(x, y, z));
 }
 
-void OctreeRepVolume::BuildMesh()
+void OctreeRepVolume::ProcessChanges()
 {
-	// Regen partial meshes and add them together to make main mesh
+	// Deleted first, as a new node may have been given the same address as one which was deleted
+	for (const OctRepNotifyPacket::DeletedNode& deleted : m_changes.deletedNodes)
 	{
-		MeshBuilderMinimal builder;
-		builder.MarkDynamic();
+		const int32 layerIndex = m_depthLayers[deleted.depth];
+		if (layerIndex != -1)
+			m_layers[layerIndex].OnDeleteNode(deleted.offset);
 
-		for (auto& pair : m_nodeLevel)
+		// Pointer is only used as a key, as the node has already been deleted
+		for (OctRepMeshLevel* level : { &m_nodeLevel, &m_nodedebugLevel })
 		{
-			// Rebuild mesh data
-			if (pair.second.isStale)
+			auto it = level->nodes.find(const_cast<OctRepNode*>(deleted.node));
+			if (it != level->nodes.end())
 			{
-				pair.second.Clear();
-				using namespace std::placeholders;
-				pair.first->GeneratePartialMesh(m_isoLevel, std::bind(&OctreeRepLayer::RetrieveEdge, &m_layers[0], _1, _2, _3, _4), &pair.second, m_layers[m_layers.size() - 1].GetResolution());
-				pair.second.isStale = false;
+				RemoveSharedVertices(*level, it->second);
+				level->arena.Release(it->second.range);
+				level->nodes.erase(it);
 			}
+		}
+	}
+
+	for (const auto& pair : m_changes.changedNodes)
+	{
+		OctRepNode* node = pair.first;
+		const int32 layerIndex = m_depthLayers[node->GetDepth()];
+		if (layerIndex == -1)
+			continue;
+
+		if (pair.second)
+		{
+			m_layers[layerIndex].OnNewNode(node);
 
-			// Add triangles to mesh
-			for (const auto& tri : pair.second.triangles)
+			// Add leaf nodes to list
+			if (layerIndex == 0)
 			{
-				const uint32 a = builder.AddVertex(tri.a, tri.weightedNormal);
-				const uint32 b = builder.AddVertex(tri.b, tri.weightedNormal);
-				const uint32 c = builder.AddVertex(tri.c, tri.weightedNormal);
-				builder.AddTriangle(a, b, c);
+				m_nodeLevel.nodes[node] = OctRepNodeMesh();
+				m_nodedebugLevel.nodes[node] = OctRepNodeMesh();
+				m_staleNodes.push_back(node);
 			}
 		}
+		else
+		{
+			m_layers[layerIndex].OnModifyNode(node);
+			MarkStale(node);
+		}
+	}
+
+	m_changes.Clear();
+}
+
+void OctreeRepVolume::MarkStale(OctRepNode* node)
+{
+	auto it = m_nodeLevel.nodes.find(node);
+	if (it == m_nodeLevel.nodes.end())
+		return;
+
+	// Only queue each node once, however many times it's changed
+	if (!it->second.isStale)
+	{
+		it->second.isStale = true;
+		m_staleNodes.push_back(node);
+	}
+
+	auto it2 = m_nodedebugLevel.nodes.find(node);
+	if (it2 != m_nodedebugLevel.nodes.end())
+		it2->second.isStale = true;
+}
+
+void OctreeRepVolume::PatchLevel(OctRepMeshLevel& level, Mesh* target, const bool& debug)
+{
+	VoxelPartialMeshData partial;
+	MeshBuilderMinimal builder;
+	const uint32 minRes = m_layers[m_layers.size() - 1].GetResolution();
+
+	for (OctRepNode* node : m_staleNodes)
+	{
+		// Node may have been deleted since it was marked
+		auto it = level.nodes.find(node);
+		if (it == level.nodes.end() || !it->second.isStale)
+			continue;
+
+		// Rebuild mesh data
+		partial.Clear();
+		if (debug)
+			node->GenerateDebugPartialMesh(m_isoLevel, &partial, minRes);
+		else
+		{
+			using namespace std::placeholders;
+			node->GeneratePartialMesh(m_isoLevel, std::bind(&OctreeRepLayer::RetrieveEdge, &m_layers[0], _1, _2, _3, _4), &partial, minRes);
+		}
+
+		// Only this node's range of the arena is rewritten (Border normals are fixed up below)
+		builder.Clear();
+		for (const auto& tri : partial.triangles)
+		{
+			const uint32 a = builder.AddVertex(tri.a, tri.weightedNormal);
+			const uint32 b = builder.AddVertex(tri.b, tri.weightedNormal);
+			const uint32 c = builder.AddVertex(tri.c, tri.weightedNormal);
+			builder.AddTriangle(a, b, c);
+		}
+
+		OctRepNodeMesh& mesh = it->second;
+		RemoveSharedVertices(level, mesh);
+		level.arena.Write(mesh.range, builder);
+		AddSharedVertices(level, node, mesh, builder);
+		mesh.isStale = false;
+	}
+
 
-		builder.BuildMesh(m_mesh);
+	// Smooth the normals of any shared vertices which have changed across every node which uses them
+	for (const vec3& position : level.changedVertices)
+	{
+		auto it = level.sharedVertices.find(position);
+		if (it == level.sharedVertices.end())
+			continue;
+
+		OctRepSharedVertex& shared = it->second;
+		shared.isChanged = false;
+
+		vec3 normal(0, 0, 0);
+		for (uint32 i = 0; i < shared.userCount; ++i)
+			normal += shared.users[i]->borderNormals[shared.slots[i]];
+
+		for (uint32 i = 0; i < shared.userCount; ++i)
+			level.arena.SetNormal(shared.users[i]->range, shared.users[i]->borderVertices[shared.slots[i]], normal);
 	}
+	level.changedVertices.clear();
 
 
-	if(m_debugMesh)
+	// Close up the gaps once they start to build up
+	if (level.arena.ShouldCompact())
 	{
-		MeshBuilderMinimal debugBuilder;
-		debugBuilder.MarkDynamic();
+		std::vector<MeshArena::Range*> ranges;
+		ranges.reserve(level.nodes.size());
+		for (auto& pair : level.nodes)
+			ranges.push_back(&pair.second.range);
+		level.arena.Compact(ranges);
+	}
+
+	level.arena.Upload(target);
+}
 
-		for (auto& pair : m_nodedebugLevel)
+void OctreeRepVolume::AddSharedVertices(OctRepMeshLevel& level, const OctRepNode* node, OctRepNodeMesh& mesh, const MeshBuilderMinimal& builder)
+{
+	const std::vector<vec3>& vertices = builder.GetVertices();
+	const std::vector<vec3>& normals = builder.GetNormals();
+	const vec3 low = node->GetOffset();
+	const vec3 high = low + vec3(node->GetResolution() - 1);
+
+	for (uint32 i = 0; i < vertices.size(); ++i)
+	{
+		// Only vertices on the node's faces can be used by any other node
+		const vec3& vertex = vertices[i];
+		if (vertex.x != low.x && vertex.x != high.x && vertex.y != low.y && vertex.y != high.y && vertex.z != low.z && vertex.z != high.z)
+			continue;
+
+		OctRepSharedVertex& shared = level.sharedVertices[vertex];
+		if (shared.userCount == OctRepSharedVertex::MaxUsers)
+			continue;
+
+		shared.users[shared.userCount] = &mesh;
+		shared.slots[shared.userCount] = mesh.borderVertices.size();
+		++shared.userCount;
+
+		mesh.borderVertices.push_back(i);
+		mesh.borderNormals.push_back(normals[i]);
+		if (!shared.isChanged)
 		{
-			// Rebuild mesh data
-			if (pair.second.isStale)
-			{
-				pair.second.Clear();
-				using namespace std::placeholders;
-				pair.first->GenerateDebugPartialMesh(m_isoLevel, &pair.second, m_layers[m_layers.size() - 1].GetResolution());
-				pair.second.isStale = false;
-			}
+			shared.isChanged = true;
+			level.changedVertices.push_back(vertex);
+		}
+	}
+}
 
-			// Add triangles to mesh
-			for (const auto& tri : pair.second.triangles)
+void OctreeRepVolume::RemoveSharedVertices(OctRepMeshLevel& level, OctRepNodeMesh& mesh)
+{
+	for (const uint32& index : mesh.borderVertices)
+	{
+		const vec3& vertex = level.arena.GetVertex(mesh.range, index);
+		auto it = level.sharedVertices.find(vertex);
+		if (it == level.sharedVertices.end())
+			continue;
+
+		// Swap this node's entry out with the last user's
+		OctRepSharedVertex& shared = it->second;
+		for (uint32 i = 0; i < shared.userCount; ++i)
+			if (shared.users[i] == &mesh)
 			{
-				const uint32 a = debugBuilder.AddVertex(tri.a, tri.weightedNormal);
-				const uint32 b = debugBuilder.AddVertex(tri.b, tri.weightedNormal);
-				const uint32 c = debugBuilder.AddVertex(tri.c, tri.weightedNormal);
-				debugBuilder.AddTriangle(a, b, c);
+				--shared.userCount;
+				shared.users[i] = shared.users[shared.userCount];
+				shared.slots[i] = shared.slots[shared.userCount];
+				break;
 			}
-		}
 
-		debugBuilder.BuildMesh(m_debugMesh);
+		if (shared.userCount == 0)
+			level.sharedVertices.erase(it);
+		else if (!shared.isChanged)
+		{
+			shared.isChanged = true;
+			level.changedVertices.push_back(vertex);
+		}
 	}
-}
\ No newline at end of file
+
+	mesh.borderVertices.clear();
+	mesh.borderNormals.clear();
+}
+
+void OctreeRepVolume::BuildMesh()
+{
+	ProcessChanges();
+
+	// Regen stale partial meshes and patch them into the main mesh
+	PatchLevel(m_nodeLevel, m_mesh, false);
+
+	if (m_debugMesh)
+		PatchLevel(m_nodedebugLevel, m_debugMesh, true);
+
+	m_staleNodes.clear();
+}
+
+#include <chrono>
+using namespace std::chrono;
+VoxelBuildResults OctreeRepVolume::Rebuild(const std::vector<VoxelDelta>& deltas, VoxelBuildResults* recreation)
+{
+	// recreation ignored for OctreeRepVolume
+	VoxelBuildResults results;
+
+	results.buildTime.resize(1);
+	results.tricount.resize(1);
+
+
+	int64 startTime = duration_cast<microseconds>(high_resolution_clock::now().time_since_epoch()).count();
+	int64 endTime;
+
+	// Insert values
+	ApplyDeltas(deltas);
+
+	endTime = duration_cast<microseconds>(high_resolution_clock::now().time_since_epoch()).count();
+	results.insertTime = endTime - startTime;
+
+
+	// Rebuild mesh
+	int64 buildStartTime = duration_cast<microseconds>(high_resolution_clock::now().time_since_epoch()).count();
+	BuildMesh();
+	TEST_REBUILD = false;
+
+	endTime = duration_cast<microseconds>(high_resolution_clock::now().time_since_epoch()).count();
+	results.buildTime[0] = endTime - buildStartTime;
+	results.tricount[0] = m_nodeLevel.arena.GetIndexCount(); // Mesh also draws the degenerate triangles left in any gaps
+
+
+	// Total time
+	endTime = duration_cast<microseconds>(high_resolution_clock::now().time_since_epoch()).count();
+	results.totalTime = endTime - startTime;
+	return results;
+}
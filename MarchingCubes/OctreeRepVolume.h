@@ -1,9 +1,12 @@
 #pragma once
 #include "Object.h"
 #include "VoxelVolume.h"
+#include "VoxelSample.h"
+#include "VoxelGrid.h"
 
 #include "Material.h"
 #include "Mesh.h"
+#include "MeshArena.h"
 
 #include <map>
 #include <unordered_map>
@@ -15,12 +18,79 @@ class OctRepNode;
 
 /**
 * Packet to return any nodes which have changed
+* Can be collected across many pushes, as each node is only stored once however many times it changes
 */
 struct OctRepNotifyPacket 
 {
-	std::vector<OctRepNode*> newNodes;
-	std::vector<OctRepNode*> updatedNodes;
-	std::vector<OctRepNode*> deletedNodes;
+	/**
+	* A node which has been deleted (Only the pointer's value is kept, as the node itself can no longer be read)
+	*/
+	struct DeletedNode
+	{
+		const OctRepNode* node;
+		uvec3 offset;
+		uint32 depth;
+	};
+
+	std::unordered_map<OctRepNode*, bool> changedNodes; // Every new or updated node, and whether it's new (Didn't exist before this packet)
+	std::vector<DeletedNode> deletedNodes; // Nodes which existed before this packet and have since been deleted
+
+	/// Record that a node has been created
+	inline void OnNewNode(OctRepNode* node) { changedNodes[node] = true; }
+
+	/// Record that a node has been modified
+	inline void OnModifyNode(OctRepNode* node) { changedNodes.emplace(node, false); }
+
+	/// Record that a node is about to be deleted
+	void OnDeleteNode(const OctRepNode* node);
+
+	inline bool IsEmpty() const { return changedNodes.empty() && deletedNodes.empty(); }
+	/** Empty the packet (Releasing the table if it has grown large, e.g. after loading, as clearing it costs as much as its bucket count) */
+	inline void Clear()
+	{
+		if (changedNodes.bucket_count() > 4096)
+			std::unordered_map<OctRepNode*, bool>().swap(changedNodes);
+		else
+			changedNodes.clear();
+		deletedNodes.clear();
+	}
+};
+
+
+/**
+* Where a node's part of the mesh lives in the volume's arena
+*/
+struct OctRepNodeMesh
+{
+	MeshArena::Range range;
+	std::vector<uint32> borderVertices; // Index (Within the range) of every vertex on the node's border
+	std::vector<vec3> borderNormals; // This node's own (Un-normalized) normal for each border vertex
+	bool isStale = true;
+};
+
+/**
+* A vertex on the border of one or more nodes, which all of those nodes must draw with the same normal
+*/
+struct OctRepSharedVertex
+{
+	static const uint32 MaxUsers = 8; // A vertex can at most sit on the corner of 8 nodes
+
+	uint32 userCount = 0;
+	bool isChanged = false; // Already queued to have its normal rewritten
+	std::array<OctRepNodeMesh*, MaxUsers> users;
+	std::array<uint32, MaxUsers> slots; // Where the vertex is in each user's border list
+};
+
+/**
+* Every node's part of a single mesh
+* Vertices on node borders are tracked by position, so their normals are smoothed across every node which uses them
+*/
+struct OctRepMeshLevel
+{
+	std::unordered_map<OctRepNode*, OctRepNodeMesh> nodes; // (Meshes must stay at the same address, as shared vertices point to them)
+	std::unordered_map<vec3, OctRepSharedVertex, vec3_KeyFuncs, vec3_KeyFuncs> sharedVertices;
+	std::vector<vec3> changedVertices; // Shared vertices whose users have changed since the last patch
+	MeshArena arena;
 };
 
 
@@ -105,6 +175,12 @@ public:
 	inline uint32 GetDepth() const { return m_depth; }
 	uint32 GetChildResolution() const;
 
+	/**
+	* The resolution of the children of a node at this resolution
+	* @param resolution			The resolution of the parent
+	*/
+	static inline uint32 GetChildResolution(const uint32& resolution) { return resolution > 3 ? (resolution - 1) / 2 + 1 : 2; }
+
 private:
 	inline uint32 GetIndex(const uint32& x, const uint32& y, const uint32& z) const { return x + 2 * (y + 2 * z); }
 };
@@ -155,7 +231,7 @@ public:
 	void OnModifyNode(OctRepNode* node);
 	
 	/// Callback for when a node deleted
-	void OnDeleteNode(const OctRepNode* node);
+	void OnDeleteNode(const uvec3& offset);
 
 private:
 	vec3 ProjectCorners(const float& isoLevel, const uvec3& a, const uvec3& b, const uvec3& bottomLeft, const uvec3& bottomRight, const uvec3& topLeft, const uvec3& topRight) const;
@@ -187,9 +263,12 @@ private:
 	///
 	/// Volume vars
 	///
-	std::vector<float> m_data;
-	OctRepNode* m_octree;
+	VoxelGrid m_data;
+	VoxelLayout m_layout = VoxelLayout::Linear;
+	OctRepNode* m_octree = nullptr;
 	std::vector<OctreeRepLayer> m_layers;
+	std::vector<int32> m_depthLayers; // The index of the layer which holds nodes at each depth (-1 if none do)
+	OctRepNotifyPacket m_changes; // Every change since the layers were last told
 
 	float m_isoLevel;
 	vec3 m_scale = vec3(1, 1, 1);
@@ -198,8 +277,9 @@ private:
 	///
 	/// Levels vars
 	///
-	std::unordered_map<OctRepNode*, VoxelPartialMeshData> m_nodeLevel;
-	std::unordered_map<OctRepNode*, VoxelPartialMeshData> m_nodedebugLevel;
+	OctRepMeshLevel m_nodeLevel;
+	OctRepMeshLevel m_nodedebugLevel;
+	std::vector<OctRepNode*> m_staleNodes; // Every node which has been marked stale since the last build (May contain deleted nodes)
 
 
 	bool TEST_REBUILD = false;
@@ -221,6 +301,7 @@ public:
 	///
 public:
 	virtual void Init(const uvec3& resolution, const vec3& scale) override;
+	virtual VoxelBuildResults Rebuild(const std::vector<VoxelDelta>& deltas, VoxelBuildResults* recreation) override;
 
 	virtual void Set(uint32 x, uint32 y, uint32 z, float value) override;
 	virtual float Get(uint32 x, uint32 y, uint32 z) override; // TODO - FIX THAT GET
@@ -235,12 +316,51 @@ public:
 	// TODO - MAKE PROPER
 	void BuildMesh();
 
+private:
+	/**
+	* Pass every change which has been collected since the last build on to the layers and partial meshes
+	*/
+	void ProcessChanges();
+
+	/**
+	* Flag this node's partial meshes to be rebuilt during the next build
+	* @param node				The node which has changed
+	*/
+	void MarkStale(OctRepNode* node);
+
+	/**
+	* Rebuild any stale nodes in this level and write them into its arena
+	* Any border vertices which the rebuilt nodes share have their normals re-patched in every node which uses them
+	* @param level				The nodes to check
+	* @param target				The mesh to upload any changes to
+	* @param debug				Should the debug partial mesh be generated, rather than the surface
+	*/
+	void PatchLevel(OctRepMeshLevel& level, Mesh* target, const bool& debug);
+
+	/**
+	* Register every vertex on the border of this node's (Freshly written) mesh as shared
+	* @param level				The level the node is in
+	* @param node				The node which owns the mesh
+	* @param mesh				The node's mesh
+	* @param builder			The data which was just written into the node's range
+	*/
+	void AddSharedVertices(OctRepMeshLevel& level, const OctRepNode* node, OctRepNodeMesh& mesh, const MeshBuilderMinimal& builder);
+
+	/**
+	* Stop this node's mesh from contributing to any shared vertices (Must be called before its range is changed)
+	* @param level				The level the mesh is in
+	* @param mesh				The node's mesh
+	*/
+	void RemoveSharedVertices(OctRepMeshLevel& level, OctRepNodeMesh& mesh);
+
 	///
 	/// Getters & Setters
 	///
-private:
-	inline uint32 GetIndex(uint32 x, uint32 y, uint32 z) const { return x + m_resolution.x * (y + m_resolution.y * z); }
 public:
 	inline vec3 GetScale() const { return m_scale; }
+
+	/** How the voxels should be laid out in memory (Only takes effect on the next Init) */
+	inline void SetLayout(const VoxelLayout& layout) { m_layout = layout; }
+	inline VoxelLayout GetLayout() const { return m_layout; }
 };
 
@@ -271,7 +271,7 @@ float OctreeVolumeBranch::FetchBuildIsolevel(int32 maxDepth, int32 x, int32 y, i
 	// Get appropriate value
 	const OctreeVolumeBranch* nodeAsBranch = dynamic_cast<const OctreeVolumeBranch*>(node);
 	if (nodeAsBranch)
-		nodeAsBranch->FetchBuildIsolevel(
+		return nodeAsBranch->FetchBuildIsolevel(
 			maxDepth,
 			isRight ? x - halfRes : x,
 			isTop ? y - halfRes : y,
@@ -346,38 +346,21 @@ void OctreeVolumeBranch::ConstructMesh(MeshBuilderMinimal& build, float isoLevel
 		return;
 
 	// Smooth edges based on density
-#define VERT_LERP(x0, y0, z0, x1, y1, z1) MC::VertexLerp(isoLevel, worldCoord + vec3(x0, y0, z0)*resf, worldCoord + vec3(x1, y1, z1)*resf, v ## x0 ## y0 ## z0, v ## x1 ## y1 ## z1);
-
+	const float values[8] = { v000, v100, v101, v001, v010, v110, v111, v011 }; // Ordered by their bit in the case index
 	vec3 edges[12];
 
-	if (MC::CaseRequiredEdges[caseIndex] & 1)
-		edges[0] = VERT_LERP(0, 0, 0, 1, 0, 0);
-	if (MC::CaseRequiredEdges[caseIndex] & 2)
-		edges[1] = VERT_LERP(1, 0, 0, 1, 0, 1);
-	if (MC::CaseRequiredEdges[caseIndex] & 4)
-		edges[2] = VERT_LERP(0, 0, 1, 1, 0, 1);
-	if (MC::CaseRequiredEdges[caseIndex] & 8)
-		edges[3] = VERT_LERP(0, 0, 0, 0, 0, 1);
-	if (MC::CaseRequiredEdges[caseIndex] & 16)
-		edges[4] = VERT_LERP(0, 1, 0, 1, 1, 0);
-	if (MC::CaseRequiredEdges[caseIndex] & 32)
-		edges[5] = VERT_LERP(1, 1, 0, 1, 1, 1);
-	if (MC::CaseRequiredEdges[caseIndex] & 64)
-		edges[6] = VERT_LERP(0, 1, 1, 1, 1, 1);
-	if (MC::CaseRequiredEdges[caseIndex] & 128)
-		edges[7] = VERT_LERP(0, 1, 0, 0, 1, 1);
-	if (MC::CaseRequiredEdges[caseIndex] & 256)
-		edges[8] = VERT_LERP(0, 0, 0, 0, 1, 0);
-	if (MC::CaseRequiredEdges[caseIndex] & 512)
-		edges[9] = VERT_LERP(1, 0, 0, 1, 1, 0);
-	if (MC::CaseRequiredEdges[caseIndex] & 1024)
-		edges[10] = VERT_LERP(1, 0, 1, 1, 1, 1);
-	if (MC::CaseRequiredEdges[caseIndex] & 2048)
-		edges[11] = VERT_LERP(0, 0, 1, 0, 1, 1);
+	const uint32 requiredEdges = MC::CaseRequiredEdges[caseIndex];
+	for (uint32 e = 0; e < 12; ++e)
+		if (requiredEdges & (1 << e))
+		{
+			const uint8 a = MC::EdgeCorners[e][0];
+			const uint8 b = MC::EdgeCorners[e][1];
+			edges[e] = MC::VertexLerp(isoLevel, worldCoord + vec3(MC::CornerOffset(a))*resf, worldCoord + vec3(MC::CornerOffset(b))*resf, values[a], values[b]);
+		}
 
 
 	// Add triangles for this case
-	int8* caseEdges = MC::Cases[caseIndex];
+	const int8* caseEdges = MC::Cases[caseIndex];
 	while (*caseEdges != -1)
 	{
 		int8 edge0 = *(caseEdges++);
@@ -529,38 +512,21 @@ void OctreeVolumeLeaf::ConstructMesh(MeshBuilderMinimal& build, float isoLevel,
 
 
 		// Smooth edges based on density
-#define VERT_LERP(x0, y0, z0, x1, y1, z1) MC::VertexLerp(isoLevel, worldCoord + vec3(x0, y0, z0)*resf, worldCoord + vec3(x1, y1, z1)*resf, v ## x0 ## y0 ## z0, v ## x1 ## y1 ## z1);
-
+		const float values[8] = { v000, v100, v101, v001, v010, v110, v111, v011 }; // Ordered by their bit in the case index
 		vec3 edges[12];
 
-		if (MC::CaseRequiredEdges[caseIndex] & 1)
-			edges[0] = VERT_LERP(0, 0, 0, 1, 0, 0);
-		if (MC::CaseRequiredEdges[caseIndex] & 2)
-			edges[1] = VERT_LERP(1, 0, 0, 1, 0, 1);
-		if (MC::CaseRequiredEdges[caseIndex] & 4)
-			edges[2] = VERT_LERP(0, 0, 1, 1, 0, 1);
-		if (MC::CaseRequiredEdges[caseIndex] & 8)
-			edges[3] = VERT_LERP(0, 0, 0, 0, 0, 1);
-		if (MC::CaseRequiredEdges[caseIndex] & 16)
-			edges[4] = VERT_LERP(0, 1, 0, 1, 1, 0);
-		if (MC::CaseRequiredEdges[caseIndex] & 32)
-			edges[5] = VERT_LERP(1, 1, 0, 1, 1, 1);
-		if (MC::CaseRequiredEdges[caseIndex] & 64)
-			edges[6] = VERT_LERP(0, 1, 1, 1, 1, 1);
-		if (MC::CaseRequiredEdges[caseIndex] & 128)
-			edges[7] = VERT_LERP(0, 1, 0, 0, 1, 1);
-		if (MC::CaseRequiredEdges[caseIndex] & 256)
-			edges[8] = VERT_LERP(0, 0, 0, 0, 1, 0);
-		if (MC::CaseRequiredEdges[caseIndex] & 512)
-			edges[9] = VERT_LERP(1, 0, 0, 1, 1, 0);
-		if (MC::CaseRequiredEdges[caseIndex] & 1024)
-			edges[10] = VERT_LERP(1, 0, 1, 1, 1, 1);
-		if (MC::CaseRequiredEdges[caseIndex] & 2048)
-			edges[11] = VERT_LERP(0, 0, 1, 0, 1, 1);
+		const uint32 requiredEdges = MC::CaseRequiredEdges[caseIndex];
+		for (uint32 e = 0; e < 12; ++e)
+			if (requiredEdges & (1 << e))
+			{
+				const uint8 a = MC::EdgeCorners[e][0];
+				const uint8 b = MC::EdgeCorners[e][1];
+				edges[e] = MC::VertexLerp(isoLevel, worldCoord + vec3(MC::CornerOffset(a))*resf, worldCoord + vec3(MC::CornerOffset(b))*resf, values[a], values[b]);
+			}
 
 
 		// Add triangles for this case
-		int8* caseEdges = MC::Cases[caseIndex];
+		const int8* caseEdges = MC::Cases[caseIndex];
 		while (*caseEdges != -1)
 		{
 			int8 edge0 = *(caseEdges++);
@@ -654,8 +620,11 @@ void OctreeVolume::Begin()
 	m_material = new DefaultMaterial;
 	m_wireMaterial = new InteractionMaterial;
 
-	m_mesh = new Mesh;
-	m_mesh->MarkDynamic();
+	if (m_mesh == nullptr)
+	{
+		m_mesh = new Mesh;
+		m_mesh->MarkDynamic();
+	}
 
 	TEST_MESH = new Mesh;
 	TEST_MESH->MarkDynamic();
@@ -729,6 +698,12 @@ void OctreeVolume::Init(const uvec3 & resolution, const vec3 & scale)
 	m_resolution = uvec3(res, res, res);
 	m_scale = scale;
 	m_root = new OctreeVolumeBranch(res);
+
+	if (m_mesh == nullptr)
+	{
+		m_mesh = new Mesh;
+		m_mesh->MarkDynamic();
+	}
 }
 
 void OctreeVolume::Set(uint32 x, uint32 y, uint32 z, float value)
@@ -769,4 +744,41 @@ void OctreeVolume::BuildTreeMesh()
 		node->ConstructDebugMesh(builder, m_isoLevel);
 
 	builder.BuildMesh(TEST_MESH);
-}
\ No newline at end of file
+}
+
+#include <chrono>
+using namespace std::chrono;
+VoxelBuildResults OctreeVolume::Rebuild(const std::vector<VoxelDelta>& deltas, VoxelBuildResults* recreation)
+{
+	// recreation ignored for OctreeVolume
+	VoxelBuildResults results;
+
+	results.buildTime.resize(1);
+	results.tricount.resize(1);
+
+
+	int64 startTime = duration_cast<microseconds>(high_resolution_clock::now().time_since_epoch()).count();
+	int64 endTime;
+
+	// Insert values
+	ApplyDeltas(deltas);
+
+	endTime = duration_cast<microseconds>(high_resolution_clock::now().time_since_epoch()).count();
+	results.insertTime = endTime - startTime;
+
+
+	// Rebuild mesh
+	int64 buildStartTime = duration_cast<microseconds>(high_resolution_clock::now().time_since_epoch()).count();
+	BuildMesh();
+	TEST_REBUILD = false;
+
+	endTime = duration_cast<microseconds>(high_resolution_clock::now().time_since_epoch()).count();
+	results.buildTime[0] = endTime - buildStartTime;
+	results.tricount[0] = m_mesh->GetDrawCount();
+
+
+	// Total time
+	endTime = duration_cast<microseconds>(high_resolution_clock::now().time_since_epoch()).count();
+	results.totalTime = endTime - startTime;
+	return results;
+}
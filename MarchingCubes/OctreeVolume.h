@@ -208,7 +208,7 @@ private:
 	///
 	/// Volume vars
 	///
-	OctreeVolumeNode* m_root;
+	OctreeVolumeNode* m_root = nullptr;
 	float m_isoLevel;
 	vec3 m_scale = vec3(1, 1, 1);
 	uvec3 m_resolution;
@@ -216,8 +216,8 @@ private:
 
 	/// TEST VARS TODO REMOVE
 	std::vector<OctreeVolumeNode*> testLayer;
-	Mesh* m_mesh;
-	Mesh* TEST_MESH;
+	Mesh* m_mesh = nullptr;
+	Mesh* TEST_MESH = nullptr;
 	bool TEST_REBUILD = false;
 
 public:
@@ -239,6 +239,7 @@ public:
 	///
 public:
 	virtual void Init(const uvec3& resolution, const vec3& scale) override;
+	virtual VoxelBuildResults Rebuild(const std::vector<VoxelDelta>& deltas, VoxelBuildResults* recreation) override;
 
 	virtual void Set(uint32 x, uint32 y, uint32 z, float value) override;
 	virtual float Get(uint32 x, uint32 y, uint32 z) override;
@@ -0,0 +1,74 @@
+#include "PackedVertex.h"
+
+
+void VertexPacking::EncodeNormal(const vec3& normal, int8 out[2])
+{
+	const float length = glm::abs(normal.x) + glm::abs(normal.y) + glm::abs(normal.z);
+	if (length == 0.0f)
+	{
+		out[0] = 0;
+		out[1] = 0;
+		return;
+	}
+
+	// Project onto the octahedron, then fold the lower half over the diagonals
+	vec2 encoded = vec2(normal.x, normal.y) / length;
+	if (normal.z < 0.0f)
+		encoded = vec2(
+			(1.0f - glm::abs(encoded.y)) * (encoded.x >= 0.0f ? 1.0f : -1.0f),
+			(1.0f - glm::abs(encoded.x)) * (encoded.y >= 0.0f ? 1.0f : -1.0f)
+		);
+
+	out[0] = (int8)glm::round(glm::clamp(encoded.x, -1.0f, 1.0f) * 127.0f);
+	out[1] = (int8)glm::round(glm::clamp(encoded.y, -1.0f, 1.0f) * 127.0f);
+}
+
+vec3 VertexPacking::DecodeNormal(const int8 in[2])
+{
+	const vec2 encoded(glm::max(in[0] / 127.0f, -1.0f), glm::max(in[1] / 127.0f, -1.0f));
+
+	vec3 normal(encoded.x, encoded.y, 1.0f - glm::abs(encoded.x) - glm::abs(encoded.y));
+	if (normal.z < 0.0f)
+	{
+		normal.x = (1.0f - glm::abs(encoded.y)) * (encoded.x >= 0.0f ? 1.0f : -1.0f);
+		normal.y = (1.0f - glm::abs(encoded.x)) * (encoded.y >= 0.0f ? 1.0f : -1.0f);
+	}
+
+	return glm::normalize(normal);
+}
+
+void VertexPacking::EncodePosition(const vec3& position, const vec3& origin, const vec3& extent, uint16 out[3])
+{
+	for (uint32 i = 0; i < 3; ++i)
+	{
+		const float t = extent[i] <= 0.0f ? 0.0f : (position[i] - origin[i]) / extent[i];
+		out[i] = (uint16)glm::round(glm::clamp(t, 0.0f, 1.0f) * 65535.0f);
+	}
+}
+
+vec3 VertexPacking::DecodePosition(const uint16 in[3], const vec3& origin, const vec3& extent)
+{
+	return origin + vec3(in[0], in[1], in[2]) / 65535.0f * extent;
+}
+
+void VertexPacking::Pack(const std::vector<vec3>& vertices, const std::vector<vec3>& normals, const std::vector<uint32>& indices, const vec3& origin, const vec3& extent, PackedMeshData& out)
+{
+	out.origin = origin;
+	out.extent = extent;
+
+	out.vertices.resize(vertices.size());
+	for (uint32 i = 0; i < vertices.size(); ++i)
+	{
+		PackedVertex& vertex = out.vertices[i];
+		EncodePosition(vertices[i], origin, extent, vertex.position);
+		EncodeNormal(normals[i], vertex.normal);
+	}
+
+	out.shortIndices.clear();
+	out.indices.clear();
+
+	if (vertices.size() <= MaxShortIndexVertices)
+		out.shortIndices.assign(indices.begin(), indices.end());
+	else
+		out.indices = indices;
+}
@@ -0,0 +1,87 @@
+#pragma once
+#include "Common.h"
+#include <vector>
+
+
+/**
+* A single interleaved vertex, 8 bytes rather than the 24 used by separate vec3 position/normal streams
+* -position:	16-bit fixed point, across the mesh's bounds (Read by the GPU as normalized unsigned shorts)
+* -normal:		Octahedral encoded, 8-bits per axis (Read by the GPU as normalized signed bytes)
+*/
+struct PackedVertex
+{
+	uint16 position[3];
+	int8 normal[2];
+};
+static_assert(sizeof(PackedVertex) == 8, "PackedVertex must be tightly packed for the GPU");
+
+
+/**
+* A mesh which has been packed, ready for uploading
+*/
+struct PackedMeshData
+{
+	std::vector<PackedVertex> vertices;
+
+	/// Only one of these is filled, depending on whether every index fits in 16-bits
+	std::vector<uint16> shortIndices;
+	std::vector<uint32> indices;
+
+	/// The position a vertex decodes to is origin + (position / 65535) * extent
+	vec3 origin;
+	vec3 extent;
+
+	inline bool UsesShortIndices() const { return indices.empty(); }
+};
+
+
+/**
+* Conversion between float vertex data and PackedVertex (Kept free of any GL, so can be used/checked without a context)
+*/
+namespace VertexPacking
+{
+	/// The largest vertex count which can still be indexed using 16-bit indices
+	const uint32 MaxShortIndexVertices = 65536;
+
+	/**
+	* Encode a normal onto an octahedron and fold it into the unit square
+	* @param normal				The normal to encode (Doesn't need to be normalized, a zero normal encodes as +z)
+	* @param out				Where to store the encoded x,y
+	*/
+	void EncodeNormal(const vec3& normal, int8 out[2]);
+
+	/**
+	* Decode an octahedral normal (Matches the decode in the shaders)
+	* @param in					The encoded x,y
+	* @returns The normalized normal
+	*/
+	vec3 DecodeNormal(const int8 in[2]);
+
+	/**
+	* Quantize a position to 16-bits on each axis
+	* @param position			The position to encode (Clamped to the bounds)
+	* @param origin				The minimum corner of the bounds
+	* @param extent				The size of the bounds
+	* @param out				Where to store the encoded x,y,z
+	*/
+	void EncodePosition(const vec3& position, const vec3& origin, const vec3& extent, uint16 out[3]);
+
+	/**
+	* Decode a quantized position
+	* @param in					The encoded x,y,z
+	* @param origin				The minimum corner of the bounds which was used to encode it
+	* @param extent				The size of the bounds which was used to encode it
+	*/
+	vec3 DecodePosition(const uint16 in[3], const vec3& origin, const vec3& extent);
+
+	/**
+	* Pack an indexed mesh into the interleaved format, using 16-bit indices if there are few enough vertices
+	* @param vertices			The positions of each vertex
+	* @param normals			The normals of each vertex
+	* @param indices			Every 3 indices make up a triangle
+	* @param origin				The minimum corner that positions are stored relative to (e.g. The chunk's offset)
+	* @param extent				The size of the space the positions are spread over (e.g. The chunk's size)
+	* @param out				Where to store the packed mesh
+	*/
+	void Pack(const std::vector<vec3>& vertices, const std::vector<vec3>& normals, const std::vector<uint32>& indices, const vec3& origin, const vec3& extent, PackedMeshData& out);
+}
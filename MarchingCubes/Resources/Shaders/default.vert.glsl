@@ -7,6 +7,11 @@ uniform mat4 WorldToView;
 // Perspective matrix
 uniform mat4 ViewToClip;
 
+// Are the vertices packed (See PackedVertex.h)
+uniform bool PackedVertices;
+uniform vec3 PackedOrigin;
+uniform vec3 PackedExtent;
+
 
 layout (location = 0) in vec3 inPos;
 layout (location = 1) in vec3 inNormal;
@@ -15,12 +20,29 @@ out vec3 passPos;
 out vec3 passNormal;
 
 
+vec3 DecodePosition(vec3 position)
+{
+	return PackedVertices ? PackedOrigin + position * PackedExtent : position;
+}
+
+vec3 DecodeNormal(vec3 normal)
+{
+	if (!PackedVertices)
+		return normal;
+
+	vec3 decoded = vec3(normal.xy, 1.0 - abs(normal.x) - abs(normal.y));
+	if (decoded.z < 0.0)
+		decoded.xy = (1.0 - abs(normal.yx)) * mix(vec2(-1.0), vec2(1.0), step(0.0, normal.xy));
+	return normalize(decoded);
+}
+
+
 void main()
 {
 	// Don't translate at all
-	vec4 worldLocation = ObjectToWorld * vec4(inPos, 1.0);
+	vec4 worldLocation = ObjectToWorld * vec4(DecodePosition(inPos), 1.0);
 	gl_Position = ViewToClip * WorldToView * worldLocation;
 	
 	passPos = worldLocation.xyz;
-	passNormal = inNormal;
+	passNormal = DecodeNormal(inNormal);
 }
\ No newline at end of file
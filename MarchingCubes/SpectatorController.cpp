@@ -5,9 +5,7 @@
 #include "Mesh.h"
 #include "InteractionMaterial.h"
 #include "Logger.h"
-#include "PerlinNoise.h"
-
-#include <fstream>
+#include "VoxelScenes.h"
 
 
 void SpectatorController::Begin()
@@ -99,66 +97,16 @@ void SpectatorController::Begin()
 		//*/
 
 		// Sphere
-		//*
-		const uint32 radius = 16;
-		const uint32 diametre = radius * 2;
-		currentVolume->Init(uvec3(diametre, diametre, diametre), vec3(1, 1, 1));
-
-		for (int x = 0; x < diametre; ++x)
-			for (int y = 0; y < diametre; ++y)
-				for (int z = 0; z < diametre; ++z)
-				{
-					float distance = glm::length(vec3(x, y, z) - vec3(radius, radius, radius));
-					float v = 1.0f - glm::clamp(distance / (float)radius, 0.0f, 1.0f);
-					currentVolume->Set(x, y, z, v);
-				}
-				//*/
+		VoxelScenes::BuildSphere(currentVolume, 16);
 
 		// Torus
-		/*
-		const uint32 ringRad = 20;
-		const uint32 tubeRad = 10;
-		const uint32 size = (tubeRad + ringRad) * 2;
-		currentVolume->Init(uvec3(size, size, size), vec3(1, 1, 1));
-
-		for (int x = 0; x < size; ++x)
-			for (int y = 0; y < size; ++y)
-				for (int z = 0; z < size; ++z)
-				{
-					uvec3 coord = uvec3(x - size / 2, y - size / 2, z - size / 2);
-
-					const float partA = (ringRad - sqrt(coord.x*coord.x + coord.y*coord.y));
-					float distance = partA*partA + coord.z*coord.z;
-					float v = 1.0f - glm::clamp(distance / (float)(tubeRad*tubeRad) , 0.0f, 1.0f);
-					currentVolume->Set(x, y, z, v);
-
-				}
-		//*/
+		//VoxelScenes::BuildTorus(currentVolume, 20, 10);
 
 		// Noise
-		/*
-		PerlinNoise noise(41513);
-		const uint32 size = 129;
-		currentVolume->Init(uvec3(size, size, size), vec3(1, 1, 1));
-		
-		for (int x = 1; x < size - 1; ++x)
-			for (int y = 1; y < size - 1; ++y)
-				for (int z = 1; z < size -1; ++z)
-					currentVolume->Set(x, y, z, noise.GetOctave(x * 0.04f, y * 0.04f, z * 0.04f, 3, 0.4f) * 0.27f);
-
-		//*/
+		//VoxelScenes::BuildNoise(currentVolume, 129, 41513);
 
 		// Flat platform
-		/*
-		volume->Init(uvec3(64, 64, 64), vec3(1, 1, 1));
-		for (int x = 0; x < 64; ++x)
-			for (int z = 0; z < 64; ++z)
-			{
-				currentVolume->Set(x, 63, z, 1.0f);
-				currentVolume->Set(x, 7, z, 0.5f);
-				currentVolume->Set(x, 0, z, 1.0f);
-			}
-			//*/
+		//VoxelScenes::BuildPlatform(currentVolume, 64);
 	}
 }
 
@@ -200,37 +148,7 @@ void SpectatorController::Update(const float& deltaTime)
 				currentFrame.results = currentVolume->Rebuild(currentFrame.deltas, nullptr);
 
 				// Save to recording file
-				std::ofstream file(demoFileName, std::ofstream::app | std::ofstream::binary);
-
-				// Record deltas
-				{
-					uint32 count = currentFrame.deltas.size();
-					file.write(reinterpret_cast<const char*>(&count), sizeof(uint32));
-
-					const void* data = currentFrame.deltas.data();
-					file.write(reinterpret_cast<const char*>(currentFrame.deltas.data()), currentFrame.deltas.size() * sizeof(VoxelDelta));
-				}
-
-				// Record results
-				{
-					const void* data;
-
-					data = &currentFrame.results.insertTime;
-					file.write(reinterpret_cast<const char*>(data), sizeof(int64));
-					data = &currentFrame.results.totalTime;
-					file.write(reinterpret_cast<const char*>(data), sizeof(int64));
-
-					uint32 count = currentFrame.results.buildTime.size();
-					file.write(reinterpret_cast<const char*>(&count), sizeof(uint32));
-
-					data = currentFrame.results.buildTime.data();
-					file.write(reinterpret_cast<const char*>(data), count * sizeof(int64));
-
-					data = currentFrame.results.tricount.data();
-					file.write(reinterpret_cast<const char*>(data), count * sizeof(uint32));
-				}
-
-				file.close();
+				DemoFile::AppendFrame(demoFileName, currentFrame);
 				currentFrame.clear();
 			}
 		}
@@ -247,52 +165,12 @@ void SpectatorController::Update(const float& deltaTime)
 			LOG("Begin playback for '%s'", demoFileName.c_str());
 			
 			// Load file
-			std::ifstream file(demoFileName, std::ofstream::binary);
-			uint32 count;
-
-			// Read all frames in the file
-			do
+			if (!DemoFile::ReadFrames(demoFileName, playbackFrames) || playbackFrames.size() == 0)
 			{
-				VoxelFrame frame;
-
-				// Read deltas
-				{
-					uint32 count;
-					file.read(reinterpret_cast<char*>(&count), sizeof(uint32));
-					frame.deltas.resize(count);
-
-					void* data = frame.deltas.data();
-					file.read(reinterpret_cast<char*>(frame.deltas.data()), frame.deltas.size() * sizeof(VoxelDelta));
-				}
-
-				// Read results
-				{
-					void* data;
-
-					data = &frame.results.insertTime;
-					file.read(reinterpret_cast<char*>(data), sizeof(int64));
-					data = &frame.results.totalTime;
-					file.read(reinterpret_cast<char*>(data), sizeof(int64));
-
-					uint32 count;
-					file.read(reinterpret_cast<char*>(&count), sizeof(uint32));
-					frame.results.buildTime.resize(count);
-					frame.results.tricount.resize(count);
-
-					data = frame.results.buildTime.data();
-					file.read(reinterpret_cast<char*>(data), count * sizeof(int64));
-
-					data = frame.results.tricount.data();
-					file.read(reinterpret_cast<char*>(data), count * sizeof(uint32));
-				}
-
-				playbackFrames.push_back(frame);
-			} 
-			while (file.good());
-			file.close();
-
-			// Delete last because dupe..??
-			playbackFrames.erase(playbackFrames.begin() + playbackFrames.size() - 1);
+				LOG_WARNING("No frames to play back in '%s'", demoFileName.c_str());
+				bIsPlayback = false;
+				return;
+			}
 			LOG("Read %i frames", playbackFrames.size());
 		}
 
@@ -333,14 +211,14 @@ void SpectatorController::Update(const float& deltaTime)
 				}
 
 				averageInsertTime /= playbackFrames.size();
-				LOG("Stats: Insert Time:%f", averageInsertTime);
+				LOG("Stats: Insert Time:%fus", averageInsertTime);
 
 				for (uint32 i = 0; i < count; ++i)
 				{
 					averageBuildTime[i] /= playbackFrames.size();
 					averageTriCount[i] /= playbackFrames.size();
 
-					LOG("LOD %i: Build Time:%f Count:%f Max Time:%f", i, averageBuildTime[i], averageTriCount[i], maxBuildTime[i]);
+					LOG("LOD %i: Build Time:%fus Count:%f Max Time:%fus", i, averageBuildTime[i], averageTriCount[i], maxBuildTime[i]);
 				}
 
 				playbackFrames.clear();
@@ -531,7 +409,12 @@ void SpectatorController::Update(const float& deltaTime)
 					}
 				}
 
-
+				// Apply the whole brush at once
+				if (m_pendingDeltas.size() != 0)
+				{
+					currentVolume->ApplyDeltas(m_pendingDeltas);
+					m_pendingDeltas.clear();
+				}
 			}
 		}
 	}
@@ -566,6 +449,6 @@ void SpectatorController::Set(const uint32& x, const uint32& y, const uint32& z,
 			currentFrame.deltas.push_back(delta);
 		}
 		else
-			currentVolume->Set(x, y, z, value);
+			m_pendingDeltas.push_back(VoxelDelta{ uvec3(x, y, z), value });
 	}
 }
\ No newline at end of file
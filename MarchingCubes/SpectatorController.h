@@ -2,6 +2,7 @@
 #include "Object.h"
 #include "Camera.h"
 #include "VoxelVolume.h"
+#include "DemoFile.h"
 
 
 enum class InteractionShape 
@@ -13,19 +14,6 @@ enum class InteractionShape
 };
 
 
-struct VoxelFrame 
-{
-	std::vector<VoxelDelta> deltas;
-	VoxelBuildResults results;
-
-	inline void clear() 
-	{
-		deltas.clear();
-		results.clear();
-	}
-};
-
-
 class SpectatorController : public Object
 {
 private:
@@ -52,6 +40,7 @@ private:
 
 	bool bIsRecording;
 	VoxelFrame currentFrame;
+	std::vector<VoxelDelta> m_pendingDeltas; // Edits waiting to be applied in a single batch
 
 	bool bIsPlayback;
 	uint32 playbackIndex;
@@ -66,6 +55,11 @@ public:
 	virtual void Draw(const Window* window, const float& deltaTime);
 
 private:
+	/**
+	* Queue a change to the volume (Applied at the end of the interaction, or recorded if recording)
+	* @param x,y,z				The coordinate of the voxel to change
+	* @param value				The value to set the voxel to
+	*/
 	void Set(const uint32& x, const uint32& y, const uint32& z, const float& value);
 };
 
@@ -0,0 +1,124 @@
+#include "ThreadPool.h"
+
+#include <atomic>
+#include <memory>
+
+
+ThreadPool::ThreadPool(uint32 workerCount)
+{
+	if (workerCount == 0)
+	{
+		const uint32 hardwareThreads = std::thread::hardware_concurrency();
+		workerCount = hardwareThreads > 1 ? hardwareThreads - 1 : 1;
+	}
+
+	for (uint32 i = 0; i < workerCount; ++i)
+		m_workers.emplace_back(&ThreadPool::WorkerLoop, this);
+}
+
+ThreadPool::~ThreadPool()
+{
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		bIsShuttingDown = true;
+	}
+	m_jobAvailable.notify_all();
+
+	for (std::thread& worker : m_workers)
+		worker.join();
+}
+
+ThreadPool& ThreadPool::GetShared()
+{
+	static ThreadPool pool;
+	return pool;
+}
+
+void ThreadPool::Enqueue(std::function<void()> job)
+{
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		m_jobs.emplace_back(std::move(job));
+	}
+	m_jobAvailable.notify_one();
+}
+
+void ThreadPool::WorkerLoop()
+{
+	while (true)
+	{
+		std::function<void()> job;
+
+		{
+			std::unique_lock<std::mutex> lock(m_mutex);
+			m_jobAvailable.wait(lock, [this]() { return bIsShuttingDown || !m_jobs.empty(); });
+
+			if (bIsShuttingDown && m_jobs.empty())
+				return;
+
+			job = std::move(m_jobs.front());
+			m_jobs.pop_front();
+		}
+
+		job();
+	}
+}
+
+void ThreadPool::ParallelFor(const uint32& count, const std::function<void(uint32)>& func)
+{
+	if (count == 0)
+		return;
+
+	// Not worth handing out to workers
+	if (count == 1)
+	{
+		func(0);
+		return;
+	}
+
+
+	// Helpers may not start until after every index is done (e.g. When called from inside another ParallelFor),
+	// so only wait on the indices, and let any late helpers find nothing left to do
+	struct SharedState
+	{
+		std::atomic<uint32> nextIndex;
+		uint32 remaining;
+		std::mutex mutex;
+		std::condition_variable finished;
+	};
+	std::shared_ptr<SharedState> state = std::make_shared<SharedState>();
+	state->nextIndex = 0;
+	state->remaining = count;
+
+	// Every participant keeps taking the next index until there are none left
+	// (func is only touched while an index is held, so it's still alive for any helper which gets one)
+	const std::function<void(uint32)>* funcPtr = &func;
+	const uint32 total = count;
+	auto drain = [state, funcPtr, total]()
+	{
+		uint32 processed = 0;
+		for (uint32 i = state->nextIndex++; i < total; i = state->nextIndex++)
+		{
+			(*funcPtr)(i);
+			++processed;
+		}
+
+		if (processed != 0)
+		{
+			std::lock_guard<std::mutex> lock(state->mutex);
+			state->remaining -= processed;
+			if (state->remaining == 0)
+				state->finished.notify_all();
+		}
+	};
+
+	const uint32 helperCount = glm::min(GetWorkerCount(), count - 1);
+	for (uint32 i = 0; i < helperCount; ++i)
+		Enqueue(drain);
+
+	// Help out, rather than just waiting
+	drain();
+
+	std::unique_lock<std::mutex> lock(state->mutex);
+	state->finished.wait(lock, [&state]() { return state->remaining == 0; });
+}
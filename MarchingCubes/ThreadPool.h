@@ -0,0 +1,64 @@
+#pragma once
+#include "Common.h"
+
+#include <vector>
+#include <deque>
+#include <functional>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+
+
+/**
+* Pool of worker threads which jobs can be handed to
+* NOTE: Jobs must not touch anything GL related, as the context only exists on the main thread
+*/
+class ThreadPool
+{
+private:
+	///
+	/// Worker vars
+	///
+	std::vector<std::thread> m_workers;
+	std::deque<std::function<void()>> m_jobs;
+	std::mutex m_mutex;
+	std::condition_variable m_jobAvailable;
+	bool bIsShuttingDown = false;
+
+public:
+	/**
+	* Create a pool with this many workers
+	* @param workerCount		How many worker threads to spawn (0 uses one less than the hardware thread count)
+	*/
+	ThreadPool(uint32 workerCount = 0);
+	~ThreadPool();
+
+	/**
+	* Queue this job to be ran on the next available worker
+	* @param job				The job to run
+	*/
+	void Enqueue(std::function<void()> job);
+
+	/**
+	* Run this function for every index in [0, count) across the workers and the calling thread
+	* Blocks until every index has been processed (Safe to call from inside another job, as the caller will process every index itself if no workers are free)
+	* @param count				How many indices to process
+	* @param func				The function to call for each index
+	*/
+	void ParallelFor(const uint32& count, const std::function<void(uint32)>& func);
+
+	/**
+	* The pool which is shared by everything in the engine
+	*/
+	static ThreadPool& GetShared();
+
+private:
+	/** Main loop for each worker */
+	void WorkerLoop();
+
+	///
+	/// Getters & Setters
+	///
+public:
+	inline uint32 GetWorkerCount() const { return m_workers.size(); }
+};
@@ -0,0 +1,214 @@
+///
+/// Lookup table for transition cells, which stitch the face of a coarse cell onto the finer cells on the other side of it
+/// Based on the transition cells from Eric Lengyel's Transvoxel algorithm: http://transvoxel.org/
+/// (Rather than copying the published tables, every case is worked out at compile time from the face's samples, so the
+/// edges always line up with MC::Cases on both sides. The cell has no width, so its triangles lie flat in the face)
+///
+#pragma once
+#include "Common.h"
+
+
+namespace MC
+{
+	/**
+	* Samples on a transition face (u runs right, v runs up)
+	* 6 7 8
+	* 3 4 5
+	* 0 1 2
+	* The coarse cell only uses the corners (0, 2, 6, 8), whilst the fine cells use all 9
+	* Sample i is inside (Above the iso level) if bit i of the case index is set
+	*/
+	static constexpr uint32 TransitionCaseCount = 512;
+
+	/// The most vertices a transition case can use (0-5 are on the fine u edges, 6-11 on the fine v edges, then the coarse Bottom, Top, Left, Right edges)
+	static constexpr uint32 TransitionVertexCount = 16;
+
+	/// The most triangles a transition case can build
+	static constexpr uint32 TransitionMaxTriangles = 9;
+
+	/// Which samples each vertex lies between (Lowest first)
+	static constexpr uint8 TransitionVertexSamples[TransitionVertexCount][2] =
+	{
+		{ 0, 1 }, { 1, 2 }, { 3, 4 }, { 4, 5 }, { 6, 7 }, { 7, 8 },
+		{ 0, 3 }, { 1, 4 }, { 2, 5 }, { 3, 6 }, { 4, 7 }, { 5, 8 },
+		{ 0, 2 }, { 6, 8 }, { 0, 6 }, { 2, 8 }
+	};
+
+	/// Each square which gets marched, as its corners and the vertex on the edge following each corner (Counter-clockwise)
+	/// The 4 fine squares come first, followed by the coarse square
+	static constexpr uint8 TransitionSquares[5][2][4] =
+	{
+		{ { 0, 1, 4, 3 }, { 0, 7, 2, 6 } },
+		{ { 1, 2, 5, 4 }, { 1, 8, 3, 7 } },
+		{ { 3, 4, 7, 6 }, { 2, 10, 4, 9 } },
+		{ { 4, 5, 8, 7 }, { 3, 11, 5, 10 } },
+		{ { 0, 2, 8, 6 }, { 12, 15, 13, 14 } }
+	};
+
+	/// Each border of the face, as its samples (Start, middle, end), the 2 fine vertices along it and then the coarse vertex
+	static constexpr uint8 TransitionBorders[4][6] =
+	{
+		{ 0, 1, 2, 0, 1, 12 },
+		{ 6, 7, 8, 4, 5, 13 },
+		{ 0, 3, 6, 6, 9, 14 },
+		{ 2, 5, 8, 8, 11, 15 }
+	};
+
+
+	/**
+	* The triangles to build for a transition case (As indices into the case's vertices)
+	*/
+	struct TransitionCase
+	{
+		uint8 triangleCount;
+		uint8 triangles[TransitionMaxTriangles][3];
+	};
+
+	/**
+	* Every transition case, which is worked out from the tables above at compile time
+	*/
+	struct TransitionTable
+	{
+		TransitionCase cases[TransitionCaseCount];
+		bool bIsValid; // Did every case's outlines join up into loops
+	};
+
+	/**
+	* Work out the triangles for every transition case
+	* The fine outline (From marching the 4 fine squares) and the coarse outline (From marching the coarse square) only differ
+	* where the coarse cell has missed some detail, so the cell fills the area between them
+	* Both outlines are walked so the area being filled is on the left, then joined along the borders into loops, which are fanned
+	* (Fine areas which are inside wind one way and coarse areas which are inside wind the other, so both face out of the surface)
+	*/
+	constexpr TransitionTable BuildTransitionTable()
+	{
+		TransitionTable table = {};
+		table.bIsValid = true;
+
+		const uint8 none = 0xFF;
+
+		for (uint32 c = 0; c < TransitionCaseCount; ++c)
+		{
+			uint8 next[TransitionVertexCount] = {};
+			uint8 incoming[TransitionVertexCount] = {};
+			for (uint32 v = 0; v < TransitionVertexCount; ++v)
+				next[v] = none;
+
+			// Outline each square so the inside is on the left (Or on the right, for the coarse square)
+			// A contour leaves through the edge after an inside corner, and joins onto the closest edge before that which it could
+			// enter through (So ambiguous squares keep their inside corners apart, as MC::Cases does when few corners are inside)
+			for (uint32 s = 0; s < 5; ++s)
+			{
+				const uint8 (&corners)[4] = TransitionSquares[s][0];
+				const uint8 (&edges)[4] = TransitionSquares[s][1];
+
+				for (uint32 k = 0; k < 4; ++k)
+				{
+					const bool isInside = ((c >> corners[k]) & 1) != 0;
+					const bool nextInside = ((c >> corners[(k + 1) % 4]) & 1) != 0;
+					if (!isInside || nextInside)
+						continue;
+
+					for (uint32 j = 1; j < 4; ++j)
+					{
+						const uint32 e = (k + 4 - j) % 4;
+						if (((c >> corners[e]) & 1) == 0 && ((c >> corners[(e + 1) % 4]) & 1) != 0)
+						{
+							if (s == 4)
+								next[edges[e]] = edges[k];
+							else
+								next[edges[k]] = edges[e];
+							break;
+						}
+					}
+				}
+			}
+
+			// Join the outlines where they meet each border
+			for (uint32 b = 0; b < 4; ++b)
+			{
+				const bool startInside = ((c >> TransitionBorders[b][0]) & 1) != 0;
+				const bool middleInside = ((c >> TransitionBorders[b][1]) & 1) != 0;
+				const bool endInside = ((c >> TransitionBorders[b][2]) & 1) != 0;
+
+				uint8 p = none;
+				uint8 q = none;
+				if (startInside != endInside)
+				{
+					p = TransitionBorders[b][5];
+					q = (startInside != middleInside ? TransitionBorders[b][3] : TransitionBorders[b][4]);
+				}
+				else if (startInside != middleInside)
+				{
+					p = TransitionBorders[b][3];
+					q = TransitionBorders[b][4];
+				}
+				else
+					continue;
+
+				if (next[p] == none)
+					next[p] = q;
+				else
+					next[q] = p;
+			}
+
+			// Every vertex on an outline must now be in exactly one loop
+			for (uint32 v = 0; v < TransitionVertexCount; ++v)
+				if (next[v] != none)
+					++incoming[next[v]];
+
+			for (uint32 v = 0; v < TransitionVertexCount; ++v)
+			{
+				const uint8 a = TransitionVertexSamples[v][0];
+				const uint8 b = TransitionVertexSamples[v][1];
+				const bool isIntersected = (((c >> a) & 1) != ((c >> b) & 1));
+
+				if ((next[v] != none) != isIntersected || incoming[v] != (isIntersected ? 1 : 0))
+					table.bIsValid = false;
+			}
+
+			if (!table.bIsValid)
+				continue;
+
+			// Fan each loop
+			TransitionCase& out = table.cases[c];
+			bool visited[TransitionVertexCount] = {};
+
+			for (uint32 v = 0; v < TransitionVertexCount; ++v)
+			{
+				if (next[v] == none || visited[v])
+					continue;
+
+				visited[v] = true;
+				uint8 previous = next[v];
+				visited[previous] = true;
+
+				for (uint8 current = next[previous]; current != v; current = next[current])
+				{
+					if (out.triangleCount == TransitionMaxTriangles)
+					{
+						table.bIsValid = false;
+						break;
+					}
+
+					out.triangles[out.triangleCount][0] = (uint8)v;
+					out.triangles[out.triangleCount][1] = previous;
+					out.triangles[out.triangleCount][2] = current;
+					++out.triangleCount;
+
+					visited[current] = true;
+					previous = current;
+				}
+			}
+		}
+
+		return table;
+	}
+
+	static constexpr TransitionTable TransitionCells = BuildTransitionTable();
+	static_assert(TransitionCells.bIsValid, "MC::TransitionCells couldn't be built for every case");
+
+
+	/** The triangles to build for this transition case */
+	constexpr const TransitionCase& GetTransitionCase(const uint32& caseIndex) { return TransitionCells.cases[caseIndex]; }
+}
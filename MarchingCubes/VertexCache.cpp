@@ -0,0 +1,281 @@
+#include "VertexCache.h"
+#include <algorithm>
+
+
+float VertexCache::CalculateACMR(const std::vector<uint32>& indices, const uint32& vertexCount, const uint32& cacheSize)
+{
+	const uint32 triangleCount = indices.size() / 3;
+	if (triangleCount == 0)
+		return 0.0f;
+
+	// A vertex is still in the FIFO if fewer than cacheSize misses have happened since it was added
+	std::vector<uint32> addedAt(vertexCount, 0);
+	uint32 misses = 0;
+
+	for (const uint32& index : indices)
+		if (addedAt[index] == 0 || misses - addedAt[index] + 1 > cacheSize)
+		{
+			misses++;
+			addedAt[index] = misses;
+		}
+
+	return (float)misses / (float)triangleCount;
+}
+
+void VertexCache::OptimiseTriangleOrder(std::vector<uint32>& indices, const uint32& vertexCount, const uint32& cacheSize, std::vector<uint32>* outClusters)
+{
+	const uint32 triangleCount = indices.size() / 3;
+	if (outClusters)
+		outClusters->clear();
+	if (triangleCount == 0)
+		return;
+
+
+	// Find which triangles use each vertex (Packed into a single array)
+	std::vector<uint32> liveCount(vertexCount, 0);
+	for (const uint32& index : indices)
+		liveCount[index]++;
+
+	std::vector<uint32> adjacencyStart(vertexCount + 1, 0);
+	for (uint32 v = 0; v < vertexCount; ++v)
+		adjacencyStart[v + 1] = adjacencyStart[v] + liveCount[v];
+
+	std::vector<uint32> adjacency(indices.size());
+	std::vector<uint32> adjacencyFill(adjacencyStart.begin(), adjacencyStart.end() - 1);
+	for (uint32 i = 0; i < indices.size(); ++i)
+		adjacency[adjacencyFill[indices[i]]++] = i / 3;
+
+
+	std::vector<uint32> output;
+	output.reserve(indices.size());
+	std::vector<uint8> emitted(triangleCount, 0);
+	std::vector<uint32> cacheTime(vertexCount, 0);
+	std::vector<uint32> deadEnds;
+	std::vector<uint32> candidates;
+
+	uint32 time = cacheSize + 1;
+	uint32 nextInputVertex = 0;
+	int64 fanVertex = 0;
+
+	if (outClusters)
+		outClusters->push_back(0);
+
+	while (fanVertex >= 0)
+	{
+		// Emit every triangle around this vertex which hasn't already been emitted
+		candidates.clear();
+		for (uint32 i = adjacencyStart[fanVertex]; i < adjacencyStart[fanVertex + 1]; ++i)
+		{
+			const uint32 t = adjacency[i];
+			if (emitted[t])
+				continue;
+
+			for (uint32 c = 0; c < 3; ++c)
+			{
+				const uint32 v = indices[t * 3 + c];
+				output.push_back(v);
+				deadEnds.push_back(v);
+				candidates.push_back(v);
+				liveCount[v]--;
+
+				if (time - cacheTime[v] > cacheSize)
+				{
+					cacheTime[v] = time;
+					time++;
+				}
+			}
+			emitted[t] = 1;
+		}
+
+
+		// Fan around whichever just used vertex will still be in the cache for the longest, once all of its triangles are emitted
+		fanVertex = -1;
+		int64 bestPriority = -1;
+		for (const uint32& v : candidates)
+		{
+			if (liveCount[v] == 0)
+				continue;
+
+			int64 priority = 0;
+			if (time - cacheTime[v] + 2 * liveCount[v] <= cacheSize)
+				priority = time - cacheTime[v];
+
+			if (priority > bestPriority)
+			{
+				bestPriority = priority;
+				fanVertex = v;
+			}
+		}
+
+		if (fanVertex != -1)
+			continue;
+
+
+		// Dead end, so try a recently used vertex or carry on through the input order
+		while (!deadEnds.empty() && fanVertex == -1)
+		{
+			const uint32 v = deadEnds.back();
+			deadEnds.pop_back();
+			if (liveCount[v] != 0)
+				fanVertex = v;
+		}
+
+		while (fanVertex == -1 && nextInputVertex < vertexCount)
+		{
+			if (liveCount[nextInputVertex] != 0)
+				fanVertex = nextInputVertex;
+			nextInputVertex++;
+		}
+
+		// Jumping away from the fan will flush the cache, so start a new cluster
+		if (fanVertex != -1 && outClusters)
+			outClusters->push_back(output.size() / 3);
+	}
+
+	indices.swap(output);
+}
+
+void VertexCache::OptimiseOverdraw(std::vector<uint32>& indices, const std::vector<vec3>& vertices, const std::vector<uint32>& clusters, const uint32& cacheSize, const float& threshold)
+{
+	const uint32 triangleCount = indices.size() / 3;
+	if (triangleCount == 0 || clusters.empty())
+		return;
+
+
+	// Split the clusters wherever their ACMR has dropped to the threshold
+	// (Every cluster may end up anywhere once sorted, so each is measured starting from a flushed cache)
+	std::vector<uint32> splits;
+	splits.reserve(clusters.size());
+	std::vector<uint32> addedAt(vertices.size(), 0);
+	uint32 misses = 0;
+
+	for (uint32 c = 0; c < clusters.size(); ++c)
+	{
+		const uint32 clusterEnd = (c + 1 < clusters.size() ? clusters[c + 1] : triangleCount);
+		uint32 splitStart = clusters[c];
+		uint32 splitMisses = 0;
+		splits.push_back(splitStart);
+
+		// Cache was flushed at this hard boundary
+		misses += cacheSize + 1;
+
+		for (uint32 t = clusters[c]; t < clusterEnd; ++t)
+		{
+			for (uint32 i = 0; i < 3; ++i)
+			{
+				const uint32 index = indices[t * 3 + i];
+				if (addedAt[index] == 0 || misses - addedAt[index] + 1 > cacheSize)
+				{
+					misses++;
+					splitMisses++;
+					addedAt[index] = misses;
+				}
+			}
+
+			if (t + 1 < clusterEnd && (float)splitMisses <= threshold * (float)(t + 1 - splitStart))
+			{
+				splitStart = t + 1;
+				splitMisses = 0;
+				splits.push_back(splitStart);
+				misses += cacheSize + 1;
+			}
+		}
+	}
+
+
+	// Work out where each cluster sits and which way it faces (Weighted by the area of each triangle)
+	std::vector<vec3> clusterCentres(splits.size(), vec3(0.0f));
+	std::vector<vec3> clusterNormals(splits.size(), vec3(0.0f));
+	std::vector<float> clusterAreas(splits.size(), 0.0f);
+	vec3 meshCentre(0.0f);
+	float meshArea = 0.0f;
+
+	for (uint32 c = 0; c < splits.size(); ++c)
+	{
+		const uint32 clusterEnd = (c + 1 < splits.size() ? splits[c + 1] : triangleCount);
+		for (uint32 t = splits[c]; t < clusterEnd; ++t)
+		{
+			const vec3& a = vertices[indices[t * 3 + 0]];
+			const vec3& b = vertices[indices[t * 3 + 1]];
+			const vec3& d = vertices[indices[t * 3 + 2]];
+
+			const vec3 normal = glm::cross(b - a, d - a);
+			const float area = glm::length(normal);
+			const vec3 centre = (a + b + d) * (area / 3.0f);
+
+			clusterCentres[c] += centre;
+			clusterNormals[c] += normal;
+			clusterAreas[c] += area;
+			meshCentre += centre;
+			meshArea += area;
+		}
+	}
+
+	if (meshArea != 0.0f)
+		meshCentre /= meshArea;
+
+
+	// Draw the clusters facing out from the centre first, as they are the most likely to cover up the others
+	std::vector<float> clusterSort(splits.size(), 0.0f);
+	std::vector<uint32> order(splits.size());
+	for (uint32 c = 0; c < splits.size(); ++c)
+	{
+		order[c] = c;
+		const float normalLength = glm::length(clusterNormals[c]);
+		if (clusterAreas[c] != 0.0f && normalLength != 0.0f)
+			clusterSort[c] = glm::dot(clusterCentres[c] / clusterAreas[c] - meshCentre, clusterNormals[c] / normalLength);
+	}
+
+	std::stable_sort(order.begin(), order.end(), [&clusterSort](const uint32& a, const uint32& b) { return clusterSort[a] > clusterSort[b]; });
+
+
+	std::vector<uint32> output;
+	output.reserve(indices.size());
+	for (const uint32& c : order)
+	{
+		const uint32 clusterEnd = (c + 1 < splits.size() ? splits[c + 1] : triangleCount);
+		output.insert(output.end(), indices.begin() + splits[c] * 3, indices.begin() + clusterEnd * 3);
+	}
+
+	indices.swap(output);
+}
+
+void VertexCache::OptimiseVertexFetch(std::vector<vec3>& vertices, std::vector<vec3>& normals, std::vector<uint32>& indices)
+{
+	std::vector<uint32> remap(vertices.size(), ~0U);
+	std::vector<vec3> newVertices;
+	std::vector<vec3> newNormals;
+	newVertices.reserve(vertices.size());
+	newNormals.reserve(normals.size());
+
+	for (uint32& index : indices)
+	{
+		uint32& newIndex = remap[index];
+		if (newIndex == ~0U)
+		{
+			newIndex = newVertices.size();
+			newVertices.push_back(vertices[index]);
+			newNormals.push_back(normals[index]);
+		}
+
+		index = newIndex;
+	}
+
+	vertices.swap(newVertices);
+	normals.swap(newNormals);
+}
+
+VertexCacheStats VertexCache::Optimise(std::vector<vec3>& vertices, std::vector<vec3>& normals, std::vector<uint32>& indices, const uint32& cacheSize)
+{
+	VertexCacheStats stats;
+	stats.triangleCount = indices.size() / 3;
+	stats.acmrBefore = CalculateACMR(indices, vertices.size(), cacheSize);
+
+	std::vector<uint32> clusters;
+	OptimiseTriangleOrder(indices, vertices.size(), cacheSize, &clusters);
+	OptimiseOverdraw(indices, vertices, clusters, cacheSize);
+	OptimiseVertexFetch(vertices, normals, indices);
+
+	stats.acmrAfter = CalculateACMR(indices, vertices.size(), cacheSize);
+	return stats;
+}
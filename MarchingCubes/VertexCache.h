@@ -0,0 +1,77 @@
+#pragma once
+#include "Common.h"
+#include <vector>
+
+
+/**
+* How well a mesh uses the post-transform vertex cache, before and after being optimised
+* (Average cache miss ratio is the number of vertices transformed per triangle: 3 is the worst, ~0.5 is the best possible)
+*/
+struct VertexCacheStats
+{
+	float acmrBefore = 0.0f;
+	float acmrAfter = 0.0f;
+	uint32 triangleCount = 0;
+};
+
+
+/**
+* Reordering of mesh data to suit the GPU, so fewer vertices are transformed and the vertex buffer is read in order
+*/
+namespace VertexCache
+{
+	/// Number of vertices the simulated cache holds (Roughly what most GPUs manage to reuse)
+	const uint32 DefaultCacheSize = 16;
+
+	/// Clusters are split once their ACMR drops to this, so smaller clusters can be sorted for overdraw without losing much cache reuse
+	const float DefaultOverdrawThreshold = 0.65f;
+
+	/**
+	* Simulate a FIFO vertex cache running over these triangles
+	* @param indices			Every 3 indices make up a triangle
+	* @param vertexCount		How many vertices the indices refer to
+	* @param cacheSize			How many vertices the cache holds
+	* @returns The average cache miss ratio (Misses per triangle)
+	*/
+	float CalculateACMR(const std::vector<uint32>& indices, const uint32& vertexCount, const uint32& cacheSize = DefaultCacheSize);
+
+	/**
+	* Reorder the triangles so recently used vertices are likely to still be in the cache (Tipsify, Sander et al. 2007)
+	* Runs in linear time, fanning around each vertex in turn and picking the next vertex from those which were just used
+	* @param indices			Every 3 indices make up a triangle (Reordered in place)
+	* @param vertexCount		How many vertices the indices refer to
+	* @param cacheSize			How many vertices the cache holds
+	* @param outClusters		If set, filled with the first triangle after every point the cache was flushed (Where the fan had to jump elsewhere)
+	*/
+	void OptimiseTriangleOrder(std::vector<uint32>& indices, const uint32& vertexCount, const uint32& cacheSize = DefaultCacheSize, std::vector<uint32>* outClusters = nullptr);
+
+	/**
+	* Reorder clusters of triangles so the ones most likely to hide the rest are drawn first (Sander et al. 2007)
+	* Clusters are split further where their ACMR is already low, then sorted by how far they face away from the mesh's centre
+	* @param indices			Every 3 indices make up a triangle (Reordered in place)
+	* @param vertices			The positions of each vertex
+	* @param clusters			The first triangle of every cluster, as output by OptimiseTriangleOrder
+	* @param cacheSize			How many vertices the cache holds
+	* @param threshold			The ACMR a cluster must reach before it is split
+	*/
+	void OptimiseOverdraw(std::vector<uint32>& indices, const std::vector<vec3>& vertices, const std::vector<uint32>& clusters, const uint32& cacheSize = DefaultCacheSize, const float& threshold = DefaultOverdrawThreshold);
+
+	/**
+	* Reorder the vertices into the order the triangles first use them, so the vertex buffer is read in order
+	* (Any vertices which aren't used by a triangle are removed)
+	* @param vertices			The positions of each vertex
+	* @param normals			The normals of each vertex
+	* @param indices			Every 3 indices make up a triangle
+	*/
+	void OptimiseVertexFetch(std::vector<vec3>& vertices, std::vector<vec3>& normals, std::vector<uint32>& indices);
+
+	/**
+	* Run all of the optimisations over this mesh
+	* @param vertices			The positions of each vertex
+	* @param normals			The normals of each vertex
+	* @param indices			Every 3 indices make up a triangle
+	* @param cacheSize			How many vertices the cache holds
+	* @returns The cache miss ratio before and after
+	*/
+	VertexCacheStats Optimise(std::vector<vec3>& vertices, std::vector<vec3>& normals, std::vector<uint32>& indices, const uint32& cacheSize = DefaultCacheSize);
+}
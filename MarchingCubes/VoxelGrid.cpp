@@ -0,0 +1,44 @@
+#include "VoxelGrid.h"
+
+
+const uint32 VoxelGrid::s_brickSpread[1 << BrickShift] = { 0, 1, 8, 9, 64, 65, 72, 73 };
+const uint32 VoxelGrid::s_axisBits[3] = { 0x49, 0x92, 0x124 };
+
+
+void VoxelGrid::Init(const uvec3& resolution, const VoxelLayout& layout, const VoxelSample& value)
+{
+	m_resolution = resolution;
+	m_layout = layout;
+
+	if (m_layout == VoxelLayout::Linear)
+	{
+		m_axisStride[0] = 1;
+		m_axisStride[1] = resolution.x;
+		m_axisStride[2] = resolution.x * resolution.y;
+		m_samples.assign(resolution.x * resolution.y * resolution.z, value);
+	}
+	else
+	{
+		// Strides are in whole bricks
+		const uvec3 brickCount = (resolution + uvec3(BrickMask, BrickMask, BrickMask)) / (uint32)(1 << BrickShift);
+		m_axisStride[0] = 1 << (BrickShift * 3);
+		m_axisStride[1] = m_axisStride[0] * brickCount.x;
+		m_axisStride[2] = m_axisStride[1] * brickCount.y;
+		m_samples.assign(m_axisStride[2] * brickCount.z, value);
+	}
+}
+
+const VoxelSample* VoxelGrid::GetRow(const uint32& y, const uint32& z, VoxelSample* scratch) const
+{
+	uint32 index = GetIndex(0, y, z);
+	if (m_layout == VoxelLayout::Linear)
+		return m_samples.data() + index;
+
+	for (uint32 x = 0; x < m_resolution.x; ++x)
+	{
+		scratch[x] = m_samples[index];
+		if (x + 1 < m_resolution.x)
+			index = Step(index, 0);
+	}
+	return scratch;
+}
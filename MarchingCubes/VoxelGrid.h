@@ -0,0 +1,104 @@
+#pragma once
+#include "Common.h"
+#include "VoxelSample.h"
+
+#include <vector>
+
+
+/**
+* How the voxels in a grid are laid out in memory
+*/
+enum class VoxelLayout : uint8
+{
+	Linear = 0,	// x + res.x * (y + res.y * z)
+	Morton		// Z-order within 8x8x8 bricks and the bricks stored linearly (So resolutions only pad out to a multiple of 8)
+};
+
+
+/**
+* Dense grid of voxel samples, which hides the memory layout behind its accessors
+*/
+class VoxelGrid
+{
+public:
+	/// Bricks are 2^BrickShift voxels along each axis
+	static const uint32 BrickShift = 3;
+	static const uint32 BrickMask = (1 << BrickShift) - 1;
+	static const uint32 BrickVoxelMask = (1 << (BrickShift * 3)) - 1;
+
+private:
+	std::vector<VoxelSample> m_samples;
+	uvec3 m_resolution;
+	VoxelLayout m_layout = VoxelLayout::Linear;
+
+	/// How far the index moves when stepping +1 along each axis (Across a brick boundary, for Morton)
+	uint32 m_axisStride[3];
+
+public:
+	/**
+	* Allocate the grid, setting every voxel to this value
+	* @param resolution			The resolution of the grid
+	* @param layout				How to lay the voxels out in memory
+	* @param value				The value to fill the grid with
+	*/
+	void Init(const uvec3& resolution, const VoxelLayout& layout, const VoxelSample& value);
+
+	/**
+	* Get the index of this voxel in the storage
+	* @param x,y,z				The coordinate of the voxel
+	*/
+	inline uint32 GetIndex(const uint32& x, const uint32& y, const uint32& z) const
+	{
+		if (m_layout == VoxelLayout::Linear)
+			return x + m_resolution.x * (y + m_resolution.y * z);
+
+		const uint32 brick = (x >> BrickShift) * m_axisStride[0] + (y >> BrickShift) * m_axisStride[1] + (z >> BrickShift) * m_axisStride[2];
+		return brick | s_brickSpread[x & BrickMask] | (s_brickSpread[y & BrickMask] << 1) | (s_brickSpread[z & BrickMask] << 2);
+	}
+
+	/**
+	* Get the index of the voxel 1 step along this axis, without re-encoding the coordinate
+	* (The neighbour must be inside of the grid)
+	* @param index				The index of the current voxel
+	* @param axis				The axis to step along (0-x, 1-y, 2-z)
+	*/
+	inline uint32 Step(const uint32& index, const uint32& axis) const
+	{
+		if (m_layout == VoxelLayout::Linear)
+			return index + m_axisStride[axis];
+
+		// Increment only the bits belonging to this axis, by filling the other bits so the carry skips over them
+		const uint32 axisBits = s_axisBits[axis];
+		const uint32 local = index & BrickVoxelMask;
+		if ((local & axisBits) == axisBits)
+			return ((index & ~BrickVoxelMask) + m_axisStride[axis]) | (local & ~axisBits); // Wrap into the next brick
+
+		return (index & ~BrickVoxelMask) | (((local | ~axisBits) + 1) & axisBits) | (local & ~axisBits);
+	}
+
+	/**
+	* Get a row of voxels running along x
+	* @param y,z				The coordinate of the row
+	* @param scratch			Where to copy the row, if it isn't contiguous in memory (Must hold resolution.x samples)
+	* @returns The samples for the row
+	*/
+	const VoxelSample* GetRow(const uint32& y, const uint32& z, VoxelSample* scratch) const;
+
+	inline VoxelSample& operator[](const uint32& index) { return m_samples[index]; }
+	inline const VoxelSample& operator[](const uint32& index) const { return m_samples[index]; }
+
+	inline VoxelSample Get(const uint32& x, const uint32& y, const uint32& z) const { return m_samples[GetIndex(x, y, z)]; }
+	inline void Set(const uint32& x, const uint32& y, const uint32& z, const VoxelSample& sample) { m_samples[GetIndex(x, y, z)] = sample; }
+
+	inline VoxelLayout GetLayout() const { return m_layout; }
+	inline uvec3 GetResolution() const { return m_resolution; }
+
+	/** How many bytes are being used to store the samples */
+	inline uint64 GetStorageSize() const { return m_samples.size() * sizeof(VoxelSample); }
+
+private:
+	/// Spreads the bits of a brick-local coordinate out, so there are 2 empty bits between each
+	static const uint32 s_brickSpread[1 << BrickShift];
+	/// The bits of a brick-local index which belong to each axis
+	static const uint32 s_axisBits[3];
+};
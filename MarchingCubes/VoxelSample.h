@@ -0,0 +1,157 @@
+///
+/// Storage formats for a single voxel sample
+/// Volumes store every voxel as a VoxelSample, which can be picked at compile time by defining VOXEL_SAMPLE_TYPE
+/// as float, uint8, uint16 or VoxelHalf (The quantized formats store values in the range [0-1])
+///
+#pragma once
+#include "Common.h"
+#include "MarchingCubesKernel.h"
+
+#include <cmath>
+#include <cstring>
+
+
+/**
+* 16-bit floating point value (IEEE 754 half precision)
+*/
+struct VoxelHalf
+{
+	uint16 bits;
+
+	inline bool operator==(const VoxelHalf& other) const { return bits == other.bits; }
+	inline bool operator!=(const VoxelHalf& other) const { return bits != other.bits; }
+
+	/** Convert a float to the nearest half */
+	static inline VoxelHalf FromFloat(const float& value)
+	{
+		uint32 f;
+		std::memcpy(&f, &value, sizeof(f));
+
+		const uint32 sign = (f >> 16) & 0x8000;
+		const int32 exponent = (int32)((f >> 23) & 0xFF) - 127 + 15;
+		uint32 mantissa = f & 0x7FFFFF;
+
+		VoxelHalf half;
+		if (exponent <= 0)
+		{
+			// Too small for a normal half, so store as subnormal (Or 0)
+			if (exponent < -10)
+				half.bits = (uint16)sign;
+			else
+			{
+				mantissa |= 0x800000;
+				const uint32 shift = 14 - exponent;
+				half.bits = (uint16)(sign | ((mantissa + (1 << (shift - 1))) >> shift));
+			}
+		}
+		else if (exponent >= 31)
+			half.bits = (uint16)(sign | 0x7C00); // Too large, so clamp to infinity
+		else
+			half.bits = (uint16)(sign | (exponent << 10)) + (uint16)((mantissa + 0x1000) >> 13); // Carry from rounding correctly bumps the exponent
+		return half;
+	}
+
+	/** Convert this half back to a float */
+	inline float ToFloat() const
+	{
+		const uint32 sign = (uint32)(bits & 0x8000) << 16;
+		const uint32 exponent = (bits >> 10) & 0x1F;
+		const uint32 mantissa = bits & 0x3FF;
+
+		float value;
+		if (exponent == 0)
+			value = std::ldexp((float)mantissa, -24); // Subnormal
+		else if (exponent == 31)
+			value = mantissa == 0 ? INFINITY : NAN;
+		else
+		{
+			const uint32 f = ((exponent + 127 - 15) << 23) | (mantissa << 13);
+			std::memcpy(&value, &f, sizeof(value));
+		}
+		return sign != 0 ? -value : value;
+	}
+};
+
+
+/**
+* Describes how a type stores a voxel sample
+* Samples are converted into a linear "kernel domain" for MC, so the iso compares and edge interpolation can
+* run directly on the stored values, rather than having to decode each one to a float first
+*/
+template<typename T>
+struct VoxelSampleTraits;
+
+template<>
+struct VoxelSampleTraits<float>
+{
+	static inline float Encode(const float& value) { return value; }
+	static inline float Decode(const float& sample) { return sample; }
+
+	static inline float ToKernel(const float& sample) { return sample; }
+	static inline float KernelIso(const float& isoLevel) { return isoLevel; }
+
+	static inline uint32 ClassifyRow(const float* row00, const float* row01, const float* row10, const float* row11, const uint32& count, const float& isoLevel, uint8* outCases)
+	{
+		return MC::ClassifyCellRow(row00, row01, row10, row11, count, isoLevel, outCases);
+	}
+};
+
+/**
+* Unsigned normalized integer samples, where 0 is 0.0 and the max value is 1.0
+*/
+template<typename T, uint32 MaxValue>
+struct VoxelSampleTraitsUNorm
+{
+	static inline T Encode(const float& value) { return (T)(glm::clamp(value, 0.0f, 1.0f) * MaxValue + 0.5f); }
+	static inline float Decode(const T& sample) { return sample * (1.0f / MaxValue); }
+
+	static inline float ToKernel(const T& sample) { return (float)sample; }
+	static inline float KernelIso(const float& isoLevel) { return isoLevel * MaxValue; }
+
+	static inline uint32 ClassifyRow(const T* row00, const T* row01, const T* row10, const T* row11, const uint32& count, const float& isoLevel, uint8* outCases)
+	{
+		// The smallest sample which is considered inside (MaxValue + 1 if nothing is)
+		const float threshold = glm::clamp(std::ceil(KernelIso(isoLevel)), 0.0f, MaxValue + 1.0f);
+		return MC::ClassifyCellRow(row00, row01, row10, row11, count, (uint32)threshold, outCases);
+	}
+};
+
+template<>
+struct VoxelSampleTraits<uint8> : public VoxelSampleTraitsUNorm<uint8, 255> {};
+
+template<>
+struct VoxelSampleTraits<uint16> : public VoxelSampleTraitsUNorm<uint16, 65535> {};
+
+template<>
+struct VoxelSampleTraits<VoxelHalf>
+{
+	static inline VoxelHalf Encode(const float& value) { return VoxelHalf::FromFloat(value); }
+	static inline float Decode(const VoxelHalf& sample) { return sample.ToFloat(); }
+
+	static inline float ToKernel(const VoxelHalf& sample) { return sample.ToFloat(); }
+	static inline float KernelIso(const float& isoLevel) { return isoLevel; }
+
+	static inline uint32 ClassifyRow(const VoxelHalf* row00, const VoxelHalf* row01, const VoxelHalf* row10, const VoxelHalf* row11, const uint32& count, const float& isoLevel, uint8* outCases)
+	{
+		// Positive halves are ordered the same as their bits, so classify using the bits of the smallest half which is inside
+		VoxelHalf threshold = VoxelHalf::FromFloat(glm::max(isoLevel, 0.0f));
+		if (threshold.ToFloat() < isoLevel)
+			threshold.bits++;
+
+		return MC::ClassifyCellRow((const uint16*)row00, (const uint16*)row01, (const uint16*)row10, (const uint16*)row11, count, threshold.bits, outCases);
+	}
+};
+
+
+/// The type which every volume uses to store its voxels
+#ifndef VOXEL_SAMPLE_TYPE
+#define VOXEL_SAMPLE_TYPE float
+#endif
+
+typedef VOXEL_SAMPLE_TYPE VoxelSample;
+
+/** Convert a value into a sample for storing */
+inline VoxelSample EncodeVoxel(const float& value) { return VoxelSampleTraits<VoxelSample>::Encode(value); }
+
+/** Convert a stored sample back into a value */
+inline float DecodeVoxel(const VoxelSample& sample) { return VoxelSampleTraits<VoxelSample>::Decode(sample); }
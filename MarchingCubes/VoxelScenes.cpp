@@ -0,0 +1,86 @@
+#include "VoxelScenes.h"
+#include "PerlinNoise.h"
+
+
+void VoxelScenes::BuildSphere(IVoxelVolume* volume, const uint32& radius)
+{
+	const uint32 diametre = radius * 2;
+	volume->Init(uvec3(diametre, diametre, diametre), vec3(1, 1, 1));
+	volume->BeginBulkLoad();
+
+	std::vector<VoxelDelta> slice;
+	for (uint32 x = 0; x < diametre; ++x)
+	{
+		slice.clear();
+		for (uint32 y = 0; y < diametre; ++y)
+			for (uint32 z = 0; z < diametre; ++z)
+			{
+				float distance = glm::length(vec3(x, y, z) - vec3(radius, radius, radius));
+				float v = 1.0f - glm::clamp(distance / (float)radius, 0.0f, 1.0f);
+				slice.push_back(VoxelDelta{ uvec3(x, y, z), v });
+			}
+		volume->ApplyDeltas(slice);
+	}
+	volume->EndBulkLoad();
+}
+
+void VoxelScenes::BuildTorus(IVoxelVolume* volume, const uint32& ringRadius, const uint32& tubeRadius)
+{
+	const uint32 size = (tubeRadius + ringRadius) * 2;
+	volume->Init(uvec3(size, size, size), vec3(1, 1, 1));
+	volume->BeginBulkLoad();
+
+	std::vector<VoxelDelta> slice;
+	for (uint32 x = 0; x < size; ++x)
+	{
+		slice.clear();
+		for (uint32 y = 0; y < size; ++y)
+			for (uint32 z = 0; z < size; ++z)
+			{
+				ivec3 coord = ivec3(x - size / 2, y - size / 2, z - size / 2);
+
+				const float partA = (ringRadius - sqrt(coord.x*coord.x + coord.y*coord.y));
+				float distance = partA*partA + coord.z*coord.z;
+				float v = 1.0f - glm::clamp(distance / (float)(tubeRadius*tubeRadius), 0.0f, 1.0f);
+				slice.push_back(VoxelDelta{ uvec3(x, y, z), v });
+			}
+		volume->ApplyDeltas(slice);
+	}
+	volume->EndBulkLoad();
+}
+
+void VoxelScenes::BuildNoise(IVoxelVolume* volume, const uint32& size, const uint32& seed)
+{
+	PerlinNoise noise(seed);
+	volume->Init(uvec3(size, size, size), vec3(1, 1, 1));
+	volume->BeginBulkLoad();
+
+	// Leave border empty, so the surface is closed
+	std::vector<VoxelDelta> slice;
+	for (uint32 x = 1; x < size - 1; ++x)
+	{
+		slice.clear();
+		for (uint32 y = 1; y < size - 1; ++y)
+			for (uint32 z = 1; z < size - 1; ++z)
+				slice.push_back(VoxelDelta{ uvec3(x, y, z), noise.GetOctave(x * 0.04f, y * 0.04f, z * 0.04f, 3, 0.4f) * 0.27f });
+		volume->ApplyDeltas(slice);
+	}
+	volume->EndBulkLoad();
+}
+
+void VoxelScenes::BuildPlatform(IVoxelVolume* volume, const uint32& size)
+{
+	volume->Init(uvec3(size, size, size), vec3(1, 1, 1));
+	volume->BeginBulkLoad();
+
+	std::vector<VoxelDelta> platforms;
+	for (uint32 x = 0; x < size; ++x)
+		for (uint32 z = 0; z < size; ++z)
+		{
+			platforms.push_back(VoxelDelta{ uvec3(x, size - 1, z), 1.0f });
+			platforms.push_back(VoxelDelta{ uvec3(x, 7, z), 0.5f });
+			platforms.push_back(VoxelDelta{ uvec3(x, 0, z), 1.0f });
+		}
+	volume->ApplyDeltas(platforms);
+	volume->EndBulkLoad();
+}
@@ -0,0 +1,41 @@
+#pragma once
+#include "Common.h"
+#include "VoxelVolume.h"
+
+
+/**
+* Procedural scenes which can be used to fill a volume for testing
+* (Each of these will call Init on the volume before filling it)
+*/
+namespace VoxelScenes
+{
+	/**
+	* Fill the volume with a solid sphere
+	* @param volume				The volume to fill
+	* @param radius				The radius of the sphere
+	*/
+	void BuildSphere(IVoxelVolume* volume, const uint32& radius);
+
+	/**
+	* Fill the volume with a torus
+	* @param volume				The volume to fill
+	* @param ringRadius			The radius of the ring
+	* @param tubeRadius			The radius of the tube which makes up the ring
+	*/
+	void BuildTorus(IVoxelVolume* volume, const uint32& ringRadius, const uint32& tubeRadius);
+
+	/**
+	* Fill the volume with 3D perlin noise
+	* @param volume				The volume to fill
+	* @param size				The resolution to use for each axis
+	* @param seed				The seed to generate the noise with
+	*/
+	void BuildNoise(IVoxelVolume* volume, const uint32& size, const uint32& seed);
+
+	/**
+	* Fill the volume with a few flat platforms
+	* @param volume				The volume to fill
+	* @param size				The resolution to use for each axis
+	*/
+	void BuildPlatform(IVoxelVolume* volume, const uint32& size);
+}
@@ -4,6 +4,7 @@
 #include "PVM/ddsbase.h"
 
 #include <fstream>
+#include <algorithm>
 
 
 bool IVoxelVolume::LoadFromPvmFile(const char* file)
@@ -24,31 +25,71 @@ bool IVoxelVolume::LoadFromPvmFile(const char* file)
 
 	// Convert binary data into float data
 	Init(uvec3(width, height, depth), scale);
+	BeginBulkLoad();
+
+	// Apply a slice at a time, so the batch doesn't get too large
+	std::vector<VoxelDelta> slice;
+	slice.reserve(width * height);
 
 	uint8* data = volume;
 	for (uint32 z = 0; z < depth; ++z)
+	{
+		slice.clear();
+
 		for (uint32 y = 0; y < height; ++y)
 			for (uint32 x = 0; x < width; ++x)
 			{
 
 				if (components == 1)
 				{
-					Set(x, y, z, (float)(*data) / 255.0f);
+					slice.push_back(VoxelDelta{ uvec3(x, y, z), (float)(*data) / 255.0f });
 					data++;
 				}
 				else if (components == 2)
 				{
 					uint16* d = (uint16*)(data);
-					Set(x, y, z, (float)(*d) / 65535);
+					slice.push_back(VoxelDelta{ uvec3(x, y, z), (float)(*d) / 65535 });
 					data += 2;
 				}
 			}
 
+		ApplyDeltas(slice);
+	}
+	EndBulkLoad();
+
 
 	free(volume);
 	return true;
 }
 
+void IVoxelVolume::ApplyDeltas(const std::vector<VoxelDelta>& deltas)
+{
+	std::vector<VoxelDelta> batch;
+	PrepareDeltaBatch(deltas, batch);
+
+	for (const VoxelDelta& delta : batch)
+		Set(delta.coord.x, delta.coord.y, delta.coord.z, delta.value);
+}
+
+void IVoxelVolume::PrepareDeltaBatch(const std::vector<VoxelDelta>& deltas, std::vector<VoxelDelta>& outBatch)
+{
+	// Sort by Morton code, using the original index to keep duplicates in the order they were made
+	std::vector<std::pair<uint64, uint32>> keys(deltas.size());
+	for (uint32 i = 0; i < deltas.size(); ++i)
+		keys[i] = std::make_pair(MortonEncode(deltas[i].coord), i);
+
+	std::sort(keys.begin(), keys.end());
+
+
+	// Only keep the last change to each voxel
+	outBatch.clear();
+	outBatch.reserve(keys.size());
+
+	for (uint32 i = 0; i < keys.size(); ++i)
+		if (i + 1 == keys.size() || keys[i + 1].first != keys[i].first)
+			outBatch.emplace_back(deltas[keys[i].second]);
+}
+
 bool IVoxelVolume::Raycast(const Ray& ray, VoxelHitInfo& hit, float maxDistance)
 {
 	// Source: https://gist.github.com/yamamushi/5823518
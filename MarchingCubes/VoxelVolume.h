@@ -1,6 +1,7 @@
 #pragma once
 #include "Common.h"
 #include "Ray.h"
+#include "VertexCache.h"
 #include <vector>
 #include <ctime>
 
@@ -28,6 +29,7 @@ struct VoxelDelta
 
 /**
 * Results for when trying to build multiple LODs
+* (All times are measured in microseconds)
 */
 struct VoxelBuildResults 
 {
@@ -35,6 +37,7 @@ struct VoxelBuildResults
 	int64 totalTime;
 	std::vector<int64> buildTime;
 	std::vector<uint32> tricount;
+	VertexCacheStats vertexCache; // Only filled in when the volume optimises its meshes for the vertex cache
 
 	inline void clear()
 	{
@@ -42,6 +45,7 @@ struct VoxelBuildResults
 		totalTime = 0;
 		buildTime.clear();
 		tricount.clear();
+		vertexCache = VertexCacheStats();
 	}
 };
 
@@ -110,6 +114,23 @@ public:
 	*/
 	virtual VoxelBuildResults Rebuild(const std::vector<VoxelDelta>& deltas, VoxelBuildResults* recreation) = 0;
 
+	/**
+	* Apply a batch of changes to the volume (Without rebuilding the mesh)
+	* Duplicate coordinates are dropped, so only the last change to each voxel is applied
+	* @param deltas				All the changes to apply
+	*/
+	virtual void ApplyDeltas(const std::vector<VoxelDelta>& deltas);
+
+	/**
+	* Notify the volume that a large number of changes are about to be made (e.g. loading a file or scene)
+	* Volumes may defer any work they would do per change until EndBulkLoad is called
+	*/
+	virtual void BeginBulkLoad() {}
+	/**
+	* Notify the volume that the changes started by BeginBulkLoad have all been made
+	*/
+	virtual void EndBulkLoad() {}
+
 
 	/**
 	* Set the value of a specific voxel
@@ -157,4 +178,12 @@ public:
 	* @param file				The URL of the file to load
 	*/
 	virtual bool LoadFromPvmFile(const char* file);
+
+protected:
+	/**
+	* Sort a batch of changes into Morton order, dropping any duplicate coordinates (The last change to each voxel wins)
+	* @param deltas				The changes in the order they were made
+	* @param outBatch			Where to store the sorted changes
+	*/
+	static void PrepareDeltaBatch(const std::vector<VoxelDelta>& deltas, std::vector<VoxelDelta>& outBatch);
 };